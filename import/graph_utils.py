@@ -30,10 +30,12 @@ def haversine_distance(latitude1, longitude1, latitude2, longitude2):
     
     return earth_radius_meters * c
 
-def center_and_convert_coordinates(coordinates):
+def find_center(coordinates):
     longitudes, latitudes = zip(*coordinates)
-    center_longitude = (min(longitudes) + max(longitudes)) / 2
-    center_latitude = (min(latitudes) + max(latitudes)) / 2
+    return (min(longitudes) + max(longitudes)) / 2, (min(latitudes) + max(latitudes)) / 2
+
+def center_and_convert_coordinates(coordinates, center=None):
+    center_longitude, center_latitude = center if center else find_center(coordinates)
     
     centered_coords = [(longitude - center_longitude, latitude - center_latitude) for longitude, latitude in coordinates]
     
@@ -49,7 +51,8 @@ def extract_and_save_graph_data(nodes_json, edges_json):
     node_id_mapping = {}
     coordinates = [node['geometry']['coordinates'] for node in nodes_json['features']]
     
-    meter_coords = center_and_convert_coordinates(coordinates)
+    center = find_center(coordinates)
+    meter_coords = center_and_convert_coordinates(coordinates, center)
     
     avg_speeds = defaultdict(list)
     
@@ -129,6 +132,13 @@ def extract_and_save_graph_data(nodes_json, edges_json):
 
             oneway = 1 if str(properties.get('oneway', 'Unknown')).lower() == "true" else 0
 
-            edges_file.write(f"{new_node1_id} {new_node2_id} {length} {maxspeed} {lanes} {oneway}\n")
+            # Points of the road between its end nodes, so curves are drawn as curves
+            shape = ""
+            geometry = edge.get('geometry')
+            if geometry and geometry['type'] == 'LineString' and len(geometry['coordinates']) > 2:
+                shape_coords = center_and_convert_coordinates(geometry['coordinates'][1:-1], center)
+                shape = "".join(f" {x:.6f} {y:.6f}" for x, y in shape_coords)
+
+            edges_file.write(f"{new_node1_id} {new_node2_id} {length} {maxspeed} {lanes} {oneway}{shape}\n")
 
     return avg_speeds
\ No newline at end of file
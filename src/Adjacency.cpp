@@ -0,0 +1,164 @@
+#include "Adjacency.h"
+#include "RoadGraph.h"
+#include <algorithm>
+
+namespace {
+    bool isListed(const Road& road) {
+        return road.from >= 0 && road.to >= 0;
+    }
+
+    // The node a road is listed at and the node it leads to, travelled forwards or backwards
+    int getKey(const Road& road, Adjacency::Direction direction, bool backwards) {
+        return (direction == Adjacency::Outgoing) != backwards ? road.from : road.to;
+    }
+
+    int getTarget(const Road& road, Adjacency::Direction direction, bool backwards) {
+        return (direction == Adjacency::Outgoing) != backwards ? road.to : road.from;
+    }
+}
+
+/* METHODS */
+void Adjacency::build(const Column<Road>& roads, size_t nodeCount, Direction direction) {
+    this->direction = direction;
+
+    // Roads may reference ids past the last node, e.g. while a graph is edited
+    for (const Road& road : roads) {
+        if (isListed(road)) {
+            nodeCount = std::max(nodeCount, static_cast<size_t>(std::max(road.from, road.to)) + 1);
+        }
+    }
+
+    // Counting sort by key node: count, prefix sum, then scatter in id order
+    offsets.assign(nodeCount + 1, 0);
+    for (const Road& road : roads) {
+        if (isListed(road)) {
+            ++offsets[getKey(road, direction, false) + 1];
+            if (road.twoWay) {
+                ++offsets[getKey(road, direction, true) + 1];
+            }
+        }
+    }
+    for (size_t node = 0; node < nodeCount; ++node) {
+        offsets[node + 1] += offsets[node];
+    }
+
+    edgeCount = offsets[nodeCount];
+    ends.assign(offsets.begin() + 1, offsets.end());
+    targets.resize(edgeCount);
+    roadIds.resize(edgeCount);
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t id = 0; id < roads.size(); ++id) {
+        const Road& road = roads[id];
+        if (!isListed(road)) {
+            continue;
+        }
+        for (int pass = 0; pass < (road.twoWay ? 2 : 1); ++pass) {
+            uint32_t slot = cursor[getKey(road, direction, pass == 1)]++;
+            targets[slot] = getTarget(road, direction, pass == 1);
+            roadIds[slot] = static_cast<int>(id);
+        }
+    }
+
+    // Scattering kept road id order, so a stable insertion sort by target leaves
+    // parallel roads in id order; degrees are small enough for it to win
+    for (size_t node = 0; node < nodeCount; ++node) {
+        for (uint32_t i = offsets[node] + 1; i < offsets[node + 1]; ++i) {
+            int target = targets[i];
+            int road = roadIds[i];
+            uint32_t j = i;
+            for (; j > offsets[node] && targets[j - 1] > target; --j) {
+                targets[j] = targets[j - 1];
+                roadIds[j] = roadIds[j - 1];
+            }
+            targets[j] = target;
+            roadIds[j] = road;
+        }
+    }
+}
+
+void Adjacency::remove(const Road& road, int id) {
+    if (!isListed(road)) {
+        return;
+    }
+    for (int pass = 0; pass < (road.twoWay ? 2 : 1); ++pass) {
+        int node = getKey(road, direction, pass == 1);
+        if (static_cast<size_t>(node) >= getNodeCount()) {
+            continue;
+        }
+        int target = getTarget(road, direction, pass == 1);
+        for (uint32_t i = offsets[node]; i < ends[node]; ++i) {
+            if (targets[i] == target && roadIds[i] == id) {
+                std::copy(targets.begin() + i + 1, targets.begin() + ends[node], targets.begin() + i);
+                std::copy(roadIds.begin() + i + 1, roadIds.begin() + ends[node], roadIds.begin() + i);
+                --ends[node];
+                --edgeCount;
+                break;
+            }
+        }
+    }
+}
+
+bool Adjacency::add(const Road& road, int id) {
+    if (!isListed(road)) {
+        return true;
+    }
+
+    // A two-way loop needs two entries at its node
+    int key = getKey(road, direction, false);
+    int otherKey = getKey(road, direction, true);
+    auto hasRoom = [this](int node, uint32_t count) {
+        return static_cast<size_t>(node) < getNodeCount() && offsets[node + 1] - ends[node] >= count;
+    };
+    bool fits = road.twoWay && key == otherKey ? hasRoom(key, 2) : hasRoom(key, 1) && (!road.twoWay || hasRoom(otherKey, 1));
+    if (!fits) {
+        return false;
+    }
+
+    // Keeps the node's roads sorted by target, parallel roads by id
+    for (int pass = 0; pass < (road.twoWay ? 2 : 1); ++pass) {
+        int node = getKey(road, direction, pass == 1);
+        int target = getTarget(road, direction, pass == 1);
+        uint32_t slot = ends[node];
+        for (; slot > offsets[node] && (targets[slot - 1] > target || (targets[slot - 1] == target && roadIds[slot - 1] > id)); --slot) {
+            targets[slot] = targets[slot - 1];
+            roadIds[slot] = roadIds[slot - 1];
+        }
+        targets[slot] = target;
+        roadIds[slot] = id;
+        ++ends[node];
+        ++edgeCount;
+    }
+    return true;
+}
+
+void Adjacency::addNodes(size_t nodeCount) {
+    if (offsets.empty() || nodeCount <= getNodeCount()) {
+        return;
+    }
+    offsets.resize(nodeCount + 1, offsets.back());
+    ends.resize(nodeCount, offsets.back());
+}
+
+Adjacency::Range Adjacency::getNeighbors(int node) const {
+    if (node < 0 || static_cast<size_t>(node) >= getNodeCount()) {
+        return Range(Iterator(nullptr, nullptr), Iterator(nullptr, nullptr), 0);
+    }
+    uint32_t first = offsets[node];
+    uint32_t last = ends[node];
+    return Range(Iterator(targets.data() + first, roadIds.data() + first),
+                 Iterator(targets.data() + last, roadIds.data() + last), last - first);
+}
+
+int Adjacency::findRoad(int node, int target) const {
+    if (node < 0 || static_cast<size_t>(node) >= getNodeCount()) {
+        return -1;
+    }
+    const int* first = targets.data() + offsets[node];
+    const int* last = targets.data() + ends[node];
+    const int* it = std::lower_bound(first, last, target);
+    return it != last && *it == target ? roadIds[it - targets.data()] : -1;
+}
+
+size_t Adjacency::memoryUsage() const {
+    return (offsets.capacity() + ends.capacity()) * sizeof(uint32_t) + targets.capacity() * sizeof(int) + roadIds.capacity() * sizeof(int);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Column.h"
+
+struct Road;
+
+// Compressed sparse row adjacency. The roads of node n are the entries
+// offsets[n] .. ends[n] of two parallel arrays holding the node at each
+// road's other end and the road id, so scanning a node's neighbors reads
+// contiguous memory.
+class Adjacency {
+public:
+    struct Edge {
+        int target;
+        int road;
+    };
+
+    class Iterator {
+    public:
+        Iterator(const int* target, const int* road): target(target), road(road) {}
+
+        Edge operator*() const { return {*target, *road}; }
+        Iterator& operator++() {
+            ++target;
+            ++road;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return target == other.target; }
+        bool operator!=(const Iterator& other) const { return target != other.target; }
+
+    private:
+        const int* target;
+        const int* road;
+    };
+
+    class Range {
+    public:
+        Range(Iterator first, Iterator last, size_t count): first(first), last(last), count(count) {}
+
+        Iterator begin() const { return first; }
+        Iterator end() const { return last; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+    private:
+        Iterator first;
+        Iterator last;
+        size_t count;
+    };
+
+    // Outgoing lists the roads leaving each node with their end nodes, Incoming
+    // the roads arriving at each node with their start nodes. Two-way roads are
+    // listed at both of their ends in either direction.
+    enum Direction {
+        Outgoing,
+        Incoming,
+    };
+
+    // Roads with a negative end are holes in the id range and are skipped.
+    // Each node's roads are sorted by target, parallel roads by id.
+    void build(const Column<Road>& roads, size_t nodeCount, Direction direction = Outgoing);
+
+    // Patch a built index for an edited road. Removing leaves room at the
+    // road's nodes, which adding takes; adding fails where a node has no
+    // room or lies past the index, and the index then has to be rebuilt.
+    void remove(const Road& road, int id);
+    bool add(const Road& road, int id);
+    // Gives nodes added past the end of a built index empty lists
+    void addNodes(size_t nodeCount);
+
+    // Empty for ids outside the graph
+    Range getNeighbors(int node) const;
+    // Binary search for the lowest id road between the nodes; -1 if there is none
+    int findRoad(int node, int target) const;
+
+    size_t getNodeCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t getEdgeCount() const { return edgeCount; }
+    size_t memoryUsage() const;
+
+private:
+    Direction direction = Outgoing;
+    // A node's roads start at its offset and end at its end, which removals
+    // move below the next node's offset
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> ends;
+    size_t edgeCount = 0;
+    std::vector<int> targets;
+    std::vector<int> roadIds;
+};
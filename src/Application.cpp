@@ -12,12 +12,60 @@ Application::Application()
 
     renderer = std::make_unique<Renderer>();
 
-    roadGraph = std::make_unique<RoadGraph>(
-        config.getValue<std::string>("nodesFile", "data/nodes.txt"),
-        config.getValue<std::string>("edgesFile", "data/edges.txt")
-    );
+    // Placeholder view until the first batch of the graph arrives
+    camera = std::make_unique<Camera>(glm::vec3(0.0f), 1.0f, aspectRatio, fov);
 
-    camera = std::make_unique<Camera>(roadGraph->getCenter(), roadGraph->getRadius(), aspectRatio, fov);
+    startGraphLoader();
+}
+
+void Application::startGraphLoader() {
+    Configuration& config = Configuration::getInstance();
+
+    // Tiled graphs are paged in around the view instead of being loaded
+    if (config.hasValue("tiledGraphFile")) {
+        openGraphTiles(config.getValue<std::string>("tiledGraphFile", "data/graph.tiles.rgraph"));
+        return;
+    }
+
+    std::string graphFile;
+    if (config.hasValue("graphFile")) {
+        graphFile = config.getValue<std::string>("graphFile", "data/graph.rgraph");
+    }
+    std::string nodesFile = config.getValue<std::string>("nodesFile", "data/nodes.txt");
+    std::string edgesFile = config.getValue<std::string>("edgesFile", "data/edges.txt");
+    bool useGraphCache = config.getValue<bool>("graphCache", true);
+
+    graphLoader = std::make_unique<GraphLoader>([=](const RoadGraph::BatchCallback& onBatch) {
+        std::unique_ptr<RoadGraph> graph;
+        if (!graphFile.empty()) {
+            graph = GraphArchive::isGraphArchive(graphFile) ? GraphArchive::read(graphFile) : std::make_unique<RoadGraph>(graphFile);
+            if (graph) {
+                graph->splitIntoBatches(onBatch);
+            }
+        } else if (useGraphCache) {
+            graph = GraphCache::load(nodesFile, edgesFile, onBatch);
+        } else {
+            graph = std::make_unique<RoadGraph>(nodesFile, edgesFile, onBatch);
+        }
+        return graph;
+    });
+}
+
+void Application::openGraphTiles(const std::string& filename) {
+    Configuration& config = Configuration::getInstance();
+    size_t memoryBudget = static_cast<size_t>(std::max(config.getValue<int>("tileMemoryBudget", 256), 1)) << 20;
+    tileViewMargin = config.getValue<float>("tileViewMargin", 0.25f);
+
+    graphTiles = std::make_unique<GraphTiles>(filename, memoryBudget);
+    if (!graphTiles->isValid()) {
+        std::cerr << "No graph data was loaded" << std::endl;
+        graphTiles.reset();
+        return;
+    }
+
+    std::cout << "Opened " << filename << " with " << graphTiles->getTileCount() << " tiles" << std::endl;
+    fitCamera(graphTiles->getCenter(), graphTiles->getRadius());
+    cameraFitted = true;
 }
 
 void Application::loadConfig() {
@@ -59,6 +107,8 @@ Application::~Application() {
         glfwDestroyWindow(window);
     }
     
+    graphLoader.reset();
+    graphTiles.reset();
     renderer.reset();
     camera.reset();
     roadGraph.reset();
@@ -79,15 +129,30 @@ void Application::run()
 {
     printInstructions();
 
-    std::vector<float> nodesVertices = getNodesBuffer(roadGraph->getNodes());
-    std::vector<float> edgesVertices = getEdgesBuffer(roadGraph->getRoads());
-
-    unsigned int nodesBufferIndex = renderer->createBuffer(nodesVertices, GL_POINTS, nodeSize, false, glm::vec3(0.0f, 0.0f, 0.0f));
-    unsigned int edgesBufferIndex = renderer->createBuffer(edgesVertices, GL_LINES, edgeSize, true);
+    // Buffers start empty and are filled as the loader hands over batches
+    nodesBufferIndex = renderer->createBuffer({}, GL_POINTS, nodeSize, false, glm::vec3(0.0f, 0.0f, 0.0f));
+    edgesBufferIndex = renderer->createBuffer({}, GL_LINES, edgeSize, true);
 
     while (!glfwWindowShouldClose(window)) {
+        if (graphLoader) {
+            graphLoader->poll(
+                [this](GraphBatch&& batch) { onGraphBatch(std::move(batch)); },
+                [this](std::unique_ptr<RoadGraph> graph) { onGraphLoaded(std::move(graph)); }
+            );
+            if (!graphLoader->isLoading()) {
+                graphLoader.reset();
+            }
+        }
+
+        if (roadGraph && roadGraph->hasChanges()) {
+            syncGraphGeometry();
+        }
+
         handleInput();
         updateCamera();
+        if (graphTiles) {
+            updateGraphTiles();
+        }
 
         renderer->render();
 
@@ -98,37 +163,106 @@ void Application::run()
 
 
 /* PRIVATE METHODS */
-std::vector<float> Application::getNodesBuffer(const std::unordered_map<int, Node>& nodes) {
-    std::vector<float> vertices;
-    for (const auto& nodePair : nodes) {
-        Node node = nodePair.second;
+void Application::onGraphBatch(GraphBatch&& batch) {
+    renderer->appendBufferData(nodesBufferIndex, getNodesBuffer(batch.nodePositions));
+    renderer->appendBufferData(edgesBufferIndex, getEdgesBuffer(batch.roadSegments));
+
+    // Frame the first data that arrives so the map is visible while it fills in
+    if (!cameraFitted && !batch.nodePositions.empty()) {
+        glm::vec3 minCoords = batch.nodePositions.front();
+        glm::vec3 maxCoords = batch.nodePositions.front();
+        for (const glm::vec3& position : batch.nodePositions) {
+            minCoords = glm::min(minCoords, position);
+            maxCoords = glm::max(maxCoords, position);
+        }
+
+        glm::vec3 center = (minCoords + maxCoords) / 2.0f;
+        fitCamera(center, glm::distance(center, maxCoords));
+        cameraFitted = true;
+    }
+}
 
-        vertices.push_back(node.position.x);
-        vertices.push_back(node.position.y);
-        vertices.push_back(node.position.z);
+void Application::onGraphLoaded(std::unique_ptr<RoadGraph> graph) {
+    if (!graph || graph->getNodes().empty()) {
+        std::cerr << "No graph data was loaded" << std::endl;
+        return;
     }
 
-    return vertices;
+    roadGraph = std::move(graph);
+    graphGeometryBuilt = false;
+    fitCamera(roadGraph->getCenter(), roadGraph->getRadius());
+    cameraFitted = true;
 }
 
-std::vector<float> Application::getEdgesBuffer(const std::unordered_map<int, Road>& roads) {
-    std::vector<float> vertices;
-    for (const auto& roadPair : roads) {
-        Road road = roadPair.second;
+void Application::syncGraphGeometry() {
+    std::vector<DirtyRanges::Range> nodeRanges, roadRanges;
+    roadGraph->takeChanges(nodeRanges, roadRanges);
+
+    // Batches arrive in loader order, so the buffers are laid out by id once,
+    // and again whenever moved roads have left too many gaps behind
+    if (!graphGeometryBuilt || graphGeometry.needsCompaction()) {
+        std::vector<glm::vec3> nodePositions, roadSegments;
+        graphGeometry.build(*roadGraph, nodePositions, roadSegments);
+        renderer->setBufferData(nodesBufferIndex, getNodesBuffer(nodePositions));
+        renderer->setBufferData(edgesBufferIndex, getEdgesBuffer(roadSegments));
+        graphGeometryBuilt = true;
+        return;
+    }
 
-        glm::vec3 positionFrom = roadGraph->getNodePosition(road.from);
-        glm::vec3 positionTo = roadGraph->getNodePosition(road.to);
+    std::vector<GraphGeometry::Update> nodeUpdates, roadUpdates;
+    graphGeometry.update(*roadGraph, nodeRanges, roadRanges, nodeUpdates, roadUpdates);
+    for (const GraphGeometry::Update& update : nodeUpdates) {
+        renderer->updateBufferData(nodesBufferIndex, update.firstVertex, getNodesBuffer(update.positions));
+    }
+    for (const GraphGeometry::Update& update : roadUpdates) {
+        renderer->updateBufferData(edgesBufferIndex, update.firstVertex, getEdgesBuffer(update.positions));
+    }
+    renderer->setVertexCount(nodesBufferIndex, graphGeometry.getNodeVertexCount());
+}
 
-        vertices.push_back(positionFrom.x); 
-        vertices.push_back(positionFrom.y); 
-        vertices.push_back(positionFrom.z); 
-        vertices.push_back(defaultRoadColor.r);
-        vertices.push_back(defaultRoadColor.g);
-        vertices.push_back(defaultRoadColor.b);
+void Application::updateGraphTiles() {
+    glm::vec2 minCoords, maxCoords;
+    camera->getGroundBounds(graphTiles->getCenter().z, minCoords, maxCoords);
+    glm::vec4 view(minCoords, maxCoords);
+    if (view == tileView) {
+        return;
+    }
+    tileView = view;
+
+    glm::vec2 margin = (maxCoords - minCoords) * tileViewMargin;
+    if (!graphTiles->update(minCoords - margin, maxCoords + margin)) {
+        return;
+    }
+
+    GraphBatch batch;
+    graphTiles->buildBatch(batch);
+    renderer->setBufferData(nodesBufferIndex, getNodesBuffer(batch.nodePositions));
+    renderer->setBufferData(edgesBufferIndex, getEdgesBuffer(batch.roadSegments));
+}
+
+void Application::fitCamera(glm::vec3 center, float radius) {
+    camera = std::make_unique<Camera>(center, std::max(radius, 1.0f), aspectRatio, fov);
+}
+
+std::vector<float> Application::getNodesBuffer(const std::vector<glm::vec3>& positions) {
+    std::vector<float> vertices;
+    vertices.reserve(positions.size() * 3);
+    for (const glm::vec3& position : positions) {
+        vertices.push_back(position.x);
+        vertices.push_back(position.y);
+        vertices.push_back(position.z);
+    }
 
-        vertices.push_back(positionTo.x); 
-        vertices.push_back(positionTo.y); 
-        vertices.push_back(positionTo.z);
+    return vertices;
+}
+
+std::vector<float> Application::getEdgesBuffer(const std::vector<glm::vec3>& segments) {
+    std::vector<float> vertices;
+    vertices.reserve(segments.size() * 6);
+    for (const glm::vec3& position : segments) {
+        vertices.push_back(position.x);
+        vertices.push_back(position.y);
+        vertices.push_back(position.z);
         vertices.push_back(defaultRoadColor.r);
         vertices.push_back(defaultRoadColor.g);
         vertices.push_back(defaultRoadColor.b);
@@ -10,6 +10,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "RoadGraph.h"
+#include "GraphArchive.h"
+#include "GraphCache.h"
+#include "GraphGeometry.h"
+#include "GraphLoader.h"
+#include "GraphTiles.h"
 #include "Camera.h"
 #include "Renderer.h"
 #include "Configuration.h"
@@ -31,6 +36,17 @@ private:
     std::unique_ptr<RoadGraph> roadGraph;
     std::unique_ptr<Camera> camera;
     std::unique_ptr<Renderer> renderer;
+    std::unique_ptr<GraphLoader> graphLoader;
+    std::unique_ptr<GraphTiles> graphTiles;
+    // Layout of the loaded graph in the buffers, made on its first edit
+    GraphGeometry graphGeometry;
+    bool graphGeometryBuilt = false;
+
+    unsigned int nodesBufferIndex;
+    unsigned int edgesBufferIndex;
+    bool cameraFitted = false;
+    float tileViewMargin;
+    glm::vec4 tileView = glm::vec4(0.0f);
 
     int windowWidth, windowHeight;
     std::string windowTitle;
@@ -46,9 +62,16 @@ private:
 private:
     void loadConfig();
     void setupWindow();
+    void startGraphLoader();
+    void openGraphTiles(const std::string& filename);
+    void updateGraphTiles();
+    void onGraphBatch(GraphBatch&& batch);
+    void onGraphLoaded(std::unique_ptr<RoadGraph> graph);
+    void syncGraphGeometry();
+    void fitCamera(glm::vec3 center, float radius);
 
     void handleInput();
     void updateCamera();
-    std::vector<float> getNodesBuffer(const std::unordered_map<int, Node>& nodes);
-    std::vector<float> getEdgesBuffer(const std::unordered_map<int, Road>& roads);
+    std::vector<float> getNodesBuffer(const std::vector<glm::vec3>& positions);
+    std::vector<float> getEdgesBuffer(const std::vector<glm::vec3>& segments);
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "BidirectionalAStar.h"
+#include "Landmarks.h"
+#include "RoadGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Keeps rounding in the distances from lifting a bound above a road's travel time
+    const double boundMargin = 1.0 - 1e-7;
+
+    glm::dvec2 getGroundPosition(const RoadGraph& graph, int node) {
+        const glm::vec3& position = graph.getNodePositionUnchecked(node);
+        return glm::dvec2(position.x, position.y);
+    }
+}
+
+/* CONSTRUCTORS */
+BidirectionalAStar::BidirectionalAStar(const RoadGraph& graph): graph(graph) {
+    // The straight line between a road's ends is never longer than the road,
+    // so no route covers straight-line distance faster than the fastest road
+    const RoadColumns& columns = graph.getRoadColumns();
+    const Column<Road>& roads = graph.getRoads();
+    double lowest = std::numeric_limits<double>::infinity();
+    for (size_t id = 0; id < roads.size(); ++id) {
+        const Road& road = roads[id];
+        uint32_t travelTime = columns.getTravelTime(static_cast<int>(id));
+        if (travelTime == RoadColumns::unreachable || !graph.nodeExists(road.from) || !graph.nodeExists(road.to)) {
+            continue;
+        }
+        double meters = glm::distance(getGroundPosition(graph, road.from), getGroundPosition(graph, road.to));
+        if (meters > 0.0) {
+            lowest = std::min(lowest, travelTime / meters);
+        }
+    }
+    millisecondsPerMeter = std::isinf(lowest) ? 0.0 : lowest * boundMargin;
+}
+
+/* METHODS */
+bool BidirectionalAStar::findRoute(int from, int to, Route& route) {
+    route.clear();
+    if (!graph.nodeExists(from) || !graph.nodeExists(to)) {
+        return false;
+    }
+
+    const Adjacency& outgoing = graph.getAdjacency();
+    const Adjacency& incoming = graph.getReverseAdjacency();
+    const uint32_t* travelTimes = graph.getRoadColumns().getTravelTimes().data();
+    sourceNode = from;
+    targetNode = to;
+    source = getGroundPosition(graph, from);
+    target = getGroundPosition(graph, to);
+
+    // Nodes added since the indexes were built lie past their ends
+    size_t nodeCount = std::max({graph.getNodes().size(), outgoing.getNodeCount(), incoming.getNodeCount()});
+    if (static_cast<size_t>(from) >= nodeCount || static_cast<size_t>(to) >= nodeCount) {
+        return false;
+    }
+    forward.reset(nodeCount);
+    backward.reset(nodeCount);
+
+    // Keys are doubled distances plus the difference of the two bounds, which
+    // is twice the averaged potential and stays whole. A node's bound from its
+    // own search's start never exceeds its distance, so keys are not negative.
+    auto getForwardKey = [this](int node, uint32_t distance) {
+        return static_cast<uint32_t>(2 * static_cast<int64_t>(distance) + getBoundToTarget(node) - getBoundFromSource(node));
+    };
+    auto getBackwardKey = [this](int node, uint32_t distance) {
+        return static_cast<uint32_t>(2 * static_cast<int64_t>(distance) + getBoundFromSource(node) - getBoundToTarget(node));
+    };
+
+    uint32_t best = from == to ? 0 : RoadColumns::unreachable;
+    int meeting = from == to ? from : -1;
+    forward.relax(from, 0, getForwardKey(from, 0), -1, -1);
+    backward.relax(to, 0, getBackwardKey(to, 0), -1, -1);
+
+    auto step = [&](SearchSpace& space, const SearchSpace& other, const Adjacency& adjacency, auto getKey) {
+        int node = space.settleMin();
+        uint32_t distance = space.getDistance(node);
+        for (const Adjacency::Edge& edge : adjacency.getNeighbors(node)) {
+            uint32_t travelTime = travelTimes[edge.road];
+            if (travelTime == RoadColumns::unreachable) {
+                continue;
+            }
+
+            // Bounds are only worked out for nodes the road gets to sooner. Both
+            // sides look at the other whenever they improve a node, so every
+            // pair of distances meeting there is seen.
+            uint32_t reached = distance + travelTime;
+            if (reached >= space.getDistance(edge.target) || !space.relax(edge.target, reached, getKey(edge.target, reached), node, edge.road)) {
+                continue;
+            }
+            if (other.isReached(edge.target) && static_cast<uint64_t>(reached) + other.getDistance(edge.target) < best) {
+                best = reached + other.getDistance(edge.target);
+                meeting = edge.target;
+            }
+        }
+    };
+
+    // The keys of two consistent searches add up to at most twice the length
+    // of any route through nodes neither has settled
+    while (!forward.empty() && !backward.empty()) {
+        uint64_t forwardKey = forward.getMinKey();
+        uint64_t backwardKey = backward.getMinKey();
+        if (best != RoadColumns::unreachable && forwardKey + backwardKey >= 2 * static_cast<uint64_t>(best)) {
+            break;
+        }
+
+        if (forwardKey <= backwardKey) {
+            step(forward, backward, outgoing, getForwardKey);
+        } else {
+            step(backward, forward, incoming, getBackwardKey);
+        }
+    }
+
+    route.settledNodes = forward.getSettledCount() + backward.getSettledCount();
+    if (meeting < 0) {
+        return false;
+    }
+
+    // Forward half as it was searched, then the backward half turned around
+    forward.getPath(meeting, route.nodes, route.roads);
+    backward.getPath(meeting, pathNodes, pathRoads);
+    route.nodes.insert(route.nodes.end(), pathNodes.rbegin() + 1, pathNodes.rend());
+    route.roads.insert(route.roads.end(), pathRoads.rbegin(), pathRoads.rend());
+    route.travelTime = forward.getDistance(meeting) + backward.getDistance(meeting);
+    return true;
+}
+
+void BidirectionalAStar::setLandmarks(const Landmarks* value) {
+    landmarks = value && !value->empty() && value->getNodeCount() == graph.getNodes().size() ? value : nullptr;
+}
+
+uint32_t BidirectionalAStar::getBoundToTarget(int node) const {
+    uint32_t bound = getStraightLineBound(node, target);
+    if (landmarks && static_cast<size_t>(std::max(node, targetNode)) < landmarks->getNodeCount()) {
+        bound = std::max(bound, landmarks->getLowerBound(node, targetNode));
+    }
+    return bound;
+}
+
+uint32_t BidirectionalAStar::getBoundFromSource(int node) const {
+    uint32_t bound = getStraightLineBound(node, source);
+    if (landmarks && static_cast<size_t>(std::max(node, sourceNode)) < landmarks->getNodeCount()) {
+        bound = std::max(bound, landmarks->getLowerBound(sourceNode, node));
+    }
+    return bound;
+}
+
+uint32_t BidirectionalAStar::getStraightLineBound(int node, const glm::dvec2& point) const {
+    // Roads may lead to ids without a position while a graph is edited
+    if (static_cast<size_t>(node) >= graph.getNodes().size()) {
+        return 0;
+    }
+    double bound = std::floor(millisecondsPerMeter * glm::distance(getGroundPosition(graph, node), point));
+    return bound > 0.0 ? static_cast<uint32_t>(std::min(bound, static_cast<double>(RoadColumns::unreachable - 1))) : 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Route.h"
+#include "SearchSpace.h"
+
+class Landmarks;
+class RoadGraph;
+
+// Fastest routes by travel time, searching from both ends at once and
+// steering each search towards the other end. The straight-line distance
+// between node positions times the network's lowest time per meter bounds the
+// travel time between them from below. Each side uses the average of the
+// bounds towards its target and away from its source, which keeps the two
+// searches consistent, so they can stop as soon as their queues' keys show
+// that no shorter route is left. Landmarks raise the bounds where straight
+// lines are loose, e.g. across slow areas. Keep one per thread, like Dijkstra.
+class BidirectionalAStar {
+public:
+    // Reads the lowest time per meter off the current roads, so make a new
+    // one after roads are edited
+    explicit BidirectionalAStar(const RoadGraph& graph);
+
+    // Returns false if to cannot be reached from from
+    bool findRoute(int from, int to, Route& route);
+    // Tightens the bounds with landmark travel times (ALT); null goes back to
+    // straight lines alone. Landmarks made for another node count are ignored.
+    void setLandmarks(const Landmarks* landmarks);
+
+    // Milliseconds per meter of straight-line distance no road beats
+    double getMillisecondsPerMeter() const { return millisecondsPerMeter; }
+
+private:
+    const RoadGraph& graph;
+    SearchSpace forward;
+    SearchSpace backward;
+    double millisecondsPerMeter = 0.0;
+
+    const Landmarks* landmarks = nullptr;
+
+    // End points of the current query and their positions
+    int sourceNode = -1;
+    int targetNode = -1;
+    glm::dvec2 source;
+    glm::dvec2 target;
+    // Backward half of the route, kept to reuse its capacity
+    std::vector<int> pathNodes;
+    std::vector<int> pathRoads;
+
+    // Lower bounds on the travel time from node to the target and from the source to node
+    uint32_t getBoundToTarget(int node) const;
+    uint32_t getBoundFromSource(int node) const;
+    uint32_t getStraightLineBound(int node, const glm::dvec2& point) const;
+};
@@ -1,5 +1,6 @@
 #include "Camera.h"
 #include <algorithm>
+#include <limits>
 
 #include <iostream>
 
@@ -44,6 +45,34 @@ glm::mat4 Camera::getProjectionMatrix() const {
     return projectionMatrix;
 }
 
+void Camera::getGroundBounds(float height, glm::vec2& minCoords, glm::vec2& maxCoords) const {
+    glm::mat4 inverse = glm::inverse(projectionMatrix * viewMatrix);
+    auto unproject = [&inverse](float x, float y, float z) {
+        glm::vec4 point = inverse * glm::vec4(x, y, z, 1.0f);
+        return glm::vec3(point) / point.w;
+    };
+
+    minCoords = glm::vec2(std::numeric_limits<float>::max());
+    maxCoords = glm::vec2(-std::numeric_limits<float>::max());
+    auto include = [&](const glm::vec3& point) {
+        minCoords = glm::min(minCoords, glm::vec2(point));
+        maxCoords = glm::max(maxCoords, glm::vec2(point));
+    };
+
+    // Each frustum edge is cut where it crosses the plane; edges that miss it
+    // contribute their far end, so a tilted view still covers the horizon
+    const float corners[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    for (const auto& corner : corners) {
+        glm::vec3 nearPoint = unproject(corner[0], corner[1], -1.0f);
+        glm::vec3 farPoint = unproject(corner[0], corner[1], 1.0f);
+        float t = 1.0f;
+        if (std::abs(farPoint.z - nearPoint.z) > 1e-6f) {
+            t = std::clamp((height - nearPoint.z) / (farPoint.z - nearPoint.z), 0.0f, 1.0f);
+        }
+        include(nearPoint + (farPoint - nearPoint) * t);
+    }
+}
+
 void Camera::setAspectRatio(float newAspectRatio) {
     aspectRatio = newAspectRatio;
     updateProjectionMatrix();
@@ -18,6 +18,9 @@ public:
     glm::mat4 getViewMatrix() const;
     glm::mat4 getProjectionMatrix() const;
 
+    // Bounds of the part of the plane z = height that lies inside the view frustum
+    void getGroundBounds(float height, glm::vec2& minCoords, glm::vec2& maxCoords) const;
+
     void setAspectRatio(float aspectRatio);
 
     void moveLeft(float speed);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Contiguous array that either owns its elements or borrows them from memory
+// owned elsewhere (typically a MappedFile). Borrowed data is copied into owned
+// storage the first time it is modified.
+template<typename T>
+class Column {
+public:
+    Column() = default;
+
+    void assign(std::vector<T> values);
+    void borrow(const T* data, size_t size);
+
+    const T* data() const { return borrowed ? borrowedData : owned.data(); }
+    size_t size() const { return borrowed ? borrowedSize : owned.size(); }
+    bool empty() const { return size() == 0; }
+    bool isBorrowed() const { return borrowed; }
+
+    const T& operator[](size_t index) const { return data()[index]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+
+    std::vector<T>& values();
+    size_t memoryUsage() const { return borrowed ? 0 : owned.capacity() * sizeof(T); }
+
+private:
+    std::vector<T> owned;
+    const T* borrowedData = nullptr;
+    size_t borrowedSize = 0;
+    bool borrowed = false;
+};
+
+template<typename T>
+void Column<T>::assign(std::vector<T> values) {
+    owned = std::move(values);
+    borrowedData = nullptr;
+    borrowedSize = 0;
+    borrowed = false;
+}
+
+template<typename T>
+void Column<T>::borrow(const T* data, size_t size) {
+    owned.clear();
+    owned.shrink_to_fit();
+    borrowedData = data;
+    borrowedSize = size;
+    borrowed = true;
+}
+
+template<typename T>
+std::vector<T>& Column<T>::values() {
+    if (borrowed) {
+        owned.assign(borrowedData, borrowedData + borrowedSize);
+        borrowedData = nullptr;
+        borrowedSize = 0;
+        borrowed = false;
+    }
+    return owned;
+}
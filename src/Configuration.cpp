@@ -12,6 +12,10 @@ void Configuration::setValue(const std::string& key, const std::string& value) {
     config[key] = value;
 }
 
+bool Configuration::hasValue(const std::string& key) const {
+    return config.find(key) != config.end();
+}
+
 void Configuration::loadFromFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
@@ -10,6 +10,7 @@ public:
     static Configuration& getInstance();
 
     void setValue(const std::string& key, const std::string& value);
+    bool hasValue(const std::string& key) const;
 
     template<typename T>
     T getValue(const std::string& key, const T& defaultValue) const;
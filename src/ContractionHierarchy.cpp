@@ -0,0 +1,319 @@
+#include "ContractionHierarchy.h"
+#include "Parallel.h"
+#include "RoadGraph.h"
+#include "SearchSpace.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace {
+    // Witness searches give up after this many nodes and keep the shortcut,
+    // which costs a little query time but never a wrong route. Estimating a
+    // priority only needs a rough count, so it searches less.
+    const size_t contractionSettleLimit = 500;
+    const size_t prioritySettleLimit = 100;
+
+    // One thread's scratch space for witness searches
+    struct WitnessSpace {
+        SearchSpace space;
+        // Nodes marked with the current mark are targets still to be settled
+        std::vector<uint32_t> targetMarks;
+        uint32_t mark = 0;
+        size_t settleLimit = 0;
+    };
+
+    struct DynamicEdge {
+        int node;
+        uint32_t weight;
+        int arc;
+    };
+
+    // The graph while it is being contracted. Each node keeps the edges to
+    // nodes not yet contracted; a contracted node's lists are final.
+    class Contraction {
+    public:
+        Contraction(const RoadGraph& graph, std::vector<ContractionHierarchy::Arc>& arcs): arcs(arcs) {
+            const Adjacency& adjacency = graph.getAdjacency();
+            const RoadColumns& columns = graph.getRoadColumns();
+            nodeCount = std::max(adjacency.getNodeCount(), graph.getNodes().size());
+            outgoing.resize(nodeCount);
+            incoming.resize(nodeCount);
+            contractedNeighbors.assign(nodeCount, 0);
+
+            // The fastest of parallel roads; self loops never help
+            for (size_t node = 0; node < adjacency.getNodeCount(); ++node) {
+                for (const Adjacency::Edge& edge : adjacency.getNeighbors(static_cast<int>(node))) {
+                    uint32_t travelTime = columns.getTravelTime(edge.road);
+                    if (edge.target != static_cast<int>(node) && travelTime != RoadColumns::unreachable) {
+                        addEdge(static_cast<int>(node), edge.target, travelTime, {edge.road, -1, -1});
+                    }
+                }
+            }
+        }
+
+        size_t getNodeCount() const { return nodeCount; }
+        const std::vector<DynamicEdge>& getOutgoing(int node) const { return outgoing[node]; }
+        const std::vector<DynamicEdge>& getIncoming(int node) const { return incoming[node]; }
+
+        // Reads only, so priorities can be computed on several threads
+        int getPriority(int node, WitnessSpace& space) const {
+            int shortcuts = 0;
+            space.settleLimit = prioritySettleLimit;
+            forEachShortcut(node, space, [&](int, int, uint32_t, int, int) { ++shortcuts; });
+            int edgeDifference = shortcuts - static_cast<int>(outgoing[node].size() + incoming[node].size());
+            return 2 * edgeDifference + contractedNeighbors[node];
+        }
+
+        // Removes node from its neighbors' lists, joining them with shortcuts
+        // where needed, and lists those neighbors, whose priorities changed
+        void contract(int node, WitnessSpace& space, std::vector<int>& neighbors) {
+            shortcuts.clear();
+            space.settleLimit = contractionSettleLimit;
+            forEachShortcut(node, space, [&](int from, int to, uint32_t weight, int in, int out) {
+                shortcuts.push_back({from, to, weight, in, out});
+            });
+
+            neighbors.clear();
+            for (const DynamicEdge& edge : incoming[node]) {
+                removeEdges(outgoing[edge.node], node);
+                neighbors.push_back(edge.node);
+            }
+            for (const DynamicEdge& edge : outgoing[node]) {
+                removeEdges(incoming[edge.node], node);
+                neighbors.push_back(edge.node);
+            }
+            for (const Shortcut& shortcut : shortcuts) {
+                addEdge(shortcut.from, shortcut.to, shortcut.weight, {shortcut.in, shortcut.out, node});
+            }
+
+            std::sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+            for (int neighbor : neighbors) {
+                ++contractedNeighbors[neighbor];
+            }
+        }
+
+    private:
+        struct Shortcut {
+            int from;
+            int to;
+            uint32_t weight;
+            int in;
+            int out;
+        };
+
+        std::vector<ContractionHierarchy::Arc>& arcs;
+        size_t nodeCount;
+        std::vector<std::vector<DynamicEdge>> outgoing;
+        std::vector<std::vector<DynamicEdge>> incoming;
+        std::vector<int> contractedNeighbors;
+        std::vector<Shortcut> shortcuts;
+
+        // Keeps only the faster of two edges between the same nodes
+        void addEdge(int from, int to, uint32_t weight, const ContractionHierarchy::Arc& arc) {
+            auto sameTarget = [to](const DynamicEdge& edge) { return edge.node == to; };
+            auto existing = std::find_if(outgoing[from].begin(), outgoing[from].end(), sameTarget);
+            if (existing != outgoing[from].end() && existing->weight <= weight) {
+                return;
+            }
+
+            int id = static_cast<int>(arcs.size());
+            arcs.push_back(arc);
+            if (existing == outgoing[from].end()) {
+                outgoing[from].push_back({to, weight, id});
+                incoming[to].push_back({from, weight, id});
+                return;
+            }
+            *existing = {to, weight, id};
+            for (DynamicEdge& edge : incoming[to]) {
+                if (edge.node == from) {
+                    edge = {from, weight, id};
+                }
+            }
+        }
+
+        static void removeEdges(std::vector<DynamicEdge>& edges, int node) {
+            edges.erase(std::remove_if(edges.begin(), edges.end(), [node](const DynamicEdge& edge) { return edge.node == node; }), edges.end());
+        }
+
+        // Calls shortcut(from, to, weight, inArc, outArc) for every pair of
+        // neighbors whose fastest connection runs through node
+        template<typename Callback>
+        void forEachShortcut(int node, WitnessSpace& witnesses, Callback&& shortcut) const {
+            if (witnesses.targetMarks.size() < nodeCount) {
+                witnesses.targetMarks.assign(nodeCount, 0);
+                witnesses.mark = 0;
+            }
+            for (const DynamicEdge& in : incoming[node]) {
+                if (++witnesses.mark == 0) {
+                    std::fill(witnesses.targetMarks.begin(), witnesses.targetMarks.end(), 0);
+                    witnesses.mark = 1;
+                }
+                size_t targetCount = 0;
+                uint64_t limit = 0;
+                for (const DynamicEdge& out : outgoing[node]) {
+                    if (out.node != in.node) {
+                        witnesses.targetMarks[out.node] = witnesses.mark;
+                        ++targetCount;
+                        limit = std::max(limit, static_cast<uint64_t>(in.weight) + out.weight);
+                    }
+                }
+                if (targetCount == 0) {
+                    continue;
+                }
+
+                searchWitnesses(in.node, node, limit, targetCount, witnesses);
+                const SearchSpace& space = witnesses.space;
+                for (const DynamicEdge& out : outgoing[node]) {
+                    uint64_t through = static_cast<uint64_t>(in.weight) + out.weight;
+                    if (out.node != in.node && through < RoadColumns::unreachable && space.getDistance(out.node) > through) {
+                        shortcut(in.node, out.node, static_cast<uint32_t>(through), in.arc, out.arc);
+                    }
+                }
+            }
+        }
+
+        // Limited search from source around skipped, done once every target
+        // is settled; every distance it finds is a real route, settled or not
+        void searchWitnesses(int source, int skipped, uint64_t limit, size_t targetCount, WitnessSpace& witnesses) const {
+            SearchSpace& space = witnesses.space;
+            space.reset(nodeCount);
+            space.relax(source, 0, 0, -1, -1);
+            while (!space.empty() && space.getMinKey() <= limit && space.getSettledCount() < witnesses.settleLimit) {
+                int node = space.settleMin();
+                if (witnesses.targetMarks[node] == witnesses.mark && --targetCount == 0) {
+                    return;
+                }
+                uint32_t distance = space.getDistance(node);
+                for (const DynamicEdge& edge : outgoing[node]) {
+                    uint64_t reached = static_cast<uint64_t>(distance) + edge.weight;
+                    if (edge.node != skipped && reached <= limit) {
+                        space.relax(edge.node, static_cast<uint32_t>(reached), static_cast<uint32_t>(reached), -1, -1);
+                    }
+                }
+            }
+        }
+    };
+
+    void buildEdges(const Contraction& contraction, bool upward, const std::vector<int>& arcIds,
+                    std::vector<uint32_t>& offsets, std::vector<ContractionHierarchy::Edge>& edges) {
+        size_t nodeCount = contraction.getNodeCount();
+        offsets.assign(nodeCount + 1, 0);
+        for (size_t node = 0; node < nodeCount; ++node) {
+            const auto& list = upward ? contraction.getOutgoing(static_cast<int>(node)) : contraction.getIncoming(static_cast<int>(node));
+            offsets[node + 1] = offsets[node] + static_cast<uint32_t>(list.size());
+        }
+        edges.resize(offsets.back());
+        for (size_t node = 0; node < nodeCount; ++node) {
+            const auto& list = upward ? contraction.getOutgoing(static_cast<int>(node)) : contraction.getIncoming(static_cast<int>(node));
+            ContractionHierarchy::Edge* edge = edges.data() + offsets[node];
+            for (const DynamicEdge& dynamicEdge : list) {
+                *edge++ = {dynamicEdge.node, dynamicEdge.weight, arcIds[dynamicEdge.arc]};
+            }
+        }
+    }
+}
+
+/* METHODS */
+void ContractionHierarchy::build(const RoadGraph& graph, size_t workerCount) {
+    std::vector<Arc> allArcs;
+    Contraction contraction(graph, allArcs);
+    size_t nodeCount = contraction.getNodeCount();
+    size_t originalArcCount = allArcs.size();
+
+    // First priorities in parallel, one search space per block of nodes
+    std::vector<int> priorities(nodeCount);
+    if (workerCount == 0) {
+        workerCount = getWorkerCount();
+    }
+    size_t blockCount = std::max<size_t>(std::min(workerCount * 4, nodeCount), 1);
+    parallelFor(blockCount, [&](size_t block) {
+        WitnessSpace space;
+        for (size_t node = block * nodeCount / blockCount; node < (block + 1) * nodeCount / blockCount; ++node) {
+            priorities[node] = contraction.getPriority(static_cast<int>(node), space);
+        }
+    }, workerCount);
+
+    using Entry = std::pair<int, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    for (size_t node = 0; node < nodeCount; ++node) {
+        queue.push({priorities[node], static_cast<int>(node)});
+    }
+
+    // A popped node is contracted only if its fresh priority still beats the
+    // next one; stale entries left behind by updates are skipped
+    WitnessSpace space;
+    std::vector<bool> contracted(nodeCount, false);
+    std::vector<int> neighbors;
+    while (!queue.empty()) {
+        Entry entry = queue.top();
+        queue.pop();
+        int node = entry.second;
+        if (contracted[node] || entry.first != priorities[node]) {
+            continue;
+        }
+
+        int priority = contraction.getPriority(node, space);
+        if (priority > priorities[node] && !queue.empty() && priority > queue.top().first) {
+            priorities[node] = priority;
+            queue.push({priority, node});
+            continue;
+        }
+
+        contraction.contract(node, space, neighbors);
+        contracted[node] = true;
+        for (int neighbor : neighbors) {
+            priorities[neighbor] = contraction.getPriority(neighbor, space);
+            queue.push({priorities[neighbor], neighbor});
+        }
+    }
+
+    // Drop arcs that faster ones replaced; shortcuts only ever join arcs that
+    // were still in place when their middle node was contracted
+    std::vector<int> arcIds(allArcs.size(), -1);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        for (const DynamicEdge& edge : contraction.getOutgoing(static_cast<int>(node))) {
+            arcIds[edge.arc] = 0;
+        }
+        for (const DynamicEdge& edge : contraction.getIncoming(static_cast<int>(node))) {
+            arcIds[edge.arc] = 0;
+        }
+    }
+    arcs.clear();
+    roadArcCount = 0;
+    for (size_t id = 0; id < allArcs.size(); ++id) {
+        if (arcIds[id] < 0) {
+            continue;
+        }
+        arcIds[id] = static_cast<int>(arcs.size());
+        Arc arc = allArcs[id];
+        if (arc.middle >= 0) {
+            arc.first = arcIds[arc.first];
+            arc.second = arcIds[arc.second];
+        }
+        arcs.push_back(arc);
+        roadArcCount += id < originalArcCount ? 1 : 0;
+    }
+
+    buildEdges(contraction, true, arcIds, offsets, upward);
+    buildEdges(contraction, false, arcIds, downwardOffsets, downward);
+}
+
+void ContractionHierarchy::assign(std::vector<uint32_t> upwardOffsets, std::vector<Edge> upwardEdges, std::vector<uint32_t> downwardEdgeOffsets,
+                                  std::vector<Edge> downwardEdges, std::vector<Arc> edgeArcs) {
+    offsets = std::move(upwardOffsets);
+    upward = std::move(upwardEdges);
+    downwardOffsets = std::move(downwardEdgeOffsets);
+    downward = std::move(downwardEdges);
+    arcs = std::move(edgeArcs);
+    roadArcCount = 0;
+    for (const Arc& arc : arcs) {
+        roadArcCount += arc.middle < 0 ? 1 : 0;
+    }
+}
+
+size_t ContractionHierarchy::memoryUsage() const {
+    return (offsets.capacity() + downwardOffsets.capacity()) * sizeof(uint32_t) + (upward.capacity() + downward.capacity()) * sizeof(Edge) +
+           arcs.capacity() * sizeof(Arc);
+}
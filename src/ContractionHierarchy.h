@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class RoadGraph;
+
+// Road network preprocessed for fast fastest-route queries. Nodes are
+// contracted one by one in order of importance: each contraction removes a
+// node and, where no witness route around it is as fast, joins its
+// neighbors with a shortcut edge through it. Every edge is then stored at
+// its less important end, upward edges in travel direction and downward
+// edges against it, so a query only ever searches upward from both ends.
+// Travel times are taken when building; build again after roads are edited.
+class ContractionHierarchy {
+public:
+    struct Edge {
+        // More important end of the edge
+        int target;
+        uint32_t weight;
+        int arc;
+    };
+
+    // What an edge stands for: a road, or two edges through a node that was
+    // contracted before either end
+    struct Arc {
+        // Road id when middle is -1, otherwise the arcs into and out of middle
+        int first;
+        int second;
+        int middle;
+    };
+
+    class Range {
+    public:
+        Range(const Edge* first, const Edge* last): first(first), last(last) {}
+
+        const Edge* begin() const { return first; }
+        const Edge* end() const { return last; }
+        size_t size() const { return last - first; }
+
+    private:
+        const Edge* first;
+        const Edge* last;
+    };
+
+    // Orders nodes by edge difference, the shortcuts a contraction adds less
+    // the edges it removes, plus how many neighbors went before them.
+    // Priorities are updated lazily and for the neighbors of each contracted
+    // node; the first round is spread over the workers.
+    void build(const RoadGraph& graph, size_t workerCount = 0);
+    // Takes over arrays made elsewhere, as customizing a
+    // CustomizableContractionHierarchy does; arcs without a middle node and
+    // with a negative road stand for nothing and must not be reached
+    void assign(std::vector<uint32_t> upwardOffsets, std::vector<Edge> upwardEdges, std::vector<uint32_t> downwardEdgeOffsets,
+                std::vector<Edge> downwardEdges, std::vector<Arc> edgeArcs);
+
+    bool empty() const { return offsets.empty(); }
+    size_t getNodeCount() const { return empty() ? 0 : offsets.size() - 1; }
+    // Edges to more important nodes: roads leaving node, or arriving at it
+    Range getUpward(int node) const { return {upward.data() + offsets[node], upward.data() + offsets[node + 1]}; }
+    Range getDownward(int node) const { return {downward.data() + downwardOffsets[node], downward.data() + downwardOffsets[node + 1]}; }
+    const Arc& getArc(int arc) const { return arcs[arc]; }
+
+    size_t getEdgeCount() const { return upward.size() + downward.size(); }
+    size_t getShortcutCount() const { return arcs.size() - roadArcCount; }
+    size_t memoryUsage() const;
+
+private:
+    std::vector<uint32_t> offsets;
+    std::vector<Edge> upward;
+    std::vector<uint32_t> downwardOffsets;
+    std::vector<Edge> downward;
+    std::vector<Arc> arcs;
+    size_t roadArcCount = 0;
+};
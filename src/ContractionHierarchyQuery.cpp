@@ -0,0 +1,107 @@
+#include "ContractionHierarchyQuery.h"
+#include "CustomizableContractionHierarchy.h"
+#include <memory>
+
+/* CONSTRUCTORS */
+ContractionHierarchyQuery::ContractionHierarchyQuery(const ContractionHierarchy& hierarchy): fixed(&hierarchy) {}
+
+ContractionHierarchyQuery::ContractionHierarchyQuery(const CustomizableContractionHierarchy& customizable): customizable(&customizable) {}
+
+/* METHODS */
+bool ContractionHierarchyQuery::findRoute(int from, int to, Route& route) {
+    route.clear();
+    // Held until the route is unpacked, whatever is swapped in meanwhile
+    std::shared_ptr<const ContractionHierarchy> metric = customizable ? customizable->getMetric() : nullptr;
+    hierarchy = customizable ? metric.get() : fixed;
+    if (!hierarchy) {
+        return false;
+    }
+
+    size_t nodeCount = hierarchy->getNodeCount();
+    if (from < 0 || to < 0 || static_cast<size_t>(from) >= nodeCount || static_cast<size_t>(to) >= nodeCount) {
+        return false;
+    }
+
+    forward.reset(nodeCount);
+    backward.reset(nodeCount);
+    forward.relax(from, 0, 0, -1, -1);
+    backward.relax(to, 0, 0, -1, -1);
+    uint32_t best = RoadColumns::unreachable;
+    int meeting = -1;
+
+    // searchEdges lead up in the search's direction, stallEdges come down
+    // into the node from more important ones
+    auto step = [&](SearchSpace& space, const SearchSpace& other, auto searchEdges, auto stallEdges) {
+        int node = space.settleMin();
+        uint32_t distance = space.getDistance(node);
+        if (other.isReached(node) && static_cast<uint64_t>(distance) + other.getDistance(node) < best) {
+            best = distance + other.getDistance(node);
+            meeting = node;
+        }
+
+        for (const ContractionHierarchy::Edge& edge : stallEdges(node)) {
+            if (static_cast<uint64_t>(space.getDistance(edge.target)) + edge.weight < distance) {
+                return;
+            }
+        }
+        for (const ContractionHierarchy::Edge& edge : searchEdges(node)) {
+            uint64_t reached = static_cast<uint64_t>(distance) + edge.weight;
+            if (reached < RoadColumns::unreachable) {
+                space.relax(edge.target, static_cast<uint32_t>(reached), static_cast<uint32_t>(reached), node, edge.arc);
+            }
+        }
+    };
+    auto getUpward = [this](int node) { return hierarchy->getUpward(node); };
+    auto getDownward = [this](int node) { return hierarchy->getDownward(node); };
+
+    // Each search stops once its queue holds nothing faster than the best
+    // route, which then cannot be improved through a node it has yet to settle
+    for (;;) {
+        bool forwardOpen = !forward.empty() && forward.getMinKey() < best;
+        bool backwardOpen = !backward.empty() && backward.getMinKey() < best;
+        if (forwardOpen && (!backwardOpen || forward.getMinKey() <= backward.getMinKey())) {
+            step(forward, backward, getUpward, getDownward);
+        } else if (backwardOpen) {
+            step(backward, forward, getDownward, getUpward);
+        } else {
+            break;
+        }
+    }
+
+    route.settledNodes = forward.getSettledCount() + backward.getSettledCount();
+    if (meeting < 0) {
+        return false;
+    }
+
+    // Up from the start as searched, then down from the meeting node to the
+    // end, which the backward search walked the other way
+    route.travelTime = best;
+    route.nodes.push_back(from);
+    forward.getPath(meeting, pathNodes, pathArcs);
+    for (size_t i = 0; i < pathArcs.size(); ++i) {
+        unpack(pathArcs[i], pathNodes[i + 1], route);
+    }
+    backward.getPath(meeting, pathNodes, pathArcs);
+    for (size_t i = pathArcs.size(); i-- > 0;) {
+        unpack(pathArcs[i], pathNodes[i], route);
+    }
+    return true;
+}
+
+void ContractionHierarchyQuery::unpack(int arc, int head, Route& route) {
+    unpacking.clear();
+    unpacking.push_back({arc, head});
+    while (!unpacking.empty()) {
+        Unpacking next = unpacking.back();
+        unpacking.pop_back();
+        const ContractionHierarchy::Arc& unpacked = hierarchy->getArc(next.arc);
+        if (unpacked.middle < 0) {
+            route.roads.push_back(unpacked.first);
+            route.nodes.push_back(next.head);
+            continue;
+        }
+        // The first half is taken off the stack first
+        unpacking.push_back({unpacked.second, next.head});
+        unpacking.push_back({unpacked.first, unpacked.middle});
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ContractionHierarchy.h"
+#include "Route.h"
+#include "SearchSpace.h"
+
+class CustomizableContractionHierarchy;
+
+// Fastest routes on a contraction hierarchy: a forward search up from the
+// start and a backward search up from the end, meeting at the most
+// important node of the route. A node that a more important node already
+// reaches faster through a downward edge is not on a shortest path up, so
+// its edges are not relaxed (stall-on-demand). Shortcuts are unpacked into
+// the roads they stand for. Keep one per thread, like Dijkstra.
+class ContractionHierarchyQuery {
+public:
+    explicit ContractionHierarchyQuery(const ContractionHierarchy& hierarchy);
+    // Each query takes the current metric and keeps it until it is done, so
+    // a metric swapped in meanwhile is used from the next query on
+    explicit ContractionHierarchyQuery(const CustomizableContractionHierarchy& customizable);
+
+    // Returns false if to cannot be reached from from, or either is outside
+    // the hierarchy
+    bool findRoute(int from, int to, Route& route);
+
+private:
+    struct Unpacking {
+        int arc;
+        int head;
+    };
+
+    const ContractionHierarchy* fixed = nullptr;
+    const CustomizableContractionHierarchy* customizable = nullptr;
+    // Hierarchy of the current query
+    const ContractionHierarchy* hierarchy = nullptr;
+    SearchSpace forward;
+    SearchSpace backward;
+    // Halves of the route in hierarchy edges, kept to reuse their capacity
+    std::vector<int> pathNodes;
+    std::vector<int> pathArcs;
+    std::vector<Unpacking> unpacking;
+
+    // Appends the roads of arc and the nodes after each, ending at head
+    void unpack(int arc, int head, Route& route);
+};
@@ -0,0 +1,350 @@
+#include "CustomizableContractionHierarchy.h"
+#include "Parallel.h"
+#include "RoadGraph.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace {
+    // Cells this small are not split further
+    const size_t leafSize = 8;
+    // Nodes one task customizes, so small levels run without threads
+    const size_t customizeBlockSize = 256;
+
+    // Orders nodes by recursive coordinate bisection. Each cell is split along
+    // a straight line, and the nodes of the half with fewer roads across
+    // become the separator, ordered after both halves.
+    class NestedDissection {
+    public:
+        NestedDissection(const RoadGraph& graph, const std::vector<uint32_t>& neighborOffsets, const std::vector<int>& neighbors)
+            : graph(graph), neighborOffsets(neighborOffsets), neighbors(neighbors), sides(neighborOffsets.size() - 1, 0) {}
+
+        std::vector<int> order(std::vector<int> cell) {
+            nodes = std::move(cell);
+            result.clear();
+            result.reserve(nodes.size());
+            dissect(0, nodes.size());
+            return result;
+        }
+
+    private:
+        const RoadGraph& graph;
+        const std::vector<uint32_t>& neighborOffsets;
+        const std::vector<int>& neighbors;
+        // Each split marks its halves with a fresh pair of values
+        std::vector<uint32_t> sides;
+        uint32_t side = 0;
+        std::vector<int> nodes;
+        std::vector<int> result;
+
+        bool hasNeighborOn(int node, uint32_t other) const {
+            for (uint32_t i = neighborOffsets[node]; i < neighborOffsets[node + 1]; ++i) {
+                if (sides[neighbors[i]] == other) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Puts the nodes before middle along direction into the left half and
+        // counts the nodes of each half with a road to the other
+        void split(size_t begin, size_t middle, size_t end, const glm::vec2& direction, uint32_t& left, uint32_t& right,
+                   size_t& leftBoundary, size_t& rightBoundary) {
+            std::nth_element(nodes.begin() + begin, nodes.begin() + middle, nodes.begin() + end, [&](int a, int b) {
+                return glm::dot(glm::vec2(graph.getNodePositionUnchecked(a)), direction) <
+                       glm::dot(glm::vec2(graph.getNodePositionUnchecked(b)), direction);
+            });
+
+            left = side += 2;
+            right = left + 1;
+            for (size_t i = begin; i < end; ++i) {
+                sides[nodes[i]] = i < middle ? left : right;
+            }
+            leftBoundary = 0;
+            rightBoundary = 0;
+            for (size_t i = begin; i < end; ++i) {
+                if (i < middle) {
+                    leftBoundary += hasNeighborOn(nodes[i], right) ? 1 : 0;
+                } else {
+                    rightBoundary += hasNeighborOn(nodes[i], left) ? 1 : 0;
+                }
+            }
+        }
+
+        void dissect(size_t begin, size_t end) {
+            if (end - begin <= leafSize) {
+                result.insert(result.end(), nodes.begin() + begin, nodes.begin() + end);
+                return;
+            }
+
+            // Cuts across both axes and both diagonals, at a few points around
+            // the median. The fewest boundary nodes for the balance wins.
+            const glm::vec2 directions[] = {{1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, -1.0f}};
+            const size_t splitPercents[] = {40, 45, 50, 55, 60};
+            uint32_t left = 0;
+            uint32_t right = 0;
+            size_t leftBoundary = 0;
+            size_t rightBoundary = 0;
+            double bestScore = std::numeric_limits<double>::infinity();
+            glm::vec2 bestDirection;
+            size_t middle = begin;
+            for (const glm::vec2& direction : directions) {
+                for (size_t percent : splitPercents) {
+                    size_t candidate = begin + (end - begin) * percent / 100;
+                    split(begin, candidate, end, direction, left, right, leftBoundary, rightBoundary);
+                    double score = std::min(leftBoundary, rightBoundary) / (static_cast<double>(candidate - begin) * (end - candidate));
+                    if (score < bestScore) {
+                        bestScore = score;
+                        bestDirection = direction;
+                        middle = candidate;
+                    }
+                }
+            }
+            split(begin, middle, end, bestDirection, left, right, leftBoundary, rightBoundary);
+
+            // The separator moves to the end of its half and is ordered last
+            bool separateLeft = leftBoundary <= rightBoundary;
+            size_t first = separateLeft ? begin : middle;
+            size_t last = separateLeft ? middle : end;
+            uint32_t other = separateLeft ? right : left;
+            size_t separator = std::stable_partition(nodes.begin() + first, nodes.begin() + last,
+                                                     [&](int node) { return !hasNeighborOn(node, other); }) - nodes.begin();
+            if (separateLeft) {
+                dissect(begin, separator);
+                dissect(middle, end);
+            } else {
+                dissect(begin, middle);
+                dissect(middle, separator);
+            }
+            result.insert(result.end(), nodes.begin() + separator, nodes.begin() + last);
+        }
+    };
+}
+
+/* METHODS */
+void CustomizableContractionHierarchy::build(const RoadGraph& graph, size_t workerCount) {
+    const Column<Road>& roads = graph.getRoads();
+    size_t nodeCount = std::max(graph.getAdjacency().getNodeCount(), graph.getNodes().size());
+
+    // Roads as undirected neighbor lists, without self loops
+    std::vector<uint32_t> neighborOffsets(nodeCount + 1, 0);
+    auto isUsable = [&](const Road& road) {
+        return road.from >= 0 && road.to >= 0 && road.from != road.to && static_cast<size_t>(road.from) < nodeCount &&
+               static_cast<size_t>(road.to) < nodeCount;
+    };
+    for (const Road& road : roads) {
+        if (isUsable(road)) {
+            ++neighborOffsets[road.from + 1];
+            ++neighborOffsets[road.to + 1];
+        }
+    }
+    for (size_t node = 0; node < nodeCount; ++node) {
+        neighborOffsets[node + 1] += neighborOffsets[node];
+    }
+    std::vector<int> neighbors(neighborOffsets.back());
+    std::vector<uint32_t> cursor(neighborOffsets.begin(), neighborOffsets.end() - 1);
+    for (const Road& road : roads) {
+        if (isUsable(road)) {
+            neighbors[cursor[road.from]++] = road.to;
+            neighbors[cursor[road.to]++] = road.from;
+        }
+    }
+
+    // Ids without a position go first; the order only affects speed
+    std::vector<int> order;
+    std::vector<int> positioned;
+    for (size_t node = 0; node < nodeCount; ++node) {
+        (graph.nodeExists(static_cast<int>(node)) ? positioned : order).push_back(static_cast<int>(node));
+    }
+    std::vector<int> dissected = NestedDissection(graph, neighborOffsets, neighbors).order(std::move(positioned));
+    order.insert(order.end(), dissected.begin(), dissected.end());
+    ranks.assign(nodeCount, 0);
+    for (size_t rank = 0; rank < nodeCount; ++rank) {
+        ranks[order[rank]] = static_cast<int>(rank);
+    }
+
+    // Contracting in order joins all more important neighbors of a node; it
+    // is enough to pass them on to the least important one (chordal completion)
+    std::vector<std::vector<int>> upper(nodeCount);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        for (uint32_t i = neighborOffsets[node]; i < neighborOffsets[node + 1]; ++i) {
+            if (ranks[neighbors[i]] > ranks[node]) {
+                upper[ranks[node]].push_back(ranks[neighbors[i]]);
+            }
+        }
+    }
+    for (size_t rank = 0; rank < nodeCount; ++rank) {
+        std::vector<int>& list = upper[rank];
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        if (!list.empty()) {
+            upper[list.front()].insert(upper[list.front()].end(), list.begin() + 1, list.end());
+        }
+    }
+
+    offsets.assign(nodeCount + 1, 0);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        offsets[node + 1] = offsets[node] + static_cast<uint32_t>(upper[ranks[node]].size());
+    }
+    targets.resize(offsets.back());
+    sources.resize(offsets.back());
+    lowerOffsets.assign(nodeCount + 1, 0);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        uint32_t edge = offsets[node];
+        for (int rank : upper[ranks[node]]) {
+            sources[edge] = static_cast<int>(node);
+            targets[edge++] = order[rank];
+            ++lowerOffsets[order[rank] + 1];
+        }
+        std::vector<int>().swap(upper[ranks[node]]);
+    }
+    for (size_t node = 0; node < nodeCount; ++node) {
+        lowerOffsets[node + 1] += lowerOffsets[node];
+    }
+    lowerEdges.resize(lowerOffsets.back());
+    cursor.assign(lowerOffsets.begin(), lowerOffsets.end() - 1);
+    for (size_t edge = 0; edge < targets.size(); ++edge) {
+        lowerEdges[cursor[targets[edge]]++] = static_cast<int>(edge);
+    }
+
+    // Each road goes to the edge between its ends, found by rank
+    auto findEdge = [this](int from, int to) {
+        int lower = ranks[from] < ranks[to] ? from : to;
+        int upper = lower == from ? to : from;
+        auto first = targets.begin() + offsets[lower];
+        auto last = targets.begin() + offsets[lower + 1];
+        auto found = std::lower_bound(first, last, upper, [this](int target, int node) { return ranks[target] < ranks[node]; });
+        return static_cast<uint32_t>(found - targets.begin());
+    };
+    roadOffsets.assign(targets.size() + 1, 0);
+    for (const Road& road : roads) {
+        if (isUsable(road)) {
+            ++roadOffsets[findEdge(road.from, road.to) + 1];
+        }
+    }
+    for (size_t edge = 0; edge < targets.size(); ++edge) {
+        roadOffsets[edge + 1] += roadOffsets[edge];
+    }
+    edgeRoads.resize(roadOffsets.back());
+    cursor.assign(roadOffsets.begin(), roadOffsets.end() - 1);
+    for (size_t id = 0; id < roads.size(); ++id) {
+        const Road& road = roads[id];
+        if (isUsable(road)) {
+            bool fromLower = ranks[road.from] < ranks[road.to];
+            edgeRoads[cursor[findEdge(road.from, road.to)]++] = {static_cast<int>(id), fromLower || road.twoWay, !fromLower || road.twoWay};
+        }
+    }
+
+    // A node's level is one more than that of any less important neighbor,
+    // so nodes of one level never customize the same edges
+    std::vector<int> levels(nodeCount, 0);
+    int levelCount = nodeCount > 0 ? 1 : 0;
+    for (int node : order) {
+        for (uint32_t i = lowerOffsets[node]; i < lowerOffsets[node + 1]; ++i) {
+            levels[node] = std::max(levels[node], levels[sources[lowerEdges[i]]] + 1);
+        }
+        levelCount = std::max(levelCount, levels[node] + 1);
+    }
+    levelOffsets.assign(levelCount + 1, 0);
+    for (int level : levels) {
+        ++levelOffsets[level + 1];
+    }
+    for (int level = 0; level < levelCount; ++level) {
+        levelOffsets[level + 1] += levelOffsets[level];
+    }
+    levelNodes.resize(nodeCount);
+    cursor.assign(levelOffsets.begin(), levelOffsets.end() - 1);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        levelNodes[cursor[levels[node]]++] = static_cast<int>(node);
+    }
+
+    setMetric(customize(graph.getRoadColumns().getTravelTimes(), workerCount));
+}
+
+std::shared_ptr<const ContractionHierarchy> CustomizableContractionHierarchy::customize(const std::vector<uint32_t>& travelTimes,
+                                                                                        size_t workerCount) const {
+    std::vector<ContractionHierarchy::Edge> upward(targets.size());
+    std::vector<ContractionHierarchy::Edge> downward(targets.size());
+    std::vector<ContractionHierarchy::Arc> arcs(targets.size() * 2);
+    for (size_t level = 0; level + 1 < levelOffsets.size(); ++level) {
+        uint32_t first = levelOffsets[level];
+        uint32_t count = levelOffsets[level + 1] - first;
+        parallelFor((count + customizeBlockSize - 1) / customizeBlockSize, [&](size_t block) {
+            uint32_t last = std::min<uint32_t>(count, static_cast<uint32_t>((block + 1) * customizeBlockSize));
+            for (uint32_t i = static_cast<uint32_t>(block * customizeBlockSize); i < last; ++i) {
+                customizeNode(levelNodes[first + i], travelTimes, upward, downward, arcs);
+            }
+        }, workerCount);
+    }
+
+    // Both directions share the edges, so they share the offsets too
+    auto hierarchy = std::make_shared<ContractionHierarchy>();
+    hierarchy->assign(offsets, std::move(upward), offsets, std::move(downward), std::move(arcs));
+    return hierarchy;
+}
+
+void CustomizableContractionHierarchy::customizeNode(int node, const std::vector<uint32_t>& travelTimes,
+                                                     std::vector<ContractionHierarchy::Edge>& upward,
+                                                     std::vector<ContractionHierarchy::Edge>& downward,
+                                                     std::vector<ContractionHierarchy::Arc>& arcs) const {
+    // Arc 2e runs up edge e, arc 2e + 1 down it. First the fastest road each way.
+    for (uint32_t edge = offsets[node]; edge < offsets[node + 1]; ++edge) {
+        upward[edge] = {targets[edge], RoadColumns::unreachable, static_cast<int>(2 * edge)};
+        downward[edge] = {targets[edge], RoadColumns::unreachable, static_cast<int>(2 * edge + 1)};
+        arcs[2 * edge] = {-1, -1, -1};
+        arcs[2 * edge + 1] = {-1, -1, -1};
+        for (uint32_t i = roadOffsets[edge]; i < roadOffsets[edge + 1]; ++i) {
+            const EdgeRoad& edgeRoad = edgeRoads[i];
+            uint32_t travelTime = static_cast<size_t>(edgeRoad.road) < travelTimes.size() ? travelTimes[edgeRoad.road] : RoadColumns::unreachable;
+            if (edgeRoad.upward && travelTime < upward[edge].weight) {
+                upward[edge].weight = travelTime;
+                arcs[2 * edge] = {edgeRoad.road, -1, -1};
+            }
+            if (edgeRoad.downward && travelTime < downward[edge].weight) {
+                downward[edge].weight = travelTime;
+                arcs[2 * edge + 1] = {edgeRoad.road, -1, -1};
+            }
+        }
+    }
+
+    // Then every lower triangle: a less important neighbor joined to this
+    // node and to a more important one. Its edges were customized in an
+    // earlier level; the more important ends after this node in its list are
+    // all among this node's own, in the same order.
+    for (uint32_t i = lowerOffsets[node]; i < lowerOffsets[node + 1]; ++i) {
+        int lowerEdge = lowerEdges[i];
+        int lower = sources[lowerEdge];
+        uint32_t edge = offsets[node];
+        for (uint32_t sideEdge = lowerEdge + 1; sideEdge < offsets[lower + 1]; ++sideEdge) {
+            while (targets[edge] != targets[sideEdge]) {
+                ++edge;
+            }
+            uint64_t up = static_cast<uint64_t>(downward[lowerEdge].weight) + upward[sideEdge].weight;
+            if (up < upward[edge].weight) {
+                upward[edge].weight = static_cast<uint32_t>(up);
+                arcs[2 * edge] = {2 * lowerEdge + 1, static_cast<int>(2 * sideEdge), lower};
+            }
+            uint64_t down = static_cast<uint64_t>(downward[sideEdge].weight) + upward[lowerEdge].weight;
+            if (down < downward[edge].weight) {
+                downward[edge].weight = static_cast<uint32_t>(down);
+                arcs[2 * edge + 1] = {static_cast<int>(2 * sideEdge + 1), 2 * lowerEdge, lower};
+            }
+        }
+    }
+}
+
+void CustomizableContractionHierarchy::setMetric(std::shared_ptr<const ContractionHierarchy> value) {
+    std::atomic_store(&metric, std::move(value));
+}
+
+std::shared_ptr<const ContractionHierarchy> CustomizableContractionHierarchy::getMetric() const {
+    return std::atomic_load(&metric);
+}
+
+size_t CustomizableContractionHierarchy::memoryUsage() const {
+    size_t usage = (ranks.capacity() + targets.capacity() + sources.capacity() + lowerEdges.capacity() + levelNodes.capacity()) * sizeof(int) +
+                   (offsets.capacity() + lowerOffsets.capacity() + roadOffsets.capacity() + levelOffsets.capacity()) * sizeof(uint32_t) +
+                   edgeRoads.capacity() * sizeof(EdgeRoad);
+    std::shared_ptr<const ContractionHierarchy> current = getMetric();
+    return current ? usage + current->memoryUsage() : usage;
+}
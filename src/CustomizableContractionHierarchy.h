@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ContractionHierarchy.h"
+
+class RoadGraph;
+
+// Contraction hierarchy whose structure does not depend on travel times
+// (CCH). Nodes are ordered by nested dissection, with each cell's separator
+// above both halves, and contracted without witness searches, so the edges
+// only follow from the order. Customizing then turns travel times per road
+// id into a metric: a ContractionHierarchy over the same edges, made in
+// well under a second, that ContractionHierarchyQuery searches as usual.
+// Queries keep the metric they started with while a new one is swapped in.
+class CustomizableContractionHierarchy {
+public:
+    // Orders the nodes by recursive bisection of their positions and builds
+    // the edges, then customizes with the roads' current travel times. Roads
+    // added later are only used after building again.
+    void build(const RoadGraph& graph, size_t workerCount = 0);
+
+    // Metric for travel times in milliseconds per road id; unreachable, or a
+    // road past the end, closes the road. Reads the structure only, so it can
+    // run while queries use the current metric.
+    std::shared_ptr<const ContractionHierarchy> customize(const std::vector<uint32_t>& travelTimes, size_t workerCount = 0) const;
+    // Atomically replaces the metric new queries use
+    void setMetric(std::shared_ptr<const ContractionHierarchy> metric);
+    std::shared_ptr<const ContractionHierarchy> getMetric() const;
+
+    size_t getNodeCount() const { return ranks.size(); }
+    size_t getEdgeCount() const { return targets.size(); }
+    // Groups of nodes customized in parallel, one after another
+    size_t getLevelCount() const { return levelOffsets.empty() ? 0 : levelOffsets.size() - 1; }
+    size_t memoryUsage() const;
+
+private:
+    // Roads an edge stands for, and in which of its directions they run
+    struct EdgeRoad {
+        int road;
+        bool upward;
+        bool downward;
+    };
+
+    // Position of each node in the order
+    std::vector<int> ranks;
+    // Edges to more important nodes by node, in order of rank. An edge's id
+    // is its index, and its lower end is stored alongside.
+    std::vector<uint32_t> offsets;
+    std::vector<int> targets;
+    std::vector<int> sources;
+    // Edges from less important nodes by node
+    std::vector<uint32_t> lowerOffsets;
+    std::vector<int> lowerEdges;
+    std::vector<uint32_t> roadOffsets;
+    std::vector<EdgeRoad> edgeRoads;
+    // Nodes whose less important neighbors are all in earlier levels
+    std::vector<uint32_t> levelOffsets;
+    std::vector<int> levelNodes;
+
+    std::shared_ptr<const ContractionHierarchy> metric;
+
+    void customizeNode(int node, const std::vector<uint32_t>& travelTimes, std::vector<ContractionHierarchy::Edge>& upward,
+                       std::vector<ContractionHierarchy::Edge>& downward, std::vector<ContractionHierarchy::Arc>& arcs) const;
+};
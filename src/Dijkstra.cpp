@@ -0,0 +1,77 @@
+#include "Dijkstra.h"
+#include "RoadGraph.h"
+#include <algorithm>
+
+/* CONSTRUCTORS */
+Dijkstra::Dijkstra(const RoadGraph& graph): graph(graph) {}
+
+/* METHODS */
+bool Dijkstra::findRoute(int from, int to, Route& route) {
+    route.clear();
+    if (!graph.nodeExists(from) || !graph.nodeExists(to)) {
+        return false;
+    }
+
+    direction = Adjacency::Outgoing;
+    search(from, to);
+    getRoute(to, route);
+    route.settledNodes = space.getSettledCount();
+    return route.found();
+}
+
+void Dijkstra::searchFrom(int source, Adjacency::Direction searchDirection) {
+    direction = searchDirection;
+    if (!graph.nodeExists(source)) {
+        // Nothing reached, so every node reads as unreachable
+        space.reset(graph.getNodes().size());
+        return;
+    }
+    search(source, -1);
+}
+
+uint32_t Dijkstra::getTravelTime(int node) const {
+    if (node < 0 || static_cast<size_t>(node) >= space.getNodeCount()) {
+        return RoadColumns::unreachable;
+    }
+    return space.getDistance(node);
+}
+
+bool Dijkstra::getRoute(int node, Route& route) const {
+    route.clear();
+    if (node < 0 || static_cast<size_t>(node) >= space.getNodeCount() || !space.isReached(node)) {
+        return false;
+    }
+
+    route.travelTime = space.getDistance(node);
+    space.getPath(node, route.nodes, route.roads);
+    // Backward searches walk against travel
+    if (direction == Adjacency::Incoming) {
+        std::reverse(route.nodes.begin(), route.nodes.end());
+        std::reverse(route.roads.begin(), route.roads.end());
+    }
+    return true;
+}
+
+void Dijkstra::search(int source, int target) {
+    const Adjacency& adjacency = direction == Adjacency::Outgoing ? graph.getAdjacency() : graph.getReverseAdjacency();
+    const uint32_t* travelTimes = customTravelTimes ? customTravelTimes->data() : graph.getRoadColumns().getTravelTimes().data();
+
+    // Roads may lead past the last node while a graph is edited, and nodes
+    // added since the adjacency was built lie past its end
+    space.reset(std::max(graph.getNodes().size(), adjacency.getNodeCount()));
+    space.relax(source, 0, 0, -1, -1);
+    while (!space.empty()) {
+        int node = space.settleMin();
+        if (node == target) {
+            return;
+        }
+
+        uint32_t distance = space.getDistance(node);
+        for (const Adjacency::Edge& edge : adjacency.getNeighbors(node)) {
+            uint32_t travelTime = travelTimes[edge.road];
+            if (travelTime != RoadColumns::unreachable) {
+                space.relax(edge.target, distance + travelTime, distance + travelTime, node, edge.road);
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Adjacency.h"
+#include "Route.h"
+#include "SearchSpace.h"
+
+class RoadGraph;
+
+// Fastest routes by travel time at the speed limits. Holds its own search
+// space, so keep one per thread and reuse it: after the first query a search
+// allocates nothing and clears nothing.
+class Dijkstra {
+public:
+    explicit Dijkstra(const RoadGraph& graph);
+
+    // Returns false if to cannot be reached from from
+    bool findRoute(int from, int to, Route& route);
+    // Settles every node that can be reached from source, or that can reach it
+    // when searching Incoming; read the results with getTravelTime and getRoute
+    void searchFrom(int source, Adjacency::Direction direction = Adjacency::Outgoing);
+
+    // Results of the last search, unreachable for nodes it did not reach
+    uint32_t getTravelTime(int node) const;
+    // Route between the last search's source and node, in travel order
+    bool getRoute(int node, Route& route) const;
+    size_t getSettledCount() const { return space.getSettledCount(); }
+    // Parents of the last search, e.g. to walk its shortest path tree
+    const SearchSpace& getSearchSpace() const { return space; }
+    // Searches by these milliseconds per road id instead of the speed limits,
+    // e.g. to check a customized metric; they must cover every road. Null
+    // goes back to the speed limits.
+    void setTravelTimes(const std::vector<uint32_t>* travelTimes) { customTravelTimes = travelTimes; }
+
+private:
+    const RoadGraph& graph;
+    SearchSpace space;
+    Adjacency::Direction direction = Adjacency::Outgoing;
+    const std::vector<uint32_t>* customTravelTimes = nullptr;
+
+    // Runs until target is settled, or the queue empties for target -1
+    void search(int source, int target);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+// Ids changed since the last take, collected as half-open ranges. Runs of
+// neighboring ids, as left by most edits, grow the last range in place.
+class DirtyRanges {
+public:
+    struct Range {
+        int begin;
+        int end;
+    };
+
+    void add(int id) {
+        if (!ranges.empty() && id >= ranges.back().begin && id <= ranges.back().end) {
+            ranges.back().end = std::max(ranges.back().end, id + 1);
+            return;
+        }
+        ranges.push_back({id, id + 1});
+    }
+
+    void add(int begin, int end) {
+        if (begin < end) {
+            ranges.push_back({begin, end});
+        }
+    }
+
+    bool empty() const { return ranges.empty(); }
+
+    // Sorted, with overlapping and touching ranges merged; leaves nothing behind
+    std::vector<Range> take() {
+        std::vector<Range> result;
+        result.swap(ranges);
+        std::sort(result.begin(), result.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+        size_t count = 0;
+        for (const Range& range : result) {
+            if (count > 0 && range.begin <= result[count - 1].end) {
+                result[count - 1].end = std::max(result[count - 1].end, range.end);
+            } else {
+                result[count++] = range;
+            }
+        }
+        result.resize(count);
+        return result;
+    }
+
+private:
+    std::vector<Range> ranges;
+};
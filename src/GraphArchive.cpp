@@ -0,0 +1,524 @@
+#include "GraphArchive.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace {
+    const char magic[8] = {'R', 'G', 'A', 'R', 'C', 'H', '\0', '\0'};
+    const uint32_t byteOrderMark = 0x01020304;
+
+    const uint32_t nodesPerBlock = 1 << 14;
+    const uint32_t roadsPerBlock = 1 << 14;
+    const uint32_t shapePointsPerBlock = 1 << 16;
+    const uint32_t externalIdsPerBlock = 1 << 16;
+
+    enum BlockKind : uint32_t {
+        NodesBlock = 1,
+        RoadsBlock = 2,
+        ShapePointsBlock = 3,
+        ExternalIdsBlock = 4,
+        ExternalIdOrderBlock = 5,
+    };
+
+    struct ArchiveHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t nodeCount;
+        uint64_t roadCount;
+        uint64_t shapePointCount;
+        // Zero when nodes keep their source ids, the node count otherwise
+        uint64_t externalIdCount;
+        // Zero while the source ids are ascending
+        uint64_t externalIdOrderCount;
+        uint32_t blockCount;
+        float step;
+        float minCoords[3];
+        float maxCoords[3];
+        uint64_t fileSize;
+    };
+
+    // Node blocks cover a range of ids, the others a range of elements
+    struct Block {
+        uint32_t kind;
+        uint32_t first;
+        uint32_t count;
+        uint32_t size;
+        uint64_t offset;
+        float origin[3];
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Block) == 40, "Block must be stored as a packed record");
+
+    void writeVarint(std::string& output, uint64_t value) {
+        while (value >= 0x80) {
+            output.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<char>(value));
+    }
+
+    void writeSigned(std::string& output, int64_t value) {
+        writeVarint(output, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    // Bounds-checked varint reader over one block
+    class BlockReader {
+    public:
+        BlockReader(const uint8_t* position, const uint8_t* end): position(position), end(end) {}
+
+        bool read(uint64_t& value) {
+            uint64_t result = 0;
+            for (int shift = 0; shift < 64 && position < end; shift += 7) {
+                uint8_t byte = *position++;
+                result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    value = result;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool readSigned(int64_t& value) {
+            uint64_t encoded;
+            if (!read(encoded)) {
+                return false;
+            }
+            value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+            return true;
+        }
+
+        bool atEnd() const { return position == end; }
+
+    private:
+        const uint8_t* position;
+        const uint8_t* end;
+    };
+
+    int64_t quantize(float value, float origin, float step) {
+        return std::llround((static_cast<double>(value) - origin) / step);
+    }
+
+    float dequantize(int64_t value, float origin, float step) {
+        return static_cast<float>(origin + static_cast<double>(value) * step);
+    }
+
+    // Road ends are node ids or -1, and shapes lie within the shape points
+    bool isValidRoad(int64_t from, int64_t to, uint64_t shapeBegin, uint64_t shapeCount, uint64_t nodeCount, uint64_t shapePointCount) {
+        auto isValidEnd = [nodeCount](int64_t node) { return node >= -1 && (node < 0 || static_cast<uint64_t>(node) < nodeCount); };
+        return isValidEnd(from) && isValidEnd(to) && shapeBegin <= shapePointCount && shapeCount <= shapePointCount - shapeBegin;
+    }
+
+    void encodeNodes(const RoadGraph& graph, Block& block, std::string& output, float step) {
+        const Column<Node>& nodes = graph.getNodes();
+        uint32_t end = block.first + block.count;
+
+        glm::vec3 origin(std::numeric_limits<float>::max());
+        for (uint32_t id = block.first; id < end; ++id) {
+            if (graph.nodeExists(id)) {
+                origin = glm::min(origin, nodes[id].position);
+            }
+        }
+        if (origin.x == std::numeric_limits<float>::max()) {
+            origin = glm::vec3(0.0f);
+        }
+
+        uint32_t expected = block.first;
+        for (uint32_t id = block.first; id < end; ++id) {
+            if (!graph.nodeExists(id)) {
+                continue;
+            }
+            writeVarint(output, id - expected);
+            expected = id + 1;
+            for (int axis = 0; axis < 3; ++axis) {
+                writeVarint(output, static_cast<uint64_t>(quantize(nodes[id].position[axis], origin[axis], step)));
+            }
+        }
+
+        for (int axis = 0; axis < 3; ++axis) {
+            block.origin[axis] = origin[axis];
+        }
+    }
+
+    void encodeRoads(const RoadGraph& graph, const Block& block, std::string& output) {
+        const Column<Road>& roads = graph.getRoads();
+        int64_t previousFrom = 0;
+        int64_t shapeCursor = 0;
+        for (uint32_t id = block.first; id < block.first + block.count; ++id) {
+            const Road& road = roads[id];
+            writeSigned(output, road.from - previousFrom);
+            writeSigned(output, static_cast<int64_t>(road.to) - road.from);
+            writeSigned(output, std::llround(static_cast<double>(road.meters) * 1000.0));
+            writeSigned(output, std::llround(road.maxSpeed));
+            writeSigned(output, road.lanes);
+            writeVarint(output, (static_cast<uint64_t>(road.shapeCount) << 1) | road.twoWay);
+            if (road.shapeCount > 0) {
+                // Roads usually take the range right after the previous one
+                writeSigned(output, static_cast<int64_t>(road.shapeBegin) - shapeCursor);
+                shapeCursor = static_cast<int64_t>(road.shapeBegin) + road.shapeCount;
+            }
+            previousFrom = road.from;
+        }
+    }
+
+    void encodeShapePoints(const RoadGraph& graph, Block& block, std::string& output, float step) {
+        const Column<glm::vec2>& shapePoints = graph.getShapePoints();
+        uint32_t end = block.first + block.count;
+
+        glm::vec2 origin(std::numeric_limits<float>::max());
+        for (uint32_t i = block.first; i < end; ++i) {
+            origin = glm::min(origin, shapePoints[i]);
+        }
+
+        int64_t previous[2] = {0, 0};
+        for (uint32_t i = block.first; i < end; ++i) {
+            for (int axis = 0; axis < 2; ++axis) {
+                int64_t value = quantize(shapePoints[i][axis], origin[axis], step);
+                writeSigned(output, value - previous[axis]);
+                previous[axis] = value;
+            }
+        }
+
+        block.origin[0] = origin.x;
+        block.origin[1] = origin.y;
+        block.origin[2] = 0.0f;
+    }
+
+    // Source ids are mostly ascending, so deltas stay small
+    void encodeIds(const Column<int>& ids, const Block& block, std::string& output) {
+        int64_t previous = 0;
+        for (uint32_t i = block.first; i < block.first + block.count; ++i) {
+            writeSigned(output, ids[i] - previous);
+            previous = ids[i];
+        }
+    }
+
+    bool decodeNodes(const Block& block, BlockReader& reader, std::vector<Node>& nodes, float step) {
+        uint64_t next = block.first;
+        uint64_t end = uint64_t(block.first) + block.count;
+        while (!reader.atEnd()) {
+            uint64_t gap;
+            uint64_t values[3];
+            if (!reader.read(gap) || !reader.read(values[0]) || !reader.read(values[1]) || !reader.read(values[2])) {
+                return false;
+            }
+            uint64_t id = next + gap;
+            if (gap >= end || id >= end) {
+                return false;
+            }
+            nodes[id].position = glm::vec3(dequantize(static_cast<int64_t>(values[0]), block.origin[0], step),
+                                           dequantize(static_cast<int64_t>(values[1]), block.origin[1], step),
+                                           dequantize(static_cast<int64_t>(values[2]), block.origin[2], step));
+            next = id + 1;
+        }
+        return true;
+    }
+
+    bool decodeRoads(const Block& block, BlockReader& reader, std::vector<Road>& roads, const ArchiveHeader& header) {
+        int64_t previousFrom = 0;
+        int64_t shapeCursor = 0;
+        for (uint32_t id = block.first; id < block.first + block.count; ++id) {
+            int64_t from, to, millimeters, maxSpeed, lanes, shapeBegin = 0;
+            uint64_t shape;
+            if (!reader.readSigned(from) || !reader.readSigned(to) || !reader.readSigned(millimeters) ||
+                !reader.readSigned(maxSpeed) || !reader.readSigned(lanes) || !reader.read(shape)) {
+                return false;
+            }
+            from += previousFrom;
+            to += from;
+
+            uint64_t shapeCount = shape >> 1;
+            if (shapeCount > 0) {
+                if (!reader.readSigned(shapeBegin)) {
+                    return false;
+                }
+                shapeBegin += shapeCursor;
+                if (shapeBegin < 0) {
+                    return false;
+                }
+                shapeCursor = shapeBegin + static_cast<int64_t>(shapeCount);
+            }
+            if (!isValidRoad(from, to, static_cast<uint64_t>(shapeBegin), shapeCount, header.nodeCount, header.shapePointCount)) {
+                return false;
+            }
+
+            roads[id] = Road(static_cast<int>(from), static_cast<int>(to), static_cast<float>(millimeters / 1000.0), static_cast<float>(maxSpeed),
+                             static_cast<int>(lanes), static_cast<uint32_t>(shapeBegin), static_cast<uint32_t>(shapeCount), shape & 1);
+            previousFrom = from;
+        }
+        return reader.atEnd();
+    }
+
+    bool decodeShapePoints(const Block& block, BlockReader& reader, std::vector<glm::vec2>& shapePoints, float step) {
+        int64_t previous[2] = {0, 0};
+        for (uint32_t i = block.first; i < block.first + block.count; ++i) {
+            int64_t delta[2];
+            if (!reader.readSigned(delta[0]) || !reader.readSigned(delta[1])) {
+                return false;
+            }
+            previous[0] += delta[0];
+            previous[1] += delta[1];
+            shapePoints[i] = glm::vec2(dequantize(previous[0], block.origin[0], step), dequantize(previous[1], block.origin[1], step));
+        }
+        return reader.atEnd();
+    }
+
+    bool decodeIds(const Block& block, BlockReader& reader, std::vector<int>& ids) {
+        int64_t previous = 0;
+        for (uint32_t i = block.first; i < block.first + block.count; ++i) {
+            int64_t delta;
+            if (!reader.readSigned(delta)) {
+                return false;
+            }
+            previous += delta;
+            if (previous < INT32_MIN || previous > INT32_MAX) {
+                return false;
+            }
+            ids[i] = static_cast<int>(previous);
+        }
+        return reader.atEnd();
+    }
+
+    // Number of elements the blocks of a kind cover, 0 for unknown kinds
+    uint64_t elementCount(const ArchiveHeader& header, uint32_t kind) {
+        switch (kind) {
+        case NodesBlock:
+            return header.nodeCount;
+        case RoadsBlock:
+            return header.roadCount;
+        case ShapePointsBlock:
+            return header.shapePointCount;
+        case ExternalIdsBlock:
+            return header.externalIdCount;
+        case ExternalIdOrderBlock:
+            return header.externalIdOrderCount;
+        default:
+            return 0;
+        }
+    }
+
+    void addBlocks(std::vector<Block>& blocks, BlockKind kind, size_t count, uint32_t blockSize) {
+        for (size_t first = 0; first < count; first += blockSize) {
+            Block block = {};
+            block.kind = kind;
+            block.first = static_cast<uint32_t>(first);
+            block.count = static_cast<uint32_t>(std::min<size_t>(blockSize, count - first));
+            blocks.push_back(block);
+        }
+    }
+}
+
+/* METHODS */
+bool GraphArchive::isGraphArchive(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char buffer[sizeof(magic)];
+    if (!file.read(buffer, sizeof(buffer))) {
+        return false;
+    }
+    return std::memcmp(buffer, magic, sizeof(magic)) == 0;
+}
+
+bool GraphArchive::write(const RoadGraph& graph, const std::string& filename, float step) {
+    if (!(step > 0.0f)) {
+        std::cerr << "Invalid quantization step: " << step << std::endl;
+        return false;
+    }
+
+    const Column<Node>& nodes = graph.getNodes();
+    const Column<Road>& roads = graph.getRoads();
+    const Column<glm::vec2>& shapePoints = graph.getShapePoints();
+    const Column<int>& externalIds = graph.getExternalIds();
+    const Column<int>& externalIdOrder = graph.getExternalIdOrder();
+    if (nodes.size() > UINT32_MAX || roads.size() > UINT32_MAX || shapePoints.size() > UINT32_MAX) {
+        std::cerr << "Graph is too large for an archive" << std::endl;
+        return false;
+    }
+    // The reader rejects these as corrupt
+    for (size_t id = 0; id < roads.size(); ++id) {
+        const Road& road = roads[id];
+        uint32_t shapeBegin = road.shapeCount > 0 ? road.shapeBegin : 0;
+        if (!isValidRoad(road.from, road.to, shapeBegin, road.shapeCount, nodes.size(), shapePoints.size())) {
+            std::cerr << "Road " << id << " leads past the last node or shape point, cannot archive it" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<Block> blocks;
+    addBlocks(blocks, NodesBlock, nodes.size(), nodesPerBlock);
+    addBlocks(blocks, RoadsBlock, roads.size(), roadsPerBlock);
+    addBlocks(blocks, ShapePointsBlock, shapePoints.size(), shapePointsPerBlock);
+    addBlocks(blocks, ExternalIdsBlock, externalIds.size(), externalIdsPerBlock);
+    addBlocks(blocks, ExternalIdOrderBlock, externalIdOrder.size(), externalIdsPerBlock);
+
+    std::vector<std::string> payloads(blocks.size());
+    parallelFor(blocks.size(), [&](size_t index) {
+        Block& block = blocks[index];
+        if (block.kind == NodesBlock) {
+            encodeNodes(graph, block, payloads[index], step);
+        } else if (block.kind == RoadsBlock) {
+            encodeRoads(graph, block, payloads[index]);
+        } else if (block.kind == ShapePointsBlock) {
+            encodeShapePoints(graph, block, payloads[index], step);
+        } else {
+            encodeIds(block.kind == ExternalIdsBlock ? externalIds : externalIdOrder, block, payloads[index]);
+        }
+    });
+
+    ArchiveHeader header = {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrderMark = byteOrderMark;
+    header.nodeCount = nodes.size();
+    header.roadCount = roads.size();
+    header.shapePointCount = shapePoints.size();
+    header.externalIdCount = externalIds.size();
+    header.externalIdOrderCount = externalIdOrder.size();
+    header.blockCount = static_cast<uint32_t>(blocks.size());
+    header.step = step;
+
+    glm::vec3 minCoords = graph.getMinCoords();
+    glm::vec3 maxCoords = graph.getMaxCoords();
+    for (int i = 0; i < 3; ++i) {
+        header.minCoords[i] = minCoords[i];
+        header.maxCoords[i] = maxCoords[i];
+    }
+
+    uint64_t offset = sizeof(ArchiveHeader) + blocks.size() * sizeof(Block);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (payloads[i].size() > UINT32_MAX) {
+            std::cerr << "Graph archive block is too large" << std::endl;
+            return false;
+        }
+        blocks[i].offset = offset;
+        blocks[i].size = static_cast<uint32_t>(payloads[i].size());
+        offset += payloads[i].size();
+    }
+    header.fileSize = offset;
+
+    // Write next to the target and rename, so readers never see a partial file
+    std::string temporaryFile = filename + ".tmp";
+    std::ofstream file(temporaryFile, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to create graph archive: " << temporaryFile << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(Block));
+    for (const std::string& payload : payloads) {
+        file.write(payload.data(), payload.size());
+    }
+
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write graph archive: " << temporaryFile << std::endl;
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    if (std::rename(temporaryFile.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to move graph archive into place: " << filename << std::endl;
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::unique_ptr<RoadGraph> GraphArchive::read(const std::string& filename, size_t workerCount) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Failed to open graph archive: " << filename << std::endl;
+        return nullptr;
+    }
+
+    ArchiveHeader header;
+    if (file.getSize() < sizeof(header)) {
+        std::cerr << "Graph archive is truncated: " << filename << std::endl;
+        return nullptr;
+    }
+    std::memcpy(&header, file.getData(), sizeof(header));
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        std::cerr << "Not a graph archive: " << filename << std::endl;
+        return nullptr;
+    }
+    if (header.byteOrderMark != byteOrderMark || header.version != version) {
+        std::cerr << "Unsupported graph archive version " << header.version << " (expected " << version << "): " << filename << std::endl;
+        return nullptr;
+    }
+
+    uint64_t tableEnd = sizeof(header) + uint64_t(header.blockCount) * sizeof(Block);
+    if (header.fileSize != file.getSize() || tableEnd > header.fileSize || !(header.step > 0.0f) ||
+        header.nodeCount > UINT32_MAX || header.roadCount > UINT32_MAX || header.shapePointCount > UINT32_MAX ||
+        (header.externalIdCount != 0 && header.externalIdCount != header.nodeCount) ||
+        (header.externalIdOrderCount != 0 && header.externalIdOrderCount != header.externalIdCount)) {
+        std::cerr << "Graph archive is truncated: " << filename << std::endl;
+        return nullptr;
+    }
+
+    std::vector<Block> blocks(header.blockCount);
+    std::memcpy(blocks.data(), file.getData() + sizeof(header), blocks.size() * sizeof(Block));
+    for (const Block& block : blocks) {
+        uint64_t total = elementCount(header, block.kind);
+        if (block.count == 0 || uint64_t(block.first) + block.count > total || block.offset < tableEnd || block.offset + block.size > header.fileSize) {
+            std::cerr << "Graph archive has a corrupt block table: " << filename << std::endl;
+            return nullptr;
+        }
+    }
+
+    // Every block writes its own slice of the arrays, so blocks decode independently
+    std::vector<Node> nodes(header.nodeCount, Node(glm::vec3(std::numeric_limits<float>::quiet_NaN())));
+    std::vector<Road> roads(header.roadCount);
+    std::vector<glm::vec2> shapePoints(header.shapePointCount);
+    std::vector<int> externalIds(header.externalIdCount);
+    std::vector<int> externalIdOrder(header.externalIdOrderCount);
+    std::atomic<bool> corrupt(false);
+
+    parallelFor(blocks.size(), [&](size_t index) {
+        const Block& block = blocks[index];
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(file.getData()) + block.offset;
+        BlockReader reader(data, data + block.size);
+
+        bool decoded;
+        if (block.kind == NodesBlock) {
+            decoded = decodeNodes(block, reader, nodes, header.step);
+        } else if (block.kind == RoadsBlock) {
+            decoded = decodeRoads(block, reader, roads, header);
+        } else if (block.kind == ShapePointsBlock) {
+            decoded = decodeShapePoints(block, reader, shapePoints, header.step);
+        } else {
+            decoded = decodeIds(block, reader, block.kind == ExternalIdsBlock ? externalIds : externalIdOrder);
+        }
+        if (!decoded) {
+            corrupt = true;
+        }
+    }, workerCount);
+
+    // The order indexes the source ids
+    for (int id : externalIdOrder) {
+        if (id < 0 || static_cast<size_t>(id) >= externalIds.size()) {
+            corrupt = true;
+        }
+    }
+
+    if (corrupt) {
+        std::cerr << "Graph archive has corrupt blocks: " << filename << std::endl;
+        return nullptr;
+    }
+
+    return std::make_unique<RoadGraph>(std::move(nodes), std::move(roads), std::move(shapePoints), std::move(externalIds), std::move(externalIdOrder));
+}
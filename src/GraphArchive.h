@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "RoadGraph.h"
+
+// Compressed container for archiving and moving graphs around. Nodes, roads,
+// shape points and source ids are cut into independent blocks that decode in parallel
+// straight into the graph's arrays:
+//  - node ids are delta coded, so only gaps in the id range cost space
+//  - positions are quantized to a fixed step relative to the block's origin
+//  - road end points are zigzag deltas against the previous road's start and
+//    the road's own start, so sorted adjacency takes a byte or two
+//  - lengths are stored in millimeters and speeds in whole km/h
+//  - shape points are deltas from the previous point
+//  - source ids of renumbered nodes, and their order once the nodes are
+//    reordered, are deltas from the previous entry
+// All integers are LEB128 varints. Decoding is lossy in these fields only:
+// node positions and shape points are rounded to the step, lengths to
+// millimeters and speeds to whole km/h.
+class GraphArchive {
+public:
+    static constexpr uint32_t version = 4;
+    static constexpr float defaultStep = 0.01f;
+
+    static bool isGraphArchive(const std::string& filename);
+    static bool write(const RoadGraph& graph, const std::string& filename, float step = defaultStep);
+    // Returns nullptr if the archive cannot be read
+    static std::unique_ptr<RoadGraph> read(const std::string& filename, size_t workerCount = 0);
+};
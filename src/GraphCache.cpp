@@ -0,0 +1,140 @@
+#include "GraphCache.h"
+#include "GraphFile.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace {
+    const size_t hashBlockSize = 4 << 20;
+
+    uint64_t mix(uint64_t hash, uint64_t value) {
+        hash ^= value * 0x9E3779B97F4A7C15ull;
+        hash = (hash << 31) | (hash >> 33);
+        return hash * 0xBF58476D1CE4E5B9ull;
+    }
+
+    uint64_t finalize(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        return hash ^ (hash >> 33);
+    }
+
+    uint64_t hashBytes(const char* data, size_t size, uint64_t seed) {
+        uint64_t hash = mix(seed, size);
+        size_t offset = 0;
+        for (; offset + 8 <= size; offset += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + offset, 8);
+            hash = mix(hash, word);
+        }
+
+        uint64_t tail = 0;
+        if (size > offset) {
+            std::memcpy(&tail, data + offset, size - offset);
+        }
+        return finalize(mix(hash, tail));
+    }
+
+    // Blocks are hashed on all cores and the block hashes combined in order
+    uint64_t hashContents(const MappedFile& file) {
+        size_t blockCount = (file.getSize() + hashBlockSize - 1) / hashBlockSize;
+        std::vector<uint64_t> blockHashes(blockCount);
+
+        parallelFor(blockCount, [&](size_t block) {
+            size_t offset = block * hashBlockSize;
+            size_t size = std::min(hashBlockSize, file.getSize() - offset);
+            blockHashes[block] = hashBytes(file.getData() + offset, size, block);
+        });
+
+        return hashBytes(reinterpret_cast<const char*>(blockHashes.data()), blockHashes.size() * sizeof(uint64_t), file.getSize());
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+/* METHODS */
+bool GraphCache::SourceIdentity::operator==(const SourceIdentity& other) const {
+    return pathHash == other.pathHash && size == other.size &&
+           modifiedTime == other.modifiedTime && contentHash == other.contentHash;
+}
+
+std::string GraphCache::getCacheFile(const std::string& nodesFile) {
+    return nodesFile + ".cache.rgraph";
+}
+
+bool GraphCache::getSourceIdentity(const std::string& filename, SourceIdentity& identity) {
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::weakly_canonical(filename, error);
+    if (error) {
+        return false;
+    }
+
+    auto modifiedTime = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+
+    MappedFile file(path.string());
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    std::string pathString = path.string();
+    identity.pathHash = hashBytes(pathString.data(), pathString.size(), 0);
+    identity.size = file.getSize();
+    identity.modifiedTime = static_cast<int64_t>(modifiedTime.time_since_epoch().count());
+    identity.contentHash = hashContents(file);
+    return true;
+}
+
+std::unique_ptr<RoadGraph> GraphCache::load(const std::string& nodesFile, const std::string& edgesFile, const RoadGraph::BatchCallback& onBatch) {
+    static_assert(sizeof(SourceIdentity) == 32, "SourceIdentity is stored as a packed record");
+
+    auto start = std::chrono::steady_clock::now();
+    std::string cacheFile = getCacheFile(nodesFile);
+
+    SourceIdentity sources[2];
+    bool identified = getSourceIdentity(nodesFile, sources[0]) && getSourceIdentity(edgesFile, sources[1]);
+
+    if (identified && std::filesystem::exists(cacheFile)) {
+        auto file = std::make_unique<GraphFile>(cacheFile);
+
+        const SourceIdentity* cachedSources;
+        size_t count;
+        if (file->isValid() && file->getSection(GraphFile::SourcesSection, cachedSources, count) &&
+            count == 2 && cachedSources[0] == sources[0] && cachedSources[1] == sources[1]) {
+            auto graph = std::make_unique<RoadGraph>(std::move(file));
+            std::cout << "Graph cache hit: loaded " << cacheFile << " in " << millisecondsSince(start) << " ms" << std::endl;
+            if (onBatch) {
+                graph->splitIntoBatches(onBatch);
+            }
+            return graph;
+        }
+
+        std::cout << "Graph cache stale: " << cacheFile << " no longer matches its sources" << std::endl;
+    } else if (identified) {
+        std::cout << "Graph cache miss: " << cacheFile << " does not exist" << std::endl;
+    }
+
+    auto graph = std::make_unique<RoadGraph>(nodesFile, edgesFile, onBatch);
+    std::cout << "Parsed text graph in " << millisecondsSince(start) << " ms" << std::endl;
+
+    if (identified && !graph->getNodes().empty()) {
+        std::vector<GraphFile::SectionData> extraSections = {
+            {GraphFile::SourcesSection, sizeof(SourceIdentity), 2, sources},
+        };
+        if (GraphFile::write(*graph, cacheFile, extraSections)) {
+            std::cout << "Graph cache written: " << cacheFile << std::endl;
+        }
+    }
+
+    return graph;
+}
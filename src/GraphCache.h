@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "RoadGraph.h"
+
+// Loads text graphs through a binary snapshot stored next to the nodes file.
+// The snapshot records the identity of both source files (path, size,
+// modification time and content hash) and is only used while all of them
+// still match; otherwise the text is parsed and the snapshot rewritten.
+class GraphCache {
+public:
+    struct SourceIdentity {
+        uint64_t pathHash;
+        uint64_t size;
+        int64_t modifiedTime;
+        uint64_t contentHash;
+
+        bool operator==(const SourceIdentity& other) const;
+    };
+
+    static std::unique_ptr<RoadGraph> load(const std::string& nodesFile, const std::string& edgesFile, const RoadGraph::BatchCallback& onBatch = nullptr);
+    static std::string getCacheFile(const std::string& nodesFile);
+    static bool getSourceIdentity(const std::string& filename, SourceIdentity& identity);
+};
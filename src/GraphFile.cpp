@@ -0,0 +1,196 @@
+#include "GraphFile.h"
+#include "RoadGraph.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace {
+    const char magic[8] = {'R', 'G', 'R', 'A', 'P', 'H', '\0', '\0'};
+    const uint32_t byteOrderMark = 0x01020304;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t sectionCount;
+        uint32_t headerSize;
+        float minCoords[3];
+        float maxCoords[3];
+        uint64_t fileSize;
+    };
+
+    uint64_t alignOffset(uint64_t offset) {
+        return (offset + GraphFile::sectionAlignment - 1) / GraphFile::sectionAlignment * GraphFile::sectionAlignment;
+    }
+
+    static_assert(std::is_trivially_copyable<Node>::value && sizeof(Node) == 12, "Node must be stored as three packed floats");
+    static_assert(std::is_trivially_copyable<Road>::value && sizeof(Road) == 28, "Road must be stored as a packed record");
+    static_assert(sizeof(glm::vec2) == 8, "Shape points must be stored as two packed floats");
+}
+
+/* CONSTRUCTORS */
+GraphFile::GraphFile(const std::string& filename): mapping(filename) {
+    if (!mapping.isOpen()) {
+        std::cerr << "Failed to open graph file: " << filename << std::endl;
+        return;
+    }
+
+    if (mapping.getSize() < sizeof(FileHeader)) {
+        std::cerr << "Graph file is truncated: " << filename << std::endl;
+        return;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, mapping.getData(), sizeof(header));
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        std::cerr << "Not a graph file: " << filename << std::endl;
+        return;
+    }
+    if (header.byteOrderMark != byteOrderMark) {
+        std::cerr << "Graph file was written with a different byte order: " << filename << std::endl;
+        return;
+    }
+    if (header.version != version) {
+        std::cerr << "Unsupported graph file version " << header.version << " (expected " << version << "): " << filename << std::endl;
+        return;
+    }
+
+    uint64_t tableEnd = header.headerSize + uint64_t(header.sectionCount) * sizeof(Section);
+    if (header.fileSize != mapping.getSize() || tableEnd > header.fileSize) {
+        std::cerr << "Graph file is truncated: " << filename << std::endl;
+        return;
+    }
+
+    sections.resize(header.sectionCount);
+    std::memcpy(sections.data(), mapping.getData() + header.headerSize, header.sectionCount * sizeof(Section));
+
+    for (const Section& section : sections) {
+        uint64_t bytes = section.count * section.elementSize;
+        if (section.offset % sectionAlignment != 0 || section.offset > header.fileSize || bytes > header.fileSize - section.offset) {
+            std::cerr << "Graph file has a corrupt section table: " << filename << std::endl;
+            sections.clear();
+            return;
+        }
+    }
+
+    minCoords = glm::vec3(header.minCoords[0], header.minCoords[1], header.minCoords[2]);
+    maxCoords = glm::vec3(header.maxCoords[0], header.maxCoords[1], header.maxCoords[2]);
+    valid = true;
+}
+
+
+/* METHODS */
+bool GraphFile::isGraphFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char buffer[sizeof(magic)];
+    if (!file.read(buffer, sizeof(buffer))) {
+        return false;
+    }
+    return std::memcmp(buffer, magic, sizeof(magic)) == 0;
+}
+
+bool GraphFile::write(const RoadGraph& graph, const std::string& filename, const std::vector<SectionData>& extraSections) {
+    const Column<Node>& nodes = graph.getNodes();
+    const Column<Road>& roads = graph.getRoads();
+    const Column<glm::vec2>& shapePoints = graph.getShapePoints();
+
+    std::vector<SectionData> contents = {
+        {NodesSection, sizeof(Node), nodes.size(), nodes.data()},
+        {RoadsSection, sizeof(Road), roads.size(), roads.data()},
+        {ShapePointsSection, sizeof(glm::vec2), shapePoints.size(), shapePoints.data()},
+    };
+    const Column<int>& externalIds = graph.getExternalIds();
+    if (!externalIds.empty()) {
+        contents.push_back({ExternalIdsSection, sizeof(int), externalIds.size(), externalIds.data()});
+    }
+    const Column<int>& externalIdOrder = graph.getExternalIdOrder();
+    if (!externalIdOrder.empty()) {
+        contents.push_back({ExternalIdOrderSection, sizeof(int), externalIdOrder.size(), externalIdOrder.data()});
+    }
+    contents.insert(contents.end(), extraSections.begin(), extraSections.end());
+
+    FileHeader header = {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrderMark = byteOrderMark;
+    header.sectionCount = static_cast<uint32_t>(contents.size());
+    header.headerSize = sizeof(FileHeader);
+
+    glm::vec3 minCoords = graph.getMinCoords();
+    glm::vec3 maxCoords = graph.getMaxCoords();
+    for (int i = 0; i < 3; ++i) {
+        header.minCoords[i] = minCoords[i];
+        header.maxCoords[i] = maxCoords[i];
+    }
+
+    std::vector<Section> table;
+    uint64_t offset = header.headerSize + contents.size() * sizeof(Section);
+    for (const SectionData& content : contents) {
+        offset = alignOffset(offset);
+        table.push_back({content.kind, content.elementSize, content.count, offset});
+        offset += content.count * content.elementSize;
+    }
+    header.fileSize = offset;
+
+    // Write next to the target and rename, so readers never map a partial file
+    std::string temporaryFile = filename + ".tmp";
+    std::ofstream file(temporaryFile, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to create graph file: " << temporaryFile << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(Section));
+
+    const char padding[sectionAlignment] = {};
+    uint64_t written = header.headerSize + table.size() * sizeof(Section);
+    for (size_t i = 0; i < contents.size(); ++i) {
+        file.write(padding, table[i].offset - written);
+        file.write(static_cast<const char*>(contents[i].data), contents[i].count * contents[i].elementSize);
+        written = table[i].offset + contents[i].count * contents[i].elementSize;
+    }
+
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write graph file: " << temporaryFile << std::endl;
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    if (std::rename(temporaryFile.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to move graph file into place: " << filename << std::endl;
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool GraphFile::getSectionExtent(SectionKind kind, uint32_t elementSize, uint64_t& offset, uint64_t& count) const {
+    const Section* section = findSection(kind);
+    if (!section || section->elementSize != elementSize) {
+        offset = 0;
+        count = 0;
+        return false;
+    }
+
+    offset = section->offset;
+    count = section->count;
+    return true;
+}
+
+const GraphFile::Section* GraphFile::findSection(SectionKind kind) const {
+    for (const Section& section : sections) {
+        if (section.kind == kind) {
+            return &section;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+
+class RoadGraph;
+
+// Versioned binary container for a RoadGraph. The file is a fixed header, a
+// section table and a list of 64-byte aligned sections, each holding a plain
+// array in native byte order, so sections can be used in place from a mapping.
+class GraphFile {
+public:
+    enum SectionKind : uint32_t {
+        NodesSection = 1,
+        RoadsSection = 2,
+        SourcesSection = 3,
+        ShapePointsSection = 4,
+        TilesSection = 5,
+        BoundaryNodesSection = 6,
+        ExternalIdsSection = 7,
+        ExternalIdOrderSection = 8,
+        LandmarksSection = 9,
+        LandmarkDistancesSection = 10,
+    };
+
+    struct Section {
+        uint32_t kind;
+        uint32_t elementSize;
+        uint64_t count;
+        uint64_t offset;
+    };
+
+    // Array handed to write() to be stored as a section
+    struct SectionData {
+        SectionKind kind;
+        uint32_t elementSize;
+        uint64_t count;
+        const void* data;
+    };
+
+    static constexpr uint32_t version = 3;
+    static constexpr uint64_t sectionAlignment = 64;
+
+    explicit GraphFile(const std::string& filename);
+
+    bool isValid() const { return valid; }
+    glm::vec3 getMinCoords() const { return minCoords; }
+    glm::vec3 getMaxCoords() const { return maxCoords; }
+
+    template<typename T>
+    bool getSection(SectionKind kind, const T*& data, size_t& count) const;
+
+    // Where a section lies in the file, for callers that read it piecewise
+    bool getSectionExtent(SectionKind kind, uint32_t elementSize, uint64_t& offset, uint64_t& count) const;
+
+    static bool isGraphFile(const std::string& filename);
+    static bool write(const RoadGraph& graph, const std::string& filename, const std::vector<SectionData>& extraSections = {});
+
+private:
+    MappedFile mapping;
+    std::vector<Section> sections;
+    glm::vec3 minCoords;
+    glm::vec3 maxCoords;
+    bool valid = false;
+
+    const Section* findSection(SectionKind kind) const;
+};
+
+template<typename T>
+bool GraphFile::getSection(SectionKind kind, const T*& data, size_t& count) const {
+    const Section* section = findSection(kind);
+    if (!section || section->elementSize != sizeof(T)) {
+        data = nullptr;
+        count = 0;
+        return false;
+    }
+
+    data = reinterpret_cast<const T*>(mapping.getData() + section->offset);
+    count = static_cast<size_t>(section->count);
+    return true;
+}
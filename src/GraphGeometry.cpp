@@ -0,0 +1,138 @@
+#include "GraphGeometry.h"
+#include "RoadGraph.h"
+#include <algorithm>
+
+namespace {
+    // Appends to the previous update when the vertices follow on from it, so runs of ids become one upload
+    void addUpdate(std::vector<GraphGeometry::Update>& updates, size_t firstVertex, const glm::vec3* positions, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (updates.empty() || updates.back().firstVertex + updates.back().positions.size() != firstVertex) {
+            updates.push_back({firstVertex, {}});
+        }
+        updates.back().positions.insert(updates.back().positions.end(), positions, positions + count);
+    }
+
+    bool isDrawn(const RoadGraph& graph, int road) {
+        if (!graph.roadExists(road)) {
+            return false;
+        }
+        const Road& value = graph.getRoadUnchecked(road);
+        return graph.nodeExists(value.from) && graph.nodeExists(value.to);
+    }
+}
+
+/* METHODS */
+void GraphGeometry::build(const RoadGraph& graph, std::vector<glm::vec3>& nodePositions, std::vector<glm::vec3>& roadSegments) {
+    const Column<Node>& nodes = graph.getNodes();
+    nodeSlots.assign(nodes.size(), -1);
+    slotNodes.clear();
+    nodePositions.clear();
+    for (size_t id = 0; id < nodes.size(); ++id) {
+        if (graph.nodeExists(static_cast<int>(id))) {
+            nodeSlots[id] = static_cast<int>(slotNodes.size());
+            slotNodes.push_back(static_cast<int>(id));
+            nodePositions.push_back(nodes[id].position);
+        }
+    }
+
+    const Column<Road>& roads = graph.getRoads();
+    roadSlots.assign(roads.size(), RoadSlot{0, 0, 0});
+    roadSegments.clear();
+    for (size_t id = 0; id < roads.size(); ++id) {
+        if (isDrawn(graph, static_cast<int>(id))) {
+            size_t first = roadSegments.size();
+            graph.appendRoadSegments(roads[id], roadSegments);
+            uint32_t count = static_cast<uint32_t>(roadSegments.size() - first);
+            roadSlots[id] = {static_cast<uint32_t>(first), count, count};
+        }
+    }
+    roadVertexCount = roadSegments.size();
+    unusedRoadVertices = 0;
+}
+
+void GraphGeometry::update(const RoadGraph& graph, const std::vector<DirtyRanges::Range>& nodeRanges,
+                           const std::vector<DirtyRanges::Range>& roadRanges, std::vector<Update>& nodeUpdates, std::vector<Update>& roadUpdates) {
+    nodeUpdates.clear();
+    roadUpdates.clear();
+
+    for (const DirtyRanges::Range& range : nodeRanges) {
+        for (int id = range.begin; id < range.end; ++id) {
+            updateNode(graph, id, nodeUpdates);
+        }
+    }
+
+    std::vector<glm::vec3> polyline;
+    for (const DirtyRanges::Range& range : roadRanges) {
+        for (int id = range.begin; id < range.end; ++id) {
+            updateRoad(graph, id, polyline, roadUpdates);
+        }
+    }
+}
+
+void GraphGeometry::updateNode(const RoadGraph& graph, int id, std::vector<Update>& updates) {
+    if (id < 0) {
+        return;
+    }
+    if (static_cast<size_t>(id) >= nodeSlots.size()) {
+        nodeSlots.resize(id + 1, -1);
+    }
+
+    int& slot = nodeSlots[id];
+    if (graph.nodeExists(id)) {
+        if (slot < 0) {
+            slot = static_cast<int>(slotNodes.size());
+            slotNodes.push_back(id);
+        }
+        addUpdate(updates, slot, &graph.getNodePositionUnchecked(id), 1);
+        return;
+    }
+    if (slot < 0) {
+        return;
+    }
+
+    // The last node moves into the freed slot, so the drawn range stays dense
+    int last = slotNodes.back();
+    slotNodes.pop_back();
+    if (last != id) {
+        slotNodes[slot] = last;
+        nodeSlots[last] = slot;
+        addUpdate(updates, slot, &graph.getNodePositionUnchecked(last), 1);
+    }
+    slot = -1;
+}
+
+void GraphGeometry::updateRoad(const RoadGraph& graph, int id, std::vector<glm::vec3>& polyline, std::vector<Update>& updates) {
+    if (id < 0) {
+        return;
+    }
+    if (static_cast<size_t>(id) >= roadSlots.size()) {
+        roadSlots.resize(id + 1, RoadSlot{0, 0, 0});
+    }
+
+    polyline.clear();
+    if (isDrawn(graph, id)) {
+        graph.appendRoadSegments(graph.getRoadUnchecked(id), polyline);
+    }
+
+    RoadSlot& slot = roadSlots[id];
+    unusedRoadVertices -= slot.capacity - slot.used;
+    if (polyline.size() > slot.capacity) {
+        // Too long for its slot: give the old one up and take a new one at the end
+        if (slot.capacity > 0) {
+            std::vector<glm::vec3> collapsed(slot.capacity, glm::vec3(0.0f));
+            addUpdate(updates, slot.first, collapsed.data(), collapsed.size());
+            unusedRoadVertices += slot.capacity;
+        }
+        slot.first = static_cast<uint32_t>(roadVertexCount);
+        slot.capacity = static_cast<uint32_t>(polyline.size());
+        roadVertexCount += polyline.size();
+    }
+    slot.used = static_cast<uint32_t>(polyline.size());
+    unusedRoadVertices += slot.capacity - slot.used;
+
+    // Padding repeats the last point, or the origin once the road is gone
+    polyline.resize(slot.capacity, polyline.empty() ? glm::vec3(0.0f) : polyline.back());
+    addUpdate(updates, slot.first, polyline.data(), polyline.size());
+}
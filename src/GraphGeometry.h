@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "DirtyRanges.h"
+
+class RoadGraph;
+
+// Where each node and road of a graph sits in the node and road vertex
+// buffers, so edits are drawn by rewriting only their own vertices. Nodes are
+// packed densely and a removed node's slot is taken over by the last one.
+// Roads keep their slot while their polyline fits; the unused tail and the
+// slots of removed roads become zero-length segments, which draw nothing.
+class GraphGeometry {
+public:
+    // Vertices to write over a buffer from firstVertex on; writes past the
+    // current end grow it
+    struct Update {
+        size_t firstVertex;
+        std::vector<glm::vec3> positions;
+    };
+
+    // Lays out the whole graph without gaps; the results replace the buffers' contents
+    void build(const RoadGraph& graph, std::vector<glm::vec3>& nodePositions, std::vector<glm::vec3>& roadSegments);
+    // Lays out the given ids again, in the order the updates must be applied
+    void update(const RoadGraph& graph, const std::vector<DirtyRanges::Range>& nodeRanges,
+                const std::vector<DirtyRanges::Range>& roadRanges, std::vector<Update>& nodeUpdates, std::vector<Update>& roadUpdates);
+
+    size_t getNodeVertexCount() const { return slotNodes.size(); }
+    size_t getRoadVertexCount() const { return roadVertexCount; }
+    // True once more road vertices are padding than polyline, when a fresh build pays off
+    bool needsCompaction() const { return unusedRoadVertices > roadVertexCount / 2; }
+
+private:
+    struct RoadSlot {
+        uint32_t first;
+        uint32_t capacity;
+        uint32_t used;
+    };
+
+    // Slot of each node id, -1 for nodes that are not drawn, and the reverse
+    std::vector<int> nodeSlots;
+    std::vector<int> slotNodes;
+    std::vector<RoadSlot> roadSlots;
+    size_t roadVertexCount = 0;
+    size_t unusedRoadVertices = 0;
+
+    void updateNode(const RoadGraph& graph, int id, std::vector<Update>& updates);
+    void updateRoad(const RoadGraph& graph, int id, std::vector<glm::vec3>& polyline, std::vector<Update>& updates);
+};
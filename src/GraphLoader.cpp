@@ -0,0 +1,61 @@
+#include "GraphLoader.h"
+#include <iostream>
+
+/* CONSTRUCTORS */
+GraphLoader::GraphLoader(LoadFunction load) {
+    worker = std::thread([this, load = std::move(load)]() {
+        RoadGraph::BatchCallback queueBatch = [this](GraphBatch&& batch) {
+            std::lock_guard<std::mutex> lock(mutex);
+            pendingBatches.push_back(std::move(batch));
+        };
+
+        std::unique_ptr<RoadGraph> graph;
+        try {
+            graph = load(queueBatch);
+        } catch (const std::exception& exception) {
+            std::cerr << "Failed to load graph: " << exception.what() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        loadedGraph = std::move(graph);
+        finished = true;
+    });
+}
+
+GraphLoader::~GraphLoader() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+
+/* METHODS */
+void GraphLoader::poll(const RoadGraph::BatchCallback& onBatch, const CompleteCallback& onComplete) {
+    std::vector<GraphBatch> batches;
+    std::unique_ptr<RoadGraph> graph;
+    bool complete = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.swap(pendingBatches);
+        if (finished && !delivered) {
+            graph = std::move(loadedGraph);
+            complete = true;
+            delivered = true;
+        }
+    }
+
+    for (GraphBatch& batch : batches) {
+        onBatch(std::move(batch));
+    }
+
+    if (complete) {
+        worker.join();
+        onComplete(std::move(graph));
+    }
+}
+
+bool GraphLoader::isLoading() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !delivered;
+}
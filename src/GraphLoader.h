@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "RoadGraph.h"
+
+// Loads a RoadGraph on a worker thread. Batches produced while loading are
+// queued and handed to the render thread by poll(), followed by the finished
+// graph once the worker is done.
+class GraphLoader {
+public:
+    using LoadFunction = std::function<std::unique_ptr<RoadGraph>(const RoadGraph::BatchCallback&)>;
+    using CompleteCallback = std::function<void(std::unique_ptr<RoadGraph>)>;
+
+    explicit GraphLoader(LoadFunction load);
+    ~GraphLoader();
+
+    // Call from the render thread; runs the callbacks on the calling thread
+    void poll(const RoadGraph::BatchCallback& onBatch, const CompleteCallback& onComplete);
+    bool isLoading() const;
+
+private:
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::vector<GraphBatch> pendingBatches;
+    std::unique_ptr<RoadGraph> loadedGraph;
+    bool finished = false;
+    bool delivered = false;
+
+    GraphLoader(const GraphLoader&) = delete;
+    GraphLoader& operator=(const GraphLoader&) = delete;
+};
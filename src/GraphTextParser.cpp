@@ -0,0 +1,221 @@
+#include "GraphTextParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    const size_t minimumChunkSize = 1 << 20;
+    const size_t chunksPerWorker = 4;
+    const size_t reportedBadLines = 5;
+
+    struct BadLine {
+        size_t line;
+        std::string text;
+    };
+
+    template<typename Record>
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        std::vector<Record> records;
+        std::vector<glm::vec2> shapePoints;
+        size_t lineCount = 0;
+        size_t badLineCount = 0;
+        std::vector<BadLine> badLines;
+    };
+
+    const char* skipBlanks(const char* position, const char* end) {
+        while (position < end && (*position == ' ' || *position == '\t')) {
+            ++position;
+        }
+        return position;
+    }
+
+    template<typename T>
+    bool readValue(const char*& position, const char* end, T& value) {
+        position = skipBlanks(position, end);
+        auto result = std::from_chars(position, end, value);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        position = result.ptr;
+        return true;
+    }
+
+    bool parseNodeLine(const char* position, const char* end, GraphTextParser::NodeRecord& record, std::vector<glm::vec2>&) {
+        return readValue(position, end, record.id) &&
+               readValue(position, end, record.position.x) &&
+               readValue(position, end, record.position.y) &&
+               readValue(position, end, record.position.z);
+    }
+
+    bool parseEdgeLine(const char* position, const char* end, GraphTextParser::EdgeRecord& record, std::vector<glm::vec2>& shapePoints) {
+        if (!readValue(position, end, record.from) ||
+            !readValue(position, end, record.to) ||
+            !readValue(position, end, record.meters) ||
+            !readValue(position, end, record.maxSpeed) ||
+            !readValue(position, end, record.lanes) ||
+            !readValue(position, end, record.oneWay)) {
+            return false;
+        }
+
+        size_t shapeBegin = shapePoints.size();
+        while (skipBlanks(position, end) != end) {
+            glm::vec2 point;
+            if (!readValue(position, end, point.x) || !readValue(position, end, point.y)) {
+                shapePoints.resize(shapeBegin);
+                return false;
+            }
+            shapePoints.push_back(point);
+        }
+        record.shapeBegin = static_cast<uint32_t>(shapeBegin);
+        record.shapeCount = static_cast<uint32_t>(shapePoints.size() - shapeBegin);
+        return true;
+    }
+
+    void offsetShape(GraphTextParser::NodeRecord&, uint32_t) {}
+
+    void offsetShape(GraphTextParser::EdgeRecord& record, uint32_t offset) {
+        record.shapeBegin += offset;
+    }
+
+    // Moves position forward to the start of the next line
+    const char* nextLineStart(const char* position, const char* begin, const char* end) {
+        if (position <= begin) {
+            return begin;
+        }
+        if (position >= end) {
+            return end;
+        }
+        const char* newline = static_cast<const char*>(std::memchr(position - 1, '\n', end - position + 1));
+        return newline ? newline + 1 : end;
+    }
+}
+
+/* CONSTRUCTORS */
+GraphTextParser::GraphTextParser(size_t workerCount): workerCount(workerCount == 0 ? getWorkerCount() : workerCount) {}
+
+
+/* METHODS */
+bool GraphTextParser::parseNodes(const std::string& filename, std::vector<NodeRecord>& records, const NodeChunkCallback& onChunk) const {
+    std::vector<glm::vec2> shapePoints;
+    std::function<void(const std::vector<NodeRecord>&, const std::vector<glm::vec2>&)> onNodeChunk;
+    if (onChunk) {
+        onNodeChunk = [&onChunk](const std::vector<NodeRecord>& chunkRecords, const std::vector<glm::vec2>&) { onChunk(chunkRecords); };
+    }
+    return parseFile(filename, "node", records, shapePoints, parseNodeLine, onNodeChunk);
+}
+
+bool GraphTextParser::parseEdges(const std::string& filename, std::vector<EdgeRecord>& records, std::vector<glm::vec2>& shapePoints,
+                                 const EdgeChunkCallback& onChunk) const {
+    return parseFile(filename, "edge", records, shapePoints, parseEdgeLine, onChunk);
+}
+
+template<typename Record, typename ParseLine>
+bool GraphTextParser::parseFile(const std::string& filename, const char* kind, std::vector<Record>& records, std::vector<glm::vec2>& shapePoints,
+                                ParseLine parseLine, const std::function<void(const std::vector<Record>&, const std::vector<glm::vec2>&)>& onChunk) const {
+    records.clear();
+    shapePoints.clear();
+
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Failed to open " << kind << "s file: " << filename << std::endl;
+        return false;
+    }
+    file.adviseSequential();
+
+    const char* begin = file.getData();
+    const char* end = begin + file.getSize();
+
+    // Split into newline-aligned chunks, several per worker to absorb uneven lines
+    size_t chunkSize = std::max(minimumChunkSize, file.getSize() / (workerCount * chunksPerWorker) + 1);
+    std::vector<Chunk<Record>> chunks;
+    for (const char* chunkBegin = begin; chunkBegin < end;) {
+        const char* chunkEnd = nextLineStart(chunkBegin + std::min<size_t>(chunkSize, end - chunkBegin), begin, end);
+        chunks.emplace_back();
+        chunks.back().begin = chunkBegin;
+        chunks.back().end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    parallelFor(chunks.size(), [&](size_t index) {
+        Chunk<Record>& chunk = chunks[index];
+        chunk.records.reserve((chunk.end - chunk.begin) / 32);
+
+        for (const char* lineBegin = chunk.begin; lineBegin < chunk.end;) {
+            const char* newline = static_cast<const char*>(std::memchr(lineBegin, '\n', chunk.end - lineBegin));
+            const char* lineEnd = newline ? newline : chunk.end;
+            const char* nextLine = newline ? newline + 1 : chunk.end;
+            if (lineEnd > lineBegin && lineEnd[-1] == '\r') {
+                --lineEnd;
+            }
+
+            ++chunk.lineCount;
+            if (skipBlanks(lineBegin, lineEnd) != lineEnd) {
+                Record record;
+                if (parseLine(lineBegin, lineEnd, record, chunk.shapePoints)) {
+                    chunk.records.push_back(record);
+                } else {
+                    if (chunk.badLines.size() < reportedBadLines) {
+                        chunk.badLines.push_back({chunk.lineCount, std::string(lineBegin, lineEnd)});
+                    }
+                    ++chunk.badLineCount;
+                }
+            }
+
+            lineBegin = nextLine;
+        }
+
+        if (onChunk) {
+            onChunk(chunk.records, chunk.shapePoints);
+        }
+    }, workerCount);
+
+    // Concatenate in file order so record order matches a sequential parse
+    std::vector<size_t> recordOffsets(chunks.size() + 1, 0);
+    std::vector<size_t> shapeOffsets(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        recordOffsets[i + 1] = recordOffsets[i] + chunks[i].records.size();
+        shapeOffsets[i + 1] = shapeOffsets[i] + chunks[i].shapePoints.size();
+    }
+
+    records.resize(recordOffsets.back());
+    shapePoints.resize(shapeOffsets.back());
+    parallelFor(chunks.size(), [&](size_t index) {
+        Chunk<Record>& chunk = chunks[index];
+        auto output = records.begin() + recordOffsets[index];
+        for (Record& record : chunk.records) {
+            offsetShape(record, static_cast<uint32_t>(shapeOffsets[index]));
+            *output++ = record;
+        }
+        std::copy(chunk.shapePoints.begin(), chunk.shapePoints.end(), shapePoints.begin() + shapeOffsets[index]);
+        std::vector<Record>().swap(chunk.records);
+        std::vector<glm::vec2>().swap(chunk.shapePoints);
+    }, workerCount);
+
+    // Report malformed lines in aggregate, with file line numbers for the first few
+    size_t badLineCount = 0;
+    size_t lineOffset = 0;
+    std::vector<BadLine> samples;
+    for (const Chunk<Record>& chunk : chunks) {
+        badLineCount += chunk.badLineCount;
+        for (const BadLine& badLine : chunk.badLines) {
+            if (samples.size() < reportedBadLines) {
+                samples.push_back({lineOffset + badLine.line, badLine.text});
+            }
+        }
+        lineOffset += chunk.lineCount;
+    }
+
+    if (badLineCount > 0) {
+        std::cerr << "Failed to parse " << badLineCount << " " << kind << " line(s) in " << filename << std::endl;
+        for (const BadLine& sample : samples) {
+            std::cerr << "  line " << sample.line << ": " << sample.text << std::endl;
+        }
+    }
+
+    return true;
+}
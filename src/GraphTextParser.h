@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Parses nodes.txt and edges.txt on all cores. The file is mapped, split into
+// newline-aligned chunks that are parsed independently with std::from_chars,
+// and the chunk results are concatenated in file order, so the output is the
+// same as a sequential parse. Malformed lines are skipped and reported once per
+// file instead of once per line.
+class GraphTextParser {
+public:
+    struct NodeRecord {
+        int id;
+        glm::vec3 position;
+    };
+
+    // Edge lines may end in x y pairs, the points of the road between its end nodes
+    struct EdgeRecord {
+        int from, to;
+        float meters;
+        float maxSpeed;
+        int lanes;
+        int oneWay;
+        uint32_t shapeBegin;
+        uint32_t shapeCount;
+    };
+
+    // Called with the records of each chunk as soon as it is parsed, from the
+    // worker that parsed it, so several calls may run at once. Shape ranges of
+    // the edge records index into the chunk's own shape points.
+    using NodeChunkCallback = std::function<void(const std::vector<NodeRecord>&)>;
+    using EdgeChunkCallback = std::function<void(const std::vector<EdgeRecord>&, const std::vector<glm::vec2>& shapePoints)>;
+
+    explicit GraphTextParser(size_t workerCount = 0);
+
+    bool parseNodes(const std::string& filename, std::vector<NodeRecord>& records, const NodeChunkCallback& onChunk = nullptr) const;
+    bool parseEdges(const std::string& filename, std::vector<EdgeRecord>& records, std::vector<glm::vec2>& shapePoints,
+                    const EdgeChunkCallback& onChunk = nullptr) const;
+
+private:
+    size_t workerCount;
+
+    template<typename Record, typename ParseLine>
+    bool parseFile(const std::string& filename, const char* kind, std::vector<Record>& records, std::vector<glm::vec2>& shapePoints,
+                   ParseLine parseLine, const std::function<void(const std::vector<Record>&, const std::vector<glm::vec2>&)>& onChunk) const;
+};
@@ -0,0 +1,322 @@
+#include "GraphTiles.h"
+#include "GraphFile.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+namespace {
+    static_assert(sizeof(GraphTiles::Tile) == 48, "Tile must be stored as a packed record");
+    static_assert(sizeof(GraphTiles::BoundaryNode) == 16, "Boundary node must be stored as a packed record");
+
+    bool intersects(const GraphTiles::Tile& tile, glm::vec2 minCoords, glm::vec2 maxCoords) {
+        return tile.minCoords.x <= maxCoords.x && tile.maxCoords.x >= minCoords.x &&
+               tile.minCoords.y <= maxCoords.y && tile.maxCoords.y >= minCoords.y;
+    }
+
+    size_t getTileBytes(const GraphTiles::Tile& tile) {
+        return tile.nodeCount * sizeof(Node) + tile.roadCount * sizeof(Road) + tile.shapeCount * sizeof(glm::vec2) +
+               tile.boundaryCount * sizeof(GraphTiles::BoundaryNode);
+    }
+
+    bool contains(uint64_t count, uint32_t begin, uint32_t length) {
+        return uint64_t(begin) + length <= count;
+    }
+}
+
+/* CONSTRUCTORS */
+GraphTiles::GraphTiles(const std::string& filename, size_t memoryBudget): filename(filename), memoryBudget(memoryBudget) {
+    // The mapping is only used to check the file and copy the tile table;
+    // tiles are read into memory of their own so eviction really frees them
+    {
+        GraphFile graphFile(filename);
+        if (!graphFile.isValid()) {
+            return;
+        }
+
+        const Tile* tileTable;
+        size_t tileCount;
+        if (!graphFile.getSection(GraphFile::TilesSection, tileTable, tileCount) ||
+            !graphFile.getSectionExtent(GraphFile::NodesSection, sizeof(Node), nodeExtent.offset, nodeExtent.count) ||
+            !graphFile.getSectionExtent(GraphFile::RoadsSection, sizeof(Road), roadExtent.offset, roadExtent.count) ||
+            !graphFile.getSectionExtent(GraphFile::ShapePointsSection, sizeof(glm::vec2), shapeExtent.offset, shapeExtent.count) ||
+            !graphFile.getSectionExtent(GraphFile::BoundaryNodesSection, sizeof(BoundaryNode), boundaryExtent.offset, boundaryExtent.count)) {
+            std::cerr << "Not a tiled graph file: " << filename << std::endl;
+            return;
+        }
+
+        tiles.assign(tileTable, tileTable + tileCount);
+        minCoords = graphFile.getMinCoords();
+        maxCoords = graphFile.getMaxCoords();
+    }
+
+    for (const Tile& tile : tiles) {
+        if (!contains(nodeExtent.count, tile.nodeBegin, tile.nodeCount) || !contains(roadExtent.count, tile.roadBegin, tile.roadCount) ||
+            !contains(shapeExtent.count, tile.shapeBegin, tile.shapeCount) ||
+            !contains(boundaryExtent.count, tile.boundaryBegin, tile.boundaryCount)) {
+            std::cerr << "Tiled graph file has a corrupt tile table: " << filename << std::endl;
+            return;
+        }
+    }
+
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open tiled graph file: " << filename << std::endl;
+        return;
+    }
+
+    tileData.resize(tiles.size());
+    valid = true;
+}
+
+GraphTiles::~GraphTiles() = default;
+
+
+/* METHODS */
+bool GraphTiles::update(glm::vec2 viewMin, glm::vec2 viewMax) {
+    if (!valid) {
+        return false;
+    }
+
+    glm::vec2 viewCenter = (viewMin + viewMax) * 0.5f;
+    std::vector<std::pair<float, uint32_t>> candidates;
+    for (uint32_t index = 0; index < tiles.size(); ++index) {
+        if (intersects(tiles[index], viewMin, viewMax)) {
+            glm::vec2 tileCenter = (tiles[index].minCoords + tiles[index].maxCoords) * 0.5f;
+            candidates.emplace_back(glm::distance(tileCenter, viewCenter), index);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // A view wider than the budget shows the tiles around its center; at
+    // least one tile is always shown
+    ++clock;
+    std::vector<uint32_t> visible;
+    size_t visibleBytes = 0;
+    for (const auto& candidate : candidates) {
+        uint32_t index = candidate.second;
+        std::unique_ptr<TileData>& data = tileData[index];
+        size_t bytes = data ? data->bytes : getTileBytes(tiles[index]);
+        if (!visible.empty() && visibleBytes + bytes > memoryBudget) {
+            break;
+        }
+
+        if (!data) {
+            data = readTile(tiles[index]);
+            if (!data) {
+                continue;
+            }
+            residentTiles.push_back(index);
+            residentBytes += data->bytes;
+        }
+        data->lastUsed = clock;
+        visibleBytes += data->bytes;
+        visible.push_back(index);
+    }
+    evict();
+
+    std::sort(visible.begin(), visible.end());
+    if (visible == visibleTiles) {
+        return false;
+    }
+    visibleTiles.swap(visible);
+    return true;
+}
+
+void GraphTiles::buildBatch(GraphBatch& batch) const {
+    for (uint32_t index : visibleTiles) {
+        const Tile& tile = tiles[index];
+        const TileData& data = *tileData[index];
+
+        auto findPosition = [&](int id) -> const glm::vec3* {
+            if (id >= static_cast<int64_t>(tile.nodeBegin) && id < static_cast<int64_t>(tile.nodeBegin) + tile.nodeCount) {
+                return &data.nodes[id - tile.nodeBegin].position;
+            }
+            auto boundary = std::lower_bound(data.boundaryNodes.begin(), data.boundaryNodes.end(), id,
+                                             [](const BoundaryNode& node, int value) { return node.id < value; });
+            return boundary != data.boundaryNodes.end() && boundary->id == id ? &boundary->position : nullptr;
+        };
+
+        for (const Node& node : data.nodes) {
+            batch.nodePositions.push_back(node.position);
+        }
+        for (const Road& road : data.roads) {
+            const glm::vec3* from = findPosition(road.from);
+            const glm::vec3* to = findPosition(road.to);
+            if (!from || !to) {
+                continue;
+            }
+
+            // Shape ranges are file-wide; a range outside the tile is drawn straight
+            size_t count = road.shapeCount;
+            size_t begin = road.shapeBegin - tile.shapeBegin;
+            if (road.shapeBegin < tile.shapeBegin || begin > data.shapePoints.size() || count > data.shapePoints.size() - begin) {
+                begin = 0;
+                count = 0;
+            }
+            RoadGraph::appendPolyline(batch.roadSegments, *from, *to, data.shapePoints.data() + begin, count, false);
+        }
+    }
+}
+
+std::unique_ptr<GraphTiles::TileData> GraphTiles::readTile(const Tile& tile) {
+    auto data = std::make_unique<TileData>();
+    if (!readRange(nodeExtent, tile.nodeBegin, tile.nodeCount, data->nodes) ||
+        !readRange(roadExtent, tile.roadBegin, tile.roadCount, data->roads) ||
+        !readRange(shapeExtent, tile.shapeBegin, tile.shapeCount, data->shapePoints) ||
+        !readRange(boundaryExtent, tile.boundaryBegin, tile.boundaryCount, data->boundaryNodes)) {
+        std::cerr << "Failed to read a tile of " << filename << std::endl;
+        file.clear();
+        return nullptr;
+    }
+    data->bytes = getTileBytes(tile);
+    return data;
+}
+
+template<typename T>
+bool GraphTiles::readRange(const Extent& extent, uint32_t begin, uint32_t count, std::vector<T>& values) {
+    values.resize(count);
+    if (count == 0) {
+        return true;
+    }
+    file.seekg(static_cast<std::streamoff>(extent.offset + uint64_t(begin) * sizeof(T)));
+    file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(file);
+}
+
+// Drops the least recently used tiles that are not visible until the
+// resident set fits the budget again
+void GraphTiles::evict() {
+    if (residentBytes <= memoryBudget) {
+        return;
+    }
+
+    std::vector<uint32_t> cold;
+    for (uint32_t index : residentTiles) {
+        if (tileData[index]->lastUsed != clock) {
+            cold.push_back(index);
+        }
+    }
+    std::sort(cold.begin(), cold.end(), [this](uint32_t a, uint32_t b) { return tileData[a]->lastUsed < tileData[b]->lastUsed; });
+
+    for (uint32_t index : cold) {
+        if (residentBytes <= memoryBudget) {
+            break;
+        }
+        residentBytes -= tileData[index]->bytes;
+        tileData[index].reset();
+    }
+    residentTiles.erase(std::remove_if(residentTiles.begin(), residentTiles.end(), [this](uint32_t index) { return !tileData[index]; }),
+                        residentTiles.end());
+}
+
+bool GraphTiles::write(const RoadGraph& graph, const std::string& filename, float tileSize) {
+    if (!(tileSize > 0.0f)) {
+        std::cerr << "Invalid tile size: " << tileSize << std::endl;
+        return false;
+    }
+
+    const Column<Node>& nodes = graph.getNodes();
+    const Column<Road>& roads = graph.getRoads();
+    const Column<glm::vec2>& shapePoints = graph.getShapePoints();
+
+    glm::vec3 minCoords = graph.getMinCoords();
+    glm::vec3 maxCoords = graph.getMaxCoords();
+    uint64_t columns = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil((maxCoords.x - minCoords.x) / tileSize)));
+    auto getTileKey = [&](const glm::vec3& position) {
+        uint64_t column = std::min<uint64_t>(columns - 1, static_cast<uint64_t>(std::max(0.0f, (position.x - minCoords.x) / tileSize)));
+        uint64_t row = static_cast<uint64_t>(std::max(0.0f, (position.y - minCoords.y) / tileSize));
+        return row * columns + column;
+    };
+
+    // Renumber nodes tile by tile, keeping the source order within a tile
+    std::vector<std::pair<uint64_t, uint32_t>> nodeOrder;
+    for (size_t id = 0; id < nodes.size(); ++id) {
+        if (graph.nodeExists(static_cast<int>(id))) {
+            nodeOrder.emplace_back(getTileKey(nodes[id].position), static_cast<uint32_t>(id));
+        }
+    }
+    std::sort(nodeOrder.begin(), nodeOrder.end());
+
+    std::vector<int> newIds(nodes.size(), -1);
+    std::vector<Node> nodeValues;
+    nodeValues.reserve(nodeOrder.size());
+    for (const auto& entry : nodeOrder) {
+        newIds[entry.second] = static_cast<int>(nodeValues.size());
+        nodeValues.push_back(nodes[entry.second]);
+    }
+
+    // Each road goes to the tile of its start node
+    std::vector<std::pair<int, uint32_t>> roadOrder;
+    for (size_t id = 0; id < roads.size(); ++id) {
+        const Road& road = roads[id];
+        if (graph.roadExists(static_cast<int>(id)) && graph.nodeExists(road.from) && graph.nodeExists(road.to)) {
+            roadOrder.emplace_back(newIds[road.from], static_cast<uint32_t>(id));
+        }
+    }
+    std::stable_sort(roadOrder.begin(), roadOrder.end(), [&](const auto& a, const auto& b) {
+        return nodeOrder[a.first].first < nodeOrder[b.first].first;
+    });
+
+    std::vector<Tile> tileValues;
+    std::vector<Road> roadValues;
+    std::vector<glm::vec2> shapeValues;
+    std::vector<BoundaryNode> boundaryValues;
+    roadValues.reserve(roadOrder.size());
+
+    size_t nextRoad = 0;
+    for (size_t nodeIndex = 0; nodeIndex < nodeOrder.size();) {
+        uint64_t key = nodeOrder[nodeIndex].first;
+        Tile tile = {};
+        tile.minCoords = glm::vec2(std::numeric_limits<float>::max());
+        tile.maxCoords = glm::vec2(-std::numeric_limits<float>::max());
+        tile.nodeBegin = static_cast<uint32_t>(nodeIndex);
+        tile.roadBegin = static_cast<uint32_t>(roadValues.size());
+        tile.shapeBegin = static_cast<uint32_t>(shapeValues.size());
+        tile.boundaryBegin = static_cast<uint32_t>(boundaryValues.size());
+
+        auto include = [&tile](glm::vec2 position) {
+            tile.minCoords = glm::min(tile.minCoords, position);
+            tile.maxCoords = glm::max(tile.maxCoords, position);
+        };
+
+        for (; nodeIndex < nodeOrder.size() && nodeOrder[nodeIndex].first == key; ++nodeIndex) {
+            include(glm::vec2(nodeValues[nodeIndex].position));
+        }
+        tile.nodeCount = static_cast<uint32_t>(nodeIndex) - tile.nodeBegin;
+
+        for (; nextRoad < roadOrder.size() && static_cast<size_t>(roadOrder[nextRoad].first) < nodeIndex; ++nextRoad) {
+            Road road = roads[roadOrder[nextRoad].second];
+            road.from = newIds[road.from];
+            road.to = newIds[road.to];
+            include(glm::vec2(nodeValues[road.to].position));
+            roadValues.push_back(road);
+
+            if (road.to < static_cast<int>(tile.nodeBegin) || road.to >= static_cast<int>(nodeIndex)) {
+                boundaryValues.push_back({road.to, nodeValues[road.to].position});
+            }
+        }
+        tile.roadCount = static_cast<uint32_t>(roadValues.size()) - tile.roadBegin;
+
+        // Shape ranges shared by several roads stay shared within a tile
+        RoadGraph::compactShapes(roadValues, shapePoints.data(), shapePoints.size(), shapeValues, tile.roadBegin);
+        for (size_t i = tile.shapeBegin; i < shapeValues.size(); ++i) {
+            include(shapeValues[i]);
+        }
+        tile.shapeCount = static_cast<uint32_t>(shapeValues.size()) - tile.shapeBegin;
+
+        auto boundaryBegin = boundaryValues.begin() + tile.boundaryBegin;
+        std::sort(boundaryBegin, boundaryValues.end(), [](const BoundaryNode& a, const BoundaryNode& b) { return a.id < b.id; });
+        boundaryValues.erase(std::unique(boundaryBegin, boundaryValues.end(), [](const BoundaryNode& a, const BoundaryNode& b) { return a.id == b.id; }),
+                             boundaryValues.end());
+        tile.boundaryCount = static_cast<uint32_t>(boundaryValues.size()) - tile.boundaryBegin;
+        tileValues.push_back(tile);
+    }
+
+    RoadGraph tiled(std::move(nodeValues), std::move(roadValues), std::move(shapeValues));
+    return GraphFile::write(tiled, filename, {
+        {GraphFile::TilesSection, sizeof(Tile), tileValues.size(), tileValues.data()},
+        {GraphFile::BoundaryNodesSection, sizeof(BoundaryNode), boundaryValues.size(), boundaryValues.data()},
+    });
+}
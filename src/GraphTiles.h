@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "RoadGraph.h"
+
+// Tiled storage for graphs too large to keep resident. A tiled graph file is
+// an ordinary graph file whose nodes are renumbered tile by tile on a uniform
+// grid, with each road stored in the tile of its start node, so every tile is
+// one contiguous range of each column. Two extra sections hold the tile table
+// and, per tile, copies of the nodes its roads end at in other tiles, so a
+// tile can be drawn on its own.
+//
+// Only the tile table stays in memory. Tiles around the view are read in on
+// demand; tiles that are no longer visible stay cached until the memory
+// budget is exceeded and are then evicted least recently used first.
+class GraphTiles {
+public:
+    struct Tile {
+        // Bounds of everything drawn for the tile, including roads leaving it
+        glm::vec2 minCoords;
+        glm::vec2 maxCoords;
+        uint32_t nodeBegin, nodeCount;
+        uint32_t roadBegin, roadCount;
+        uint32_t shapeBegin, shapeCount;
+        uint32_t boundaryBegin, boundaryCount;
+    };
+
+    // Node of another tile that a road of this tile ends at
+    struct BoundaryNode {
+        int id;
+        glm::vec3 position;
+    };
+
+    GraphTiles(const std::string& filename, size_t memoryBudget);
+    ~GraphTiles();
+
+    bool isValid() const { return valid; }
+
+    // Reads the tiles intersecting the rectangle, nearest to its center first
+    // while they fit the budget, and evicts cold tiles over budget. Returns
+    // true if the set of visible tiles changed.
+    bool update(glm::vec2 viewMin, glm::vec2 viewMax);
+    // Render geometry of the visible tiles
+    void buildBatch(GraphBatch& batch) const;
+
+    glm::vec3 getCenter() const { return (minCoords + maxCoords) / 2.0f; }
+    float getRadius() const { return glm::distance(getCenter(), maxCoords); }
+    size_t getTileCount() const { return tiles.size(); }
+    size_t getVisibleTileCount() const { return visibleTiles.size(); }
+    size_t getResidentTileCount() const { return residentTiles.size(); }
+    size_t getResidentBytes() const { return residentBytes; }
+
+    static bool write(const RoadGraph& graph, const std::string& filename, float tileSize);
+
+private:
+    struct TileData {
+        std::vector<Node> nodes;
+        std::vector<Road> roads;
+        std::vector<glm::vec2> shapePoints;
+        std::vector<BoundaryNode> boundaryNodes;
+        uint64_t lastUsed = 0;
+        size_t bytes = 0;
+    };
+
+    // File offsets of the tiled columns
+    struct Extent {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    std::ifstream file;
+    std::string filename;
+    std::vector<Tile> tiles;
+    Extent nodeExtent, roadExtent, shapeExtent, boundaryExtent;
+    glm::vec3 minCoords, maxCoords;
+    size_t memoryBudget;
+    bool valid = false;
+
+    std::vector<std::unique_ptr<TileData>> tileData;
+    std::vector<uint32_t> visibleTiles;
+    std::vector<uint32_t> residentTiles;
+    size_t residentBytes = 0;
+    uint64_t clock = 0;
+
+    GraphTiles(const GraphTiles&) = delete;
+    GraphTiles& operator=(const GraphTiles&) = delete;
+
+    std::unique_ptr<TileData> readTile(const Tile& tile);
+    template<typename T>
+    bool readRange(const Extent& extent, uint32_t begin, uint32_t count, std::vector<T>& values);
+    void evict();
+};
@@ -0,0 +1,259 @@
+#include "Landmarks.h"
+#include "Dijkstra.h"
+#include "Parallel.h"
+#include "RoadGraph.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+namespace {
+    // Node with the largest travel time that is not unreachable, -1 if none
+    int findFarthest(const std::vector<uint32_t>& travelTimes) {
+        int farthest = -1;
+        for (size_t node = 0; node < travelTimes.size(); ++node) {
+            if (travelTimes[node] != RoadColumns::unreachable && (farthest < 0 || travelTimes[node] > travelTimes[farthest])) {
+                farthest = static_cast<int>(node);
+            }
+        }
+        return farthest;
+    }
+
+    std::vector<int> getExistingNodes(const RoadGraph& graph) {
+        std::vector<int> nodes;
+        for (size_t id = 0; id < graph.getNodes().size(); ++id) {
+            if (graph.nodeExists(static_cast<int>(id))) {
+                nodes.push_back(static_cast<int>(id));
+            }
+        }
+        return nodes;
+    }
+
+    std::vector<int> selectFarthest(const RoadGraph& graph, size_t count) {
+        std::vector<int> existing = getExistingNodes(graph);
+        size_t nodeCount = graph.getNodes().size();
+        std::mt19937 random(5);
+        Dijkstra dijkstra(graph);
+
+        // Closest landmark's travel time to every node, starting from a random node as if it were one
+        std::vector<uint32_t> closest(nodeCount, RoadColumns::unreachable);
+        std::vector<int> selected;
+        int next = existing[random() % existing.size()];
+        for (bool seeding = true; selected.size() < count; seeding = false) {
+            dijkstra.searchFrom(next);
+            std::vector<uint32_t> reached(nodeCount);
+            for (size_t node = 0; node < nodeCount; ++node) {
+                reached[node] = dijkstra.getTravelTime(static_cast<int>(node));
+            }
+            if (seeding) {
+                closest = reached;
+            } else {
+                for (size_t node = 0; node < nodeCount; ++node) {
+                    closest[node] = std::min(closest[node], reached[node]);
+                }
+            }
+
+            next = findFarthest(closest);
+            if (next < 0 || closest[next] == 0) {
+                break;
+            }
+            selected.push_back(next);
+        }
+        return selected;
+    }
+
+    std::vector<int> selectAvoid(const RoadGraph& graph, size_t count) {
+        std::vector<int> existing = getExistingNodes(graph);
+        // Trees may pass through ids past the last node while a graph is edited
+        size_t nodeCount = std::max(graph.getNodes().size(), graph.getAdjacency().getNodeCount());
+        std::mt19937 random(5);
+        Dijkstra dijkstra(graph);
+
+        std::vector<int> selected;
+        std::vector<std::vector<uint32_t>> fromLandmarks;
+        std::vector<bool> isLandmark(nodeCount, false);
+        std::vector<uint32_t> childOffsets(nodeCount + 1);
+        std::vector<int> children(nodeCount);
+        std::vector<uint64_t> sizes(nodeCount);
+        std::vector<bool> holdsLandmark(nodeCount);
+        std::vector<int> order;
+
+        for (size_t attempt = 0; selected.size() < count && attempt < count * 4; ++attempt) {
+            int root = existing[random() % existing.size()];
+            dijkstra.searchFrom(root);
+            const SearchSpace& tree = dijkstra.getSearchSpace();
+
+            // Children of every node in the shortest path tree, in one array
+            std::fill(childOffsets.begin(), childOffsets.end(), 0);
+            for (size_t node = 0; node < nodeCount; ++node) {
+                int parent = tree.getParentNode(static_cast<int>(node));
+                if (parent >= 0) {
+                    ++childOffsets[parent + 1];
+                }
+            }
+            for (size_t node = 0; node < nodeCount; ++node) {
+                childOffsets[node + 1] += childOffsets[node];
+            }
+            std::vector<uint32_t> cursor(childOffsets.begin(), childOffsets.end() - 1);
+            for (size_t node = 0; node < nodeCount; ++node) {
+                int parent = tree.getParentNode(static_cast<int>(node));
+                if (parent >= 0) {
+                    children[cursor[parent]++] = static_cast<int>(node);
+                }
+            }
+
+            // Preorder from the root, so walking it backwards visits children before parents
+            order.clear();
+            order.push_back(root);
+            for (size_t i = 0; i < order.size(); ++i) {
+                order.insert(order.end(), children.begin() + childOffsets[order[i]], children.begin() + childOffsets[order[i] + 1]);
+            }
+
+            // A node's weight is how far the landmarks' bound falls short of its
+            // travel time from the root; subtrees holding a landmark count nothing
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                int node = *it;
+                uint32_t travelTime = dijkstra.getTravelTime(node);
+                int64_t bound = 0;
+                for (const std::vector<uint32_t>& fromLandmark : fromLandmarks) {
+                    if (fromLandmark[node] != RoadColumns::unreachable && fromLandmark[root] != RoadColumns::unreachable) {
+                        bound = std::max(bound, static_cast<int64_t>(fromLandmark[node]) - fromLandmark[root]);
+                    }
+                }
+                uint64_t size = static_cast<uint64_t>(std::max<int64_t>(static_cast<int64_t>(travelTime) - bound, 0));
+                bool covered = isLandmark[node];
+                for (uint32_t i = childOffsets[node]; i < childOffsets[node + 1]; ++i) {
+                    size += sizes[children[i]];
+                    covered = covered || holdsLandmark[children[i]];
+                }
+                holdsLandmark[node] = covered;
+                sizes[node] = covered ? 0 : size;
+            }
+
+            // Largest subtree, then down its largest branch to a leaf
+            int node = -1;
+            for (int candidate : order) {
+                if (sizes[candidate] > 0 && (node < 0 || sizes[candidate] > sizes[node])) {
+                    node = candidate;
+                }
+            }
+            if (node < 0) {
+                continue;
+            }
+            for (;;) {
+                int largest = -1;
+                for (uint32_t i = childOffsets[node]; i < childOffsets[node + 1]; ++i) {
+                    if (largest < 0 || sizes[children[i]] > sizes[largest]) {
+                        largest = children[i];
+                    }
+                }
+                if (largest < 0 || sizes[largest] == 0) {
+                    break;
+                }
+                node = largest;
+            }
+
+            selected.push_back(node);
+            isLandmark[node] = true;
+            dijkstra.searchFrom(node);
+            fromLandmarks.emplace_back(nodeCount);
+            for (size_t other = 0; other < nodeCount; ++other) {
+                fromLandmarks.back()[other] = dijkstra.getTravelTime(static_cast<int>(other));
+            }
+        }
+        return selected;
+    }
+}
+
+/* METHODS */
+void Landmarks::build(const RoadGraph& graph, size_t count, Selection selection, size_t workerCount) {
+    file.reset();
+    landmarks.assign({});
+    distances.assign({});
+    if (count == 0 || getExistingNodes(graph).empty()) {
+        return;
+    }
+
+    // Built up front, so the searches below only read shared indexes
+    graph.getAdjacency();
+    graph.getReverseAdjacency();
+    graph.getRoadColumns();
+
+    std::vector<int> selected = selection == Farthest ? selectFarthest(graph, count) : selectAvoid(graph, count);
+    if (selected.empty()) {
+        return;
+    }
+
+    // One search per landmark and direction, each writing its own column
+    size_t nodeCount = graph.getNodes().size();
+    size_t landmarkCount = selected.size();
+    std::vector<std::vector<uint32_t>> columns(landmarkCount * 2);
+    parallelFor(columns.size(), [&](size_t task) {
+        Dijkstra dijkstra(graph);
+        dijkstra.searchFrom(selected[task / 2], task % 2 == 0 ? Adjacency::Outgoing : Adjacency::Incoming);
+        std::vector<uint32_t>& column = columns[task];
+        column.resize(nodeCount);
+        for (size_t node = 0; node < nodeCount; ++node) {
+            column[node] = dijkstra.getTravelTime(static_cast<int>(node));
+        }
+    }, workerCount);
+
+    // Interleave node by node
+    std::vector<uint32_t> values(nodeCount * landmarkCount * 2);
+    for (size_t node = 0; node < nodeCount; ++node) {
+        for (size_t column = 0; column < columns.size(); ++column) {
+            values[node * columns.size() + column] = columns[column][node];
+        }
+    }
+
+    landmarks.assign(std::move(selected));
+    distances.assign(std::move(values));
+}
+
+bool Landmarks::read(const std::string& filename, const RoadGraph& graph) {
+    auto graphFile = std::make_unique<GraphFile>(filename);
+    const int* landmarkData;
+    const uint32_t* distanceData;
+    size_t landmarkCount, distanceCount;
+    if (!graphFile->isValid() || !graphFile->getSection(GraphFile::LandmarksSection, landmarkData, landmarkCount) ||
+        !graphFile->getSection(GraphFile::LandmarkDistancesSection, distanceData, distanceCount)) {
+        return false;
+    }
+    if (landmarkCount == 0 || distanceCount != graph.getNodes().size() * landmarkCount * 2) {
+        std::cerr << "Landmarks in " << filename << " do not match the graph" << std::endl;
+        return false;
+    }
+
+    landmarks.borrow(landmarkData, landmarkCount);
+    distances.borrow(distanceData, distanceCount);
+    file = std::move(graphFile);
+    return true;
+}
+
+std::vector<GraphFile::SectionData> Landmarks::getSections() const {
+    if (empty()) {
+        return {};
+    }
+    return {
+        {GraphFile::LandmarksSection, sizeof(int), landmarks.size(), landmarks.data()},
+        {GraphFile::LandmarkDistancesSection, sizeof(uint32_t), distances.size(), distances.data()},
+    };
+}
+
+uint32_t Landmarks::getLowerBound(int from, int to) const {
+    size_t stride = landmarks.size() * 2;
+    const uint32_t* fromTimes = distances.data() + from * stride;
+    const uint32_t* toTimes = distances.data() + to * stride;
+
+    int64_t bound = 0;
+    for (size_t i = 0; i < stride; i += 2) {
+        // Landmark to to is no longer than landmark to from plus from to to
+        if (fromTimes[i] != RoadColumns::unreachable && toTimes[i] != RoadColumns::unreachable) {
+            bound = std::max(bound, static_cast<int64_t>(toTimes[i]) - fromTimes[i]);
+        }
+        // From to landmark is no longer than from to to plus to to landmark
+        if (fromTimes[i + 1] != RoadColumns::unreachable && toTimes[i + 1] != RoadColumns::unreachable) {
+            bound = std::max(bound, static_cast<int64_t>(fromTimes[i + 1]) - toTimes[i + 1]);
+        }
+    }
+    return static_cast<uint32_t>(bound);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Column.h"
+#include "GraphFile.h"
+
+class RoadGraph;
+
+// Travel times from and to a few landmark nodes, for lower bounds on the
+// travel time between any two nodes by the triangle inequality (ALT). Each
+// node's times for all landmarks are stored side by side, so a bound reads
+// one short run per node. The tables can be stored as sections of a graph
+// file and used from the mapping without loading.
+class Landmarks {
+public:
+    enum Selection {
+        // Each landmark is the node farthest from those picked so far
+        Farthest,
+        // Each landmark ends the branch of a shortest path tree the current
+        // landmarks bound worst
+        Avoid,
+    };
+
+    // Picks the landmarks, then fills the tables with one search per landmark
+    // and direction, spread over the workers
+    void build(const RoadGraph& graph, size_t count, Selection selection = Avoid, size_t workerCount = 0);
+    // Borrows the tables from a graph file written with getSections; false if
+    // it holds none or they were made for another node count
+    bool read(const std::string& filename, const RoadGraph& graph);
+    // Tables to pass to GraphFile::write; they point into this object
+    std::vector<GraphFile::SectionData> getSections() const;
+
+    bool empty() const { return landmarks.empty(); }
+    size_t getLandmarkCount() const { return landmarks.size(); }
+    size_t getNodeCount() const { return empty() ? 0 : distances.size() / (landmarks.size() * 2); }
+    const Column<int>& getNodes() const { return landmarks; }
+    // Milliseconds from a landmark to node and from node to the landmark
+    uint32_t getTravelTimeFrom(size_t landmark, int node) const { return distances[(node * landmarks.size() + landmark) * 2]; }
+    uint32_t getTravelTimeTo(size_t landmark, int node) const { return distances[(node * landmarks.size() + landmark) * 2 + 1]; }
+
+    // Largest bound any landmark gives on the travel time from one node to the
+    // other. Landmarks that cannot reach or be reached from both give none.
+    uint32_t getLowerBound(int from, int to) const;
+    size_t memoryUsage() const { return landmarks.memoryUsage() + distances.memoryUsage(); }
+
+private:
+    Column<int> landmarks;
+    Column<uint32_t> distances;
+    // Holds the mapping borrowed tables point into
+    std::unique_ptr<GraphFile> file;
+};
@@ -0,0 +1,144 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* CONSTRUCTORS */
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& filename) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return;
+    }
+
+    fileHandle = file;
+    length = static_cast<size_t>(size.QuadPart);
+    opened = true;
+    if (length == 0) {
+        return;
+    }
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        std::cerr << "Failed to map file: " << filename << std::endl;
+        close();
+        return;
+    }
+
+    data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        std::cerr << "Failed to map file: " << filename << std::endl;
+        close();
+    }
+}
+#else
+MappedFile::MappedFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return;
+    }
+
+    length = static_cast<size_t>(info.st_size);
+    opened = true;
+    if (length > 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            std::cerr << "Failed to map file: " << filename << std::endl;
+            length = 0;
+            opened = false;
+        } else {
+            data = static_cast<const char*>(address);
+        }
+    }
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+}
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data = std::exchange(other.data, nullptr);
+        length = std::exchange(other.length, 0);
+        opened = std::exchange(other.opened, false);
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+
+/* METHODS */
+void MappedFile::adviseSequential() const {
+#ifndef _WIN32
+    if (data) {
+        madvise(const_cast<char*>(data), length, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+void MappedFile::release(size_t end) const {
+#ifndef _WIN32
+    long pageSize = sysconf(_SC_PAGESIZE);
+    end = std::min(end, length) / pageSize * pageSize;
+    if (data && end > 0) {
+        madvise(const_cast<char*>(data), end, MADV_DONTNEED);
+    }
+#endif
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    if (data) {
+        munmap(const_cast<char*>(data), length);
+    }
+#endif
+    data = nullptr;
+    length = 0;
+    opened = false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first
+// access, so opening a large file costs almost nothing up front.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool isOpen() const { return opened; }
+    const char* getData() const { return data; }
+    size_t getSize() const { return length; }
+
+    // Tells the kernel the mapping will be read front to back
+    void adviseSequential() const;
+    // Drops the pages before end from this process; they are read back from
+    // the file if touched again
+    void release(size_t end) const;
+
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool opened = false;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    void close();
+};
@@ -0,0 +1,235 @@
+#include "NodeGrid.h"
+#include "Parallel.h"
+#include "RoadGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace {
+    // Average nodes per cell the cell size aims for
+    const float nodesPerCell = 4.0f;
+    // Keeps the cell table in proportion to the node count for degenerate extents
+    const size_t maxCellsPerNode = 4;
+}
+
+/* METHODS */
+void NodeGrid::build(const Column<Node>& nodes, const glm::vec3& minCoords, const glm::vec3& maxCoords) {
+    size_t nodeCount = 0;
+    for (const Node& node : nodes) {
+        if (!std::isnan(node.position.x)) {
+            ++nodeCount;
+        }
+    }
+
+    origin = glm::vec2(minCoords);
+    glm::vec2 extent = nodeCount > 0 ? glm::max(glm::vec2(maxCoords) - origin, glm::vec2(1.0f)) : glm::vec2(1.0f);
+    cellSize = std::max(std::sqrt(extent.x * extent.y * nodesPerCell / std::max<size_t>(nodeCount, 1)), 1.0f);
+    while ((std::ceil(extent.x / cellSize) * std::ceil(extent.y / cellSize)) > static_cast<double>(std::max<size_t>(nodeCount, 1) * maxCellsPerNode)) {
+        cellSize *= 2.0f;
+    }
+    columns = std::max(1, static_cast<int>(std::ceil(extent.x / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(extent.y / cellSize)));
+
+    // Counting sort into cells: count, prefix sum, then scatter in id order
+    std::vector<uint32_t> nodeCells(nodes.size());
+    cellOffsets.assign(getCellCount() + 1, 0);
+    for (size_t id = 0; id < nodes.size(); ++id) {
+        if (!std::isnan(nodes[id].position.x)) {
+            glm::ivec2 cell = getCell(glm::vec2(nodes[id].position));
+            nodeCells[id] = static_cast<uint32_t>(cell.y * columns + cell.x);
+            ++cellOffsets[nodeCells[id] + 1];
+        }
+    }
+    for (size_t cell = 0; cell < getCellCount(); ++cell) {
+        cellOffsets[cell + 1] += cellOffsets[cell];
+    }
+
+    positions.resize(nodeCount);
+    nodeIds.resize(nodeCount);
+    std::vector<uint32_t> cursor(cellOffsets.begin(), cellOffsets.end() - 1);
+    for (size_t id = 0; id < nodes.size(); ++id) {
+        if (!std::isnan(nodes[id].position.x)) {
+            uint32_t slot = cursor[nodeCells[id]]++;
+            positions[slot] = glm::vec2(nodes[id].position);
+            nodeIds[slot] = static_cast<int>(id);
+        }
+    }
+}
+
+int NodeGrid::findNearest(const glm::vec2& point, float maxDistance) const {
+    if (nodeIds.empty()) {
+        return -1;
+    }
+
+    glm::ivec2 cell = getCell(point);
+    float bestSquared = maxDistance * maxDistance;
+    int best = -1;
+    for (int ring = 0;; ++ring) {
+        visitRing(cell, ring, [&](uint32_t slot) {
+            glm::vec2 offset = positions[slot] - point;
+            float squared = glm::dot(offset, offset);
+            if (squared < bestSquared || (squared == bestSquared && best < 0)) {
+                bestSquared = squared;
+                best = nodeIds[slot];
+            }
+        });
+
+        float searched = getSearchedDistance(point, cell, ring);
+        if (searched * searched >= bestSquared) {
+            return best;
+        }
+    }
+}
+
+void NodeGrid::findNearest(const glm::vec2& point, size_t count, std::vector<int>& result) const {
+    result.clear();
+    if (nodeIds.empty() || count == 0) {
+        return;
+    }
+
+    // Max-heap of the closest nodes found so far, farthest on top
+    std::vector<std::pair<float, int>> closest;
+    closest.reserve(count + 1);
+    glm::ivec2 cell = getCell(point);
+    for (int ring = 0;; ++ring) {
+        visitRing(cell, ring, [&](uint32_t slot) {
+            glm::vec2 offset = positions[slot] - point;
+            float squared = glm::dot(offset, offset);
+            if (closest.size() < count) {
+                closest.emplace_back(squared, nodeIds[slot]);
+                std::push_heap(closest.begin(), closest.end());
+            } else if (squared < closest.front().first) {
+                std::pop_heap(closest.begin(), closest.end());
+                closest.back() = std::make_pair(squared, nodeIds[slot]);
+                std::push_heap(closest.begin(), closest.end());
+            }
+        });
+
+        float searched = getSearchedDistance(point, cell, ring);
+        if (std::isinf(searched) || (closest.size() == count && searched * searched >= closest.front().first)) {
+            break;
+        }
+    }
+
+    std::sort_heap(closest.begin(), closest.end());
+    for (const auto& entry : closest) {
+        result.push_back(entry.second);
+    }
+}
+
+void NodeGrid::findInBox(const glm::vec2& minCorner, const glm::vec2& maxCorner, std::vector<int>& result) const {
+    result.clear();
+    if (nodeIds.empty()) {
+        return;
+    }
+
+    glm::ivec2 first = getCell(minCorner);
+    glm::ivec2 last = getCell(maxCorner);
+    for (int row = first.y; row <= last.y; ++row) {
+        // Cells of a row are adjacent, so the row's nodes are one range
+        uint32_t begin = cellOffsets[row * columns + first.x];
+        uint32_t end = cellOffsets[row * columns + last.x + 1];
+        for (uint32_t slot = begin; slot < end; ++slot) {
+            const glm::vec2& position = positions[slot];
+            if (position.x >= minCorner.x && position.x <= maxCorner.x && position.y >= minCorner.y && position.y <= maxCorner.y) {
+                result.push_back(nodeIds[slot]);
+            }
+        }
+    }
+}
+
+void NodeGrid::findInRadius(const glm::vec2& center, float radius, std::vector<int>& result) const {
+    result.clear();
+    if (nodeIds.empty() || !(radius >= 0.0f)) {
+        return;
+    }
+
+    glm::ivec2 first = getCell(center - radius);
+    glm::ivec2 last = getCell(center + radius);
+    float radiusSquared = radius * radius;
+    for (int row = first.y; row <= last.y; ++row) {
+        uint32_t begin = cellOffsets[row * columns + first.x];
+        uint32_t end = cellOffsets[row * columns + last.x + 1];
+        for (uint32_t slot = begin; slot < end; ++slot) {
+            glm::vec2 offset = positions[slot] - center;
+            if (glm::dot(offset, offset) <= radiusSquared) {
+                result.push_back(nodeIds[slot]);
+            }
+        }
+    }
+}
+
+void NodeGrid::findNearest(const std::vector<glm::vec2>& points, std::vector<int>& result, size_t workerCount) const {
+    result.resize(points.size());
+
+    // Chunks amortize the hand-out of indices over many cheap lookups
+    const size_t chunkSize = 1024;
+    size_t chunkCount = (points.size() + chunkSize - 1) / chunkSize;
+    parallelFor(chunkCount, [&](size_t chunk) {
+        size_t end = std::min(points.size(), (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; ++i) {
+            result[i] = findNearest(points[i]);
+        }
+    }, workerCount);
+}
+
+size_t NodeGrid::memoryUsage() const {
+    return cellOffsets.capacity() * sizeof(uint32_t) + positions.capacity() * sizeof(glm::vec2) + nodeIds.capacity() * sizeof(int);
+}
+
+glm::ivec2 NodeGrid::getCell(const glm::vec2& point) const {
+    glm::vec2 cell = glm::floor((point - origin) / cellSize);
+    // Clamp in float first, so far away or NaN points cannot overflow the conversion
+    cell = glm::clamp(cell, glm::vec2(0.0f), glm::vec2(static_cast<float>(columns - 1), static_cast<float>(rows - 1)));
+    return glm::ivec2(std::isnan(cell.x) ? 0 : static_cast<int>(cell.x), std::isnan(cell.y) ? 0 : static_cast<int>(cell.y));
+}
+
+float NodeGrid::getSearchedDistance(const glm::vec2& point, const glm::ivec2& cell, int ring) const {
+    // Each side of the searched square bounds the distance, unless the grid ends there
+    float distance = std::numeric_limits<float>::infinity();
+    if (cell.x - ring > 0) {
+        distance = std::min(distance, point.x - (origin.x + (cell.x - ring) * cellSize));
+    }
+    if (cell.x + ring < columns - 1) {
+        distance = std::min(distance, origin.x + (cell.x + ring + 1) * cellSize - point.x);
+    }
+    if (cell.y - ring > 0) {
+        distance = std::min(distance, point.y - (origin.y + (cell.y - ring) * cellSize));
+    }
+    if (cell.y + ring < rows - 1) {
+        distance = std::min(distance, origin.y + (cell.y + ring + 1) * cellSize - point.y);
+    }
+    return std::max(distance, 0.0f);
+}
+
+template<typename Visit>
+void NodeGrid::visitRing(const glm::ivec2& cell, int ring, Visit&& visit) const {
+    int firstRow = std::max(cell.y - ring, 0);
+    int lastRow = std::min(cell.y + ring, rows - 1);
+    int firstColumn = std::max(cell.x - ring, 0);
+    int lastColumn = std::min(cell.x + ring, columns - 1);
+
+    auto visitCells = [&](int row, int first, int last) {
+        // Cells of a row are adjacent, so a run of them is one range
+        uint32_t begin = cellOffsets[row * columns + first];
+        uint32_t end = cellOffsets[row * columns + last + 1];
+        for (uint32_t slot = begin; slot < end; ++slot) {
+            visit(slot);
+        }
+    };
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        // Rows on the ring's edge are scanned whole, the others only at both ends
+        if (row == cell.y - ring || row == cell.y + ring) {
+            visitCells(row, firstColumn, lastColumn);
+            continue;
+        }
+        if (cell.x - ring >= 0) {
+            visitCells(row, cell.x - ring, cell.x - ring);
+        }
+        if (cell.x + ring < columns) {
+            visitCells(row, cell.x + ring, cell.x + ring);
+        }
+    }
+}
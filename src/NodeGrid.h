@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Column.h"
+
+struct Node;
+
+// Uniform grid over the node positions in the ground plane. Each cell is one
+// contiguous range of ids and positions, bucketed with a counting sort, so a
+// query reads a few short arrays instead of chasing pointers. The cell size
+// is picked from the bounding box so cells hold a handful of nodes on average.
+class NodeGrid {
+public:
+    // Nodes with NaN positions are holes in the id range and are left out
+    void build(const Column<Node>& nodes, const glm::vec3& minCoords, const glm::vec3& maxCoords);
+
+    // Closest node within maxDistance, -1 if there is none
+    int findNearest(const glm::vec2& point, float maxDistance = std::numeric_limits<float>::infinity()) const;
+    // Up to count closest nodes, nearest first
+    void findNearest(const glm::vec2& point, size_t count, std::vector<int>& result) const;
+    void findInBox(const glm::vec2& minCorner, const glm::vec2& maxCorner, std::vector<int>& result) const;
+    void findInRadius(const glm::vec2& center, float radius, std::vector<int>& result) const;
+
+    // One nearest lookup per point, spread over the workers
+    void findNearest(const std::vector<glm::vec2>& points, std::vector<int>& result, size_t workerCount = 0) const;
+
+    float getCellSize() const { return cellSize; }
+    size_t getCellCount() const { return static_cast<size_t>(columns) * rows; }
+    size_t getNodeCount() const { return nodeIds.size(); }
+    size_t memoryUsage() const;
+
+private:
+    glm::vec2 origin = glm::vec2(0.0f);
+    float cellSize = 1.0f;
+    int columns = 0;
+    int rows = 0;
+
+    std::vector<uint32_t> cellOffsets;
+    std::vector<glm::vec2> positions;
+    std::vector<int> nodeIds;
+
+    glm::ivec2 getCell(const glm::vec2& point) const;
+    // Distance below which everything was found once the cells within ring
+    // of the start cell were searched; infinite once the grid is exhausted
+    float getSearchedDistance(const glm::vec2& point, const glm::ivec2& cell, int ring) const;
+    template<typename Visit>
+    void visitRing(const glm::ivec2& cell, int ring, Visit&& visit) const;
+};
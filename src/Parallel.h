@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+inline size_t getWorkerCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+// Runs task(index) for every index in [0, count), handing indices out to the
+// workers one at a time so uneven tasks still balance. Runs inline when there
+// is only one task or one worker.
+template<typename Task>
+void parallelFor(size_t count, Task&& task, size_t workerCount = 0) {
+    if (workerCount == 0) {
+        workerCount = getWorkerCount();
+    }
+    workerCount = std::min(workerCount, count);
+
+    if (workerCount <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            task(index);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t index = next++; index < count; index = next++) {
+            task(index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (size_t i = 1; i < workerCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
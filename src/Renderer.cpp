@@ -1,4 +1,5 @@
 #include "Renderer.h"
+#include <algorithm>
 #include <iostream>
 
 /* CONSTRUCTORS */
@@ -55,30 +56,63 @@ unsigned int Renderer::createBuffer(const std::vector<float>& vertices, GLenum m
     GLuint vao, vbo;
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
-    
-    glBindVertexArray(vao);
+
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
 
     unsigned int vertexSize = verticesHaveColor ? 6 : 3;
-    GLsizei stride = vertexSize * sizeof(float);
-    
+    unsigned int attributeCount = vertices.size() / vertexSize;
+    Buffer buffer = {vao, vbo, mode, attributeCount, thickness, verticesHaveColor, uniformColor, vertexSize, vertices.size()};
+    setupVertexAttributes(buffer);
+
+    buffers.push_back(buffer);
+
+    return buffers.size() - 1;
+}
+
+void Renderer::setupVertexAttributes(const Buffer& buffer) {
+    glBindVertexArray(buffer.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+
+    GLsizei stride = buffer.vertexSize * sizeof(float);
+
     GLuint positionLoc = shader->getAttributeLocation("vertexPosition");
     glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
     glEnableVertexAttribArray(positionLoc);
 
-    if (verticesHaveColor) {
+    if (buffer.verticesHaveColor) {
         GLuint colorLoc = shader->getAttributeLocation("vertexColor");
         glVertexAttribPointer(colorLoc, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
         glEnableVertexAttribArray(colorLoc);
     }
 
     glBindVertexArray(0);
+}
 
-    unsigned int attributeCount = vertices.size() / vertexSize;
-    buffers.push_back({vao, vbo, mode, attributeCount, thickness, verticesHaveColor, uniformColor, vertexSize});
-    
-    return buffers.size() - 1;
+void Renderer::reserveBuffer(Buffer& buffer, size_t required) {
+    if (required <= buffer.capacity) {
+        return;
+    }
+
+    // Grow geometrically and copy the old contents on the GPU, so appends stay amortized O(1)
+    size_t used = buffer.attributeCount * buffer.vertexSize;
+    size_t capacity = std::max(required, buffer.capacity * 2);
+
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer.vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used * sizeof(float));
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer.vbo);
+
+    buffer.vbo = vbo;
+    buffer.capacity = capacity;
+    setupVertexAttributes(buffer);
 }
 
 void Renderer::updateBufferData(unsigned int bufferIndex, std::unordered_map<unsigned int, glm::vec3>& updates) {
@@ -96,6 +130,66 @@ void Renderer::updateBufferData(unsigned int bufferIndex, std::unordered_map<uns
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void Renderer::updateBufferData(unsigned int bufferIndex, size_t firstVertex, const std::vector<float>& vertices) {
+    if (bufferIndex >= buffers.size()) {
+        std::cerr << "Invalid buffer index" << std::endl;
+        return;
+    }
+    if (vertices.empty()) {
+        return;
+    }
+
+    Buffer& buffer = buffers[bufferIndex];
+    size_t offset = firstVertex * buffer.vertexSize;
+    reserveBuffer(buffer, offset + vertices.size());
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(float), vertices.size() * sizeof(float), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    buffer.attributeCount = static_cast<unsigned int>(std::max<size_t>(buffer.attributeCount, firstVertex + vertices.size() / buffer.vertexSize));
+}
+
+void Renderer::appendBufferData(unsigned int bufferIndex, const std::vector<float>& vertices) {
+    if (bufferIndex >= buffers.size()) {
+        std::cerr << "Invalid buffer index" << std::endl;
+        return;
+    }
+    if (vertices.empty()) {
+        return;
+    }
+
+    Buffer& buffer = buffers[bufferIndex];
+    size_t used = buffer.attributeCount * buffer.vertexSize;
+    reserveBuffer(buffer, used + vertices.size());
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, used * sizeof(float), vertices.size() * sizeof(float), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    buffer.attributeCount += vertices.size() / buffer.vertexSize;
+}
+
+void Renderer::setBufferData(unsigned int bufferIndex, const std::vector<float>& vertices) {
+    if (bufferIndex >= buffers.size()) {
+        std::cerr << "Invalid buffer index" << std::endl;
+        return;
+    }
+
+    buffers[bufferIndex].attributeCount = 0;
+    appendBufferData(bufferIndex, vertices);
+}
+
+void Renderer::setVertexCount(unsigned int bufferIndex, size_t count) {
+    if (bufferIndex >= buffers.size()) {
+        std::cerr << "Invalid buffer index" << std::endl;
+        return;
+    }
+
+    Buffer& buffer = buffers[bufferIndex];
+    buffer.attributeCount = static_cast<unsigned int>(std::min(count, buffer.capacity / buffer.vertexSize));
+}
+
 void Renderer::render() {
     glClearColor(0.7f, 0.7f, 0.7f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
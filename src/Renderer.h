@@ -23,6 +23,13 @@ public:
 
     unsigned int createBuffer(const std::vector<float>& vertices, GLenum mode, float thickness = 1.0f, bool verticesHaveColor = false, glm::vec3 uniformColor = glm::vec3(0.0f));
     void updateBufferData(unsigned int bufferIndex, std::unordered_map<unsigned int, glm::vec3>& updates);
+    // Overwrites vertices from firstVertex on, growing the buffer if they run past its end
+    void updateBufferData(unsigned int bufferIndex, size_t firstVertex, const std::vector<float>& vertices);
+    void appendBufferData(unsigned int bufferIndex, const std::vector<float>& vertices);
+    // Replaces the contents, keeping the allocation if it is large enough
+    void setBufferData(unsigned int bufferIndex, const std::vector<float>& vertices);
+    // Draws only the first count vertices; the rest stay allocated
+    void setVertexCount(unsigned int bufferIndex, size_t count);
     void render();
 
 private:
@@ -35,6 +42,7 @@ private:
         bool verticesHaveColor;
         glm::vec3 color;
         unsigned int vertexSize;
+        size_t capacity;
     };
 
     std::unique_ptr<Shader> shader;
@@ -46,4 +54,7 @@ private:
 private:
     void setupOpenGL();
     void cleanupBuffers();
+    void setupVertexAttributes(const Buffer& buffer);
+    // Makes room for at least the given number of floats, keeping the drawn vertices
+    void reserveBuffer(Buffer& buffer, size_t required);
 };
\ No newline at end of file
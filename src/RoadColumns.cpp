@@ -0,0 +1,51 @@
+#include "RoadColumns.h"
+#include "RoadGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    template<typename T>
+    T saturate(double value) {
+        return static_cast<T>(std::min(std::max(std::round(value), 0.0), static_cast<double>(std::numeric_limits<T>::max())));
+    }
+}
+
+/* METHODS */
+void RoadColumns::build(const Column<Road>& roads) {
+    speeds.resize(roads.size());
+    lanes.resize(roads.size());
+    lengths.resize(roads.size());
+    travelTimes.resize(roads.size());
+
+    for (size_t id = 0; id < roads.size(); ++id) {
+        set(id, roads[id]);
+    }
+}
+
+void RoadColumns::update(const Column<Road>& roads, int road) {
+    if (road < 0 || static_cast<size_t>(road) >= roads.size()) {
+        return;
+    }
+    if (roads.size() > size()) {
+        speeds.resize(roads.size(), 0);
+        lanes.resize(roads.size(), 0);
+        lengths.resize(roads.size(), 0);
+        travelTimes.resize(roads.size(), unreachable);
+    }
+    set(road, roads[road]);
+}
+
+size_t RoadColumns::memoryUsage() const {
+    return speeds.capacity() + lanes.capacity() + (lengths.capacity() + travelTimes.capacity()) * sizeof(uint32_t);
+}
+
+void RoadColumns::set(size_t id, const Road& road) {
+    speeds[id] = saturate<uint8_t>(road.maxSpeed);
+    lanes[id] = saturate<uint8_t>(road.lanes);
+    lengths[id] = saturate<uint32_t>(road.meters * static_cast<double>(lengthScale));
+
+    // km/h to m/s is a factor of 3.6, seconds to milliseconds 1000
+    bool usable = road.from >= 0 && road.maxSpeed > 0.0f && std::isfinite(road.meters);
+    travelTimes[id] = usable ? std::min(saturate<uint32_t>(road.meters * 3600.0 / road.maxSpeed), unreachable - 1) : unreachable;
+}
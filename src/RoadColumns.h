@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Column.h"
+
+struct Road;
+
+// Road attributes as separate packed arrays indexed by road id, for routing
+// kernels that read one attribute of many roads. Derived from the roads, which
+// remain the stored form.
+class RoadColumns {
+public:
+    // Travel time of roads without a usable speed, and of holes in the id range
+    static constexpr uint32_t unreachable = UINT32_MAX;
+    // Lengths are stored in centimeters
+    static constexpr float lengthScale = 100.0f;
+
+    void build(const Column<Road>& roads);
+    // Refreshes one road after it was added, edited or removed
+    void update(const Column<Road>& roads, int road);
+
+    // Whole km/h, saturating at 255
+    uint8_t getSpeed(int road) const { return speeds[road]; }
+    uint8_t getLanes(int road) const { return lanes[road]; }
+    float getMeters(int road) const { return lengths[road] / lengthScale; }
+    // Milliseconds at the speed limit
+    uint32_t getTravelTime(int road) const { return travelTimes[road]; }
+
+    const std::vector<uint8_t>& getSpeeds() const { return speeds; }
+    const std::vector<uint8_t>& getLaneCounts() const { return lanes; }
+    const std::vector<uint32_t>& getLengths() const { return lengths; }
+    const std::vector<uint32_t>& getTravelTimes() const { return travelTimes; }
+
+    size_t size() const { return travelTimes.size(); }
+    size_t memoryUsage() const;
+
+private:
+    std::vector<uint8_t> speeds;
+    std::vector<uint8_t> lanes;
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> travelTimes;
+
+    void set(size_t id, const Road& road);
+};
@@ -1,81 +1,227 @@
 #include "RoadGraph.h"
-#include <fstream>
-#include <sstream>
+#include "GraphFile.h"
+#include "GraphTextParser.h"
 #include <iostream>
 #include <limits>
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
 
-RoadGraph::RoadGraph(const std::string& nodesFile, const std::string& edgesFile) {
-    std::ifstream nodesStream(nodesFile);
-    std::ifstream edgesStream(edgesFile);
+namespace {
+    const uint32_t hilbertOrder = 16;
 
-    if (!nodesStream.is_open()) {
-        std::cerr << "Failed to open nodes file: " << nodesFile << std::endl;
-        return;
-    }
-    if (!edgesStream.is_open()) {
-        std::cerr << "Failed to open edges file: " << edgesFile << std::endl;
-        return;
+    // Distance along a Hilbert curve filling a 2^16 x 2^16 grid
+    uint64_t getHilbertIndex(uint32_t x, uint32_t y) {
+        const uint32_t size = 1u << hilbertOrder;
+        uint64_t index = 0;
+        for (uint32_t step = size / 2; step > 0; step /= 2) {
+            uint32_t rx = (x & step) ? 1 : 0;
+            uint32_t ry = (y & step) ? 1 : 0;
+            index += static_cast<uint64_t>(step) * step * ((3 * rx) ^ ry);
+            // Rotate the quadrant so the curve stays continuous
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = size - 1 - x;
+                    y = size - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return index;
     }
+}
 
-    std::string line;
-
+RoadGraph::RoadGraph(const std::string& nodesFile, const std::string& edgesFile, const BatchCallback& onBatch) {
     // Initialize bounding box
     maxCoords = glm::vec3(-std::numeric_limits<float>::max());
     minCoords = glm::vec3(std::numeric_limits<float>::max());
+    center = glm::vec3(0.0f);
+
+    GraphTextParser parser;
+    std::vector<GraphTextParser::NodeRecord> nodeRecords;
+    std::vector<GraphTextParser::EdgeRecord> edgeRecords;
+
+    GraphTextParser::NodeChunkCallback onNodeChunk;
+    if (onBatch) {
+        onNodeChunk = [&onBatch](const std::vector<GraphTextParser::NodeRecord>& records) {
+            GraphBatch batch;
+            batch.nodePositions.reserve(records.size());
+            for (const auto& record : records) {
+                batch.nodePositions.push_back(record.position);
+            }
+            onBatch(std::move(batch));
+        };
+    }
+
+    if (!parser.parseNodes(nodesFile, nodeRecords, onNodeChunk)) {
+        return;
+    }
 
     // Add nodes
-    while (std::getline(nodesStream, line)) {
-        std::istringstream iss(line);
-        int id;
-        float x, y, z;
+    int maxId = -1;
+    for (const auto& record : nodeRecords) {
+        maxId = std::max(maxId, record.id);
+    }
+
+    // Sparse source ids (e.g. raw OSM ids) are renumbered densely rather than padding every gap
+    if (static_cast<size_t>(maxId) + 1 > nodeRecords.size() * 2 + 1024) {
+        std::vector<int> ids;
+        ids.reserve(nodeRecords.size());
+        for (const auto& record : nodeRecords) {
+            if (record.id >= 0) {
+                ids.push_back(record.id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        externalIds.assign(std::move(ids));
+        maxId = static_cast<int>(externalIds.size()) - 1;
+    }
 
-        if (!(iss >> id >> x >> y >> z)) {
-            std::cerr << "Failed to parse node line: " << line << std::endl;
+    std::vector<Node> nodeValues(maxId + 1, Node(glm::vec3(std::numeric_limits<float>::quiet_NaN())));
+    for (const auto& record : nodeRecords) {
+        if (record.id < 0) {
+            std::cerr << "Invalid node id: " << record.id << std::endl;
             continue;
         }
+        nodeValues[getNodeId(record.id)] = record.position;
+        updateBoundingBox(record.position);
+    }
+    nodes.assign(std::move(nodeValues));
 
-        addNode(id, glm::vec3(x, y, z));
+    // Node positions are final from here on, so edge chunks can be drawn as they are parsed
+    GraphTextParser::EdgeChunkCallback onEdgeChunk;
+    if (onBatch) {
+        onEdgeChunk = [this, &onBatch](const std::vector<GraphTextParser::EdgeRecord>& records, const std::vector<glm::vec2>& chunkShapePoints) {
+            GraphBatch batch;
+            batch.roadSegments.reserve((records.size() + chunkShapePoints.size()) * 2);
+            for (const auto& record : records) {
+                int from = getNodeId(record.from);
+                int to = getNodeId(record.to);
+                if (nodeExists(from) && nodeExists(to)) {
+                    appendPolyline(batch.roadSegments, nodes[from].position, nodes[to].position,
+                                   chunkShapePoints.data() + record.shapeBegin, record.shapeCount, false);
+                }
+            }
+            onBatch(std::move(batch));
+        };
     }
 
-    // Add edges
-    int id = 0;
-    while (std::getline(edgesStream, line)) {
-        std::istringstream iss(line);
-        int idNode1, idNode2;
-        float meters, maxSpeed;
-        int lanes, oneWay;
+    std::vector<glm::vec2> shapeValues;
+    if (!parser.parseEdges(edgesFile, edgeRecords, shapeValues, onEdgeChunk)) {
+        return;
+    }
 
-        if (!(iss >> idNode1 >> idNode2 >> meters >> maxSpeed >> lanes >> oneWay)) {
-            std::cerr << "Failed to parse edge line: " << line << std::endl;
-            continue;
+    // Add edges, one road per street whichever way it can be travelled
+    std::vector<Road> roadValues;
+    roadValues.reserve(edgeRecords.size());
+    for (auto& record : edgeRecords) {
+        if (!externalIds.empty()) {
+            record.from = getNodeId(record.from);
+            record.to = getNodeId(record.to);
         }
-        
-        addRoad(id, idNode1, idNode2, meters, maxSpeed, lanes);
-        ++id;
+        roadValues.emplace_back(record.from, record.to, record.meters, record.maxSpeed, record.lanes, record.shapeBegin, record.shapeCount, !record.oneWay);
+    }
+    mergeReciprocalRoads(roadValues, shapeValues);
+    roads.assign(std::move(roadValues));
+    shapePoints.assign(std::move(shapeValues));
+
+    center = (minCoords + maxCoords) / 2.0f;
+}
+
+RoadGraph::RoadGraph(const std::string& graphFileName): RoadGraph(std::make_unique<GraphFile>(graphFileName)) {}
+
+RoadGraph::RoadGraph(std::unique_ptr<GraphFile> file): graphFile(std::move(file)) {
+    maxCoords = glm::vec3(-std::numeric_limits<float>::max());
+    minCoords = glm::vec3(std::numeric_limits<float>::max());
+    center = glm::vec3(0.0f);
 
-        if (!oneWay) {
-            addRoad(id, idNode2, idNode1, meters, maxSpeed, lanes);
-            ++id;
+    if (!graphFile || !graphFile->isValid()) {
+        graphFile.reset();
+        return;
+    }
+
+    const Node* nodeData;
+    const Road* roadData;
+    size_t nodeCount, roadCount;
+    if (!graphFile->getSection(GraphFile::NodesSection, nodeData, nodeCount) ||
+        !graphFile->getSection(GraphFile::RoadsSection, roadData, roadCount)) {
+        std::cerr << "Graph file is missing node or road data" << std::endl;
+        graphFile.reset();
+        return;
+    }
+
+    nodes.borrow(nodeData, nodeCount);
+    roads.borrow(roadData, roadCount);
+
+    const glm::vec2* shapeData;
+    size_t shapeCount;
+    if (graphFile->getSection(GraphFile::ShapePointsSection, shapeData, shapeCount)) {
+        shapePoints.borrow(shapeData, shapeCount);
+    }
+
+    const int* externalIdData;
+    size_t externalIdCount;
+    if (graphFile->getSection(GraphFile::ExternalIdsSection, externalIdData, externalIdCount)) {
+        externalIds.borrow(externalIdData, externalIdCount);
+    }
+    if (graphFile->getSection(GraphFile::ExternalIdOrderSection, externalIdData, externalIdCount)) {
+        externalIdOrder.borrow(externalIdData, externalIdCount);
+    }
+
+    minCoords = graphFile->getMinCoords();
+    maxCoords = graphFile->getMaxCoords();
+    center = (minCoords + maxCoords) / 2.0f;
+}
+
+RoadGraph::RoadGraph(std::vector<Node> nodeValues, std::vector<Road> roadValues, std::vector<glm::vec2> shapeValues,
+                     std::vector<int> externalIdValues, std::vector<int> externalIdOrderValues) {
+    maxCoords = glm::vec3(-std::numeric_limits<float>::max());
+    minCoords = glm::vec3(std::numeric_limits<float>::max());
+
+    for (const Node& node : nodeValues) {
+        if (!std::isnan(node.position.x)) {
+            updateBoundingBox(node.position);
         }
     }
+    nodes.assign(std::move(nodeValues));
+    roads.assign(std::move(roadValues));
+    shapePoints.assign(std::move(shapeValues));
+    externalIds.assign(std::move(externalIdValues));
+    externalIdOrder.assign(std::move(externalIdOrderValues));
 
     center = (minCoords + maxCoords) / 2.0f;
 }
 
-const std::unordered_map<int, Node>& RoadGraph::getNodes() const {
+// Out of line so that GraphFile is a complete type where it is destroyed
+RoadGraph::~RoadGraph() = default;
+
+const Column<Node>& RoadGraph::getNodes() const {
     return nodes;
 }
 
-const std::unordered_map<int, Road>& RoadGraph::getRoads() const {
+const Column<Road>& RoadGraph::getRoads() const {
     return roads;
 }
 
+const Column<glm::vec2>& RoadGraph::getShapePoints() const {
+    return shapePoints;
+}
+
+const Column<int>& RoadGraph::getExternalIds() const {
+    return externalIds;
+}
+
+const Column<int>& RoadGraph::getExternalIdOrder() const {
+    return externalIdOrder;
+}
+
 glm::vec3 RoadGraph::getNodePosition(int id) const {
-    auto it = nodes.find(id);
-    if (it != nodes.end()) {
-        Node node = it->second;
-        return node.position;
+    if (nodeExists(id)) {
+        return nodes[id].position;
     }
     throw std::runtime_error("Node not found");
 }
@@ -84,40 +230,562 @@ glm::vec3 RoadGraph::getCenter() const {
     return center;
 }
 
+glm::vec3 RoadGraph::getMinCoords() const {
+    return minCoords;
+}
+
+glm::vec3 RoadGraph::getMaxCoords() const {
+    return maxCoords;
+}
+
 float RoadGraph::getRadius() const {
     return glm::distance(center, maxCoords);
 }
 
+void RoadGraph::splitIntoBatches(const BatchCallback& onBatch, size_t batchSize) const {
+    for (size_t begin = 0; begin < nodes.size(); begin += batchSize) {
+        GraphBatch batch;
+        size_t end = std::min(nodes.size(), begin + batchSize);
+        for (size_t id = begin; id < end; ++id) {
+            if (nodeExists(id)) {
+                batch.nodePositions.push_back(nodes[id].position);
+            }
+        }
+        onBatch(std::move(batch));
+    }
+
+    for (size_t begin = 0; begin < roads.size(); begin += batchSize) {
+        GraphBatch batch;
+        size_t end = std::min(roads.size(), begin + batchSize);
+        for (size_t id = begin; id < end; ++id) {
+            const Road& road = roads[id];
+            if (roadExists(id) && nodeExists(road.from) && nodeExists(road.to)) {
+                appendRoadSegments(road, batch.roadSegments);
+            }
+        }
+        onBatch(std::move(batch));
+    }
+}
+
+void RoadGraph::appendRoadSegments(const Road& road, std::vector<glm::vec3>& segments) const {
+    // Ranges come from files, so one pointing past the shape points is drawn straight
+    size_t count = road.shapeCount;
+    if (road.shapeBegin > shapePoints.size() || count > shapePoints.size() - road.shapeBegin) {
+        count = 0;
+    }
+    appendPolyline(segments, nodes[road.from].position, nodes[road.to].position,
+                   shapePoints.data() + road.shapeBegin, count, false);
+}
+
+void RoadGraph::appendPolyline(std::vector<glm::vec3>& segments, const glm::vec3& from, const glm::vec3& to,
+                               const glm::vec2* shape, size_t count, bool reversed) {
+    glm::vec3 previous = from;
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 current(shape[reversed ? count - 1 - i : i], from.z);
+        segments.push_back(previous);
+        segments.push_back(current);
+        previous = current;
+    }
+    segments.push_back(previous);
+    segments.push_back(to);
+}
+
+size_t RoadGraph::mergeReciprocalRoads(std::vector<Road>& roadValues, std::vector<glm::vec2>& shapeValues) {
+    auto hasValidShape = [&shapeValues](const Road& road) {
+        return road.shapeBegin <= shapeValues.size() && road.shapeCount <= shapeValues.size() - road.shapeBegin;
+    };
+    auto getEnds = [&roadValues](uint32_t id) {
+        const Road& road = roadValues[id];
+        return std::make_pair(std::min(road.from, road.to), std::max(road.from, road.to));
+    };
+    auto isReverse = [&shapeValues](const Road& a, const Road& b) {
+        // Lengths are rounded to millimeters by the exporters
+        if (a.from != b.to || a.to != b.from || a.shapeCount != b.shapeCount || std::abs(a.meters - b.meters) > 0.01f) {
+            return false;
+        }
+        const glm::vec2* shape = shapeValues.data();
+        return std::equal(shape + a.shapeBegin, shape + a.shapeBegin + a.shapeCount,
+                          std::make_reverse_iterator(shape + b.shapeBegin + b.shapeCount));
+    };
+
+    // Two-way roads grouped by their pair of end nodes, in id order within a group
+    std::vector<uint32_t> candidates;
+    for (size_t id = 0; id < roadValues.size(); ++id) {
+        const Road& road = roadValues[id];
+        if (road.twoWay && road.from >= 0 && road.to >= 0 && hasValidShape(road)) {
+            candidates.push_back(static_cast<uint32_t>(id));
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return getEnds(a) < getEnds(b); });
+
+    std::vector<bool> paired(roadValues.size(), false);
+    std::vector<bool> dropped(roadValues.size(), false);
+    size_t droppedCount = 0;
+    for (size_t first = 0, last = 0; first < candidates.size(); first = last) {
+        while (last < candidates.size() && getEnds(candidates[last]) == getEnds(candidates[first])) {
+            ++last;
+        }
+        for (size_t i = first; i < last; ++i) {
+            for (size_t j = i + 1; j < last && !paired[candidates[i]]; ++j) {
+                Road& road = roadValues[candidates[i]];
+                Road& reverse = roadValues[candidates[j]];
+                if (paired[candidates[j]] || !isReverse(road, reverse)) {
+                    continue;
+                }
+                paired[candidates[i]] = true;
+                paired[candidates[j]] = true;
+                if (road.maxSpeed == reverse.maxSpeed && road.lanes == reverse.lanes) {
+                    dropped[candidates[j]] = true;
+                    ++droppedCount;
+                } else {
+                    road.twoWay = false;
+                    reverse.twoWay = false;
+                }
+            }
+        }
+    }
+    if (droppedCount == 0) {
+        return 0;
+    }
+
+    std::vector<Road> keptRoads;
+    std::vector<glm::vec2> keptShapes;
+    keptRoads.reserve(roadValues.size() - droppedCount);
+    keptShapes.reserve(shapeValues.size());
+    for (size_t id = 0; id < roadValues.size(); ++id) {
+        if (!dropped[id]) {
+            keptRoads.push_back(roadValues[id]);
+        }
+    }
+    compactShapes(keptRoads, shapeValues.data(), shapeValues.size(), keptShapes);
+    roadValues.swap(keptRoads);
+    shapeValues.swap(keptShapes);
+    return droppedCount;
+}
+
+void RoadGraph::compactShapes(std::vector<Road>& roadValues, const glm::vec2* sourceShapes, size_t sourceCount,
+                              std::vector<glm::vec2>& shapeValues, size_t firstRoad) {
+    // Keyed on begin and count, as a range may start where a longer one does
+    std::unordered_map<uint64_t, uint32_t> copies;
+    for (size_t id = firstRoad; id < roadValues.size(); ++id) {
+        Road& road = roadValues[id];
+        if (road.shapeCount == 0 || road.shapeBegin > sourceCount || road.shapeCount > sourceCount - road.shapeBegin) {
+            road.shapeBegin = 0;
+            road.shapeCount = 0;
+            continue;
+        }
+        uint64_t key = (static_cast<uint64_t>(road.shapeBegin) << 32) | road.shapeCount;
+        auto copy = copies.emplace(key, static_cast<uint32_t>(shapeValues.size()));
+        if (copy.second) {
+            shapeValues.insert(shapeValues.end(), sourceShapes + road.shapeBegin, sourceShapes + road.shapeBegin + road.shapeCount);
+        }
+        road.shapeBegin = copy.first->second;
+    }
+}
+
+const Adjacency& RoadGraph::getAdjacency() const {
+    return getAdjacency(adjacency, adjacencyBuilt, Adjacency::Outgoing);
+}
+
+Adjacency::Range RoadGraph::getNeighbors(int id) const {
+    return getAdjacency().getNeighbors(id);
+}
+
+const Adjacency& RoadGraph::getReverseAdjacency() const {
+    return getAdjacency(reverseAdjacency, reverseAdjacencyBuilt, Adjacency::Incoming);
+}
+
+Adjacency::Range RoadGraph::getIncoming(int id) const {
+    return getReverseAdjacency().getNeighbors(id);
+}
+
+void RoadGraph::releaseReverseAdjacency() {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    reverseAdjacency = Adjacency();
+    reverseAdjacencyBuilt.store(false, std::memory_order_release);
+}
+
+const RoadColumns& RoadGraph::getRoadColumns() const {
+    if (!roadColumnsBuilt.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!roadColumnsBuilt.load(std::memory_order_relaxed)) {
+            roadColumns.build(roads);
+            roadColumnsBuilt.store(true, std::memory_order_release);
+        }
+    }
+    return roadColumns;
+}
+
+const NodeGrid& RoadGraph::getNodeGrid() const {
+    if (!nodeGridBuilt.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!nodeGridBuilt.load(std::memory_order_relaxed)) {
+            nodeGrid.build(nodes, minCoords, maxCoords);
+            nodeGridBuilt.store(true, std::memory_order_release);
+        }
+    }
+    return nodeGrid;
+}
+
+const RoadTree& RoadGraph::getRoadTree() const {
+    if (!roadTreeBuilt.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!roadTreeBuilt.load(std::memory_order_relaxed)) {
+            roadTree.build(*this);
+            roadTreeBuilt.store(true, std::memory_order_release);
+        }
+    }
+    return roadTree;
+}
+
 bool RoadGraph::roadExists(int from, int to) const {
-    auto it = adjacentNodes.find(from);
-    if (it != adjacentNodes.end()) {
-        const auto& nodes = it->second;
-        return std::find(nodes.begin(), nodes.end(), to) != nodes.end();
+    return findRoad(from, to) >= 0;
+}
+
+int RoadGraph::findRoad(int from, int to) const {
+    return getAdjacency().findRoad(from, to);
+}
+
+std::vector<int> RoadGraph::findRoads(const std::vector<int>& path) const {
+    const Adjacency& index = getAdjacency();
+    std::vector<int> roadIds;
+    for (size_t i = 1; i < path.size(); ++i) {
+        roadIds.push_back(index.findRoad(path[i - 1], path[i]));
     }
-    return false;
+    return roadIds;
 }
 
 bool RoadGraph::roadExists(int id) const {
-    return roads.find(id) != roads.end();
+    return id >= 0 && static_cast<size_t>(id) < roads.size() && roads[id].from >= 0;
 }
 
 bool RoadGraph::nodeExists(int id) const {
-    return nodes.find(id) != nodes.end();
+    // Ids skipped by the source are padded with NaN positions
+    return id >= 0 && static_cast<size_t>(id) < nodes.size() && !std::isnan(nodes[id].position.x);
+}
+
+int RoadGraph::getNodeId(int externalId) const {
+    if (externalIds.empty()) {
+        return externalId;
+    }
+    if (externalIdOrder.empty()) {
+        const int* it = std::lower_bound(externalIds.begin(), externalIds.end(), externalId);
+        return it != externalIds.end() && *it == externalId ? static_cast<int>(it - externalIds.begin()) : -1;
+    }
+    const int* it = std::lower_bound(externalIdOrder.begin(), externalIdOrder.end(), externalId,
+                                     [this](int id, int value) { return externalIds[id] < value; });
+    return it != externalIdOrder.end() && externalIds[*it] == externalId ? *it : -1;
+}
+
+int RoadGraph::getExternalId(int id) const {
+    if (externalIds.empty()) {
+        return id;
+    }
+    return id >= 0 && static_cast<size_t>(id) < externalIds.size() ? externalIds[id] : -1;
 }
 
 void RoadGraph::addNode(int id, const glm::vec3& position) {
-    nodes[id] = position;
+    if (id < 0) {
+        std::cerr << "Invalid node id: " << id << std::endl;
+        return;
+    }
+    if (nodeExists(id)) {
+        setNodePosition(id, position);
+        return;
+    }
+
+    std::vector<Node>& values = nodes.values();
+    if (static_cast<size_t>(id) >= values.size()) {
+        values.resize(id + 1, Node(glm::vec3(std::numeric_limits<float>::quiet_NaN())));
+    }
+
+    values[id] = position;
     updateBoundingBox(position);
+    center = (minCoords + maxCoords) / 2.0f;
+    dirtyNodes.add(id);
+    // Searches size their state by the adjacency, so it covers every node
+    for (auto index : {std::make_pair(&adjacency, &adjacencyBuilt), std::make_pair(&reverseAdjacency, &reverseAdjacencyBuilt)}) {
+        if (index.second->load(std::memory_order_acquire)) {
+            index.first->addNodes(values.size());
+        }
+    }
+    // Roads added before their end node can be drawn now
+    updateRoadsTouching(id);
+    nodeGridBuilt.store(false, std::memory_order_release);
 }
 
-void RoadGraph::addRoad(int id, int from, int to, float meters, float maxSpeed, int lanes) {
-    adjacentNodes[from].push_back(to);
+void RoadGraph::addRoad(int id, int from, int to, float meters, float maxSpeed, int lanes, bool twoWay) {
+    if (id < 0) {
+        std::cerr << "Invalid road id: " << id << std::endl;
+        return;
+    }
+
+    std::vector<Road>& values = roads.values();
+    if (static_cast<size_t>(id) >= values.size()) {
+        values.resize(id + 1, Road(-1, -1, 0.0f, 0.0f, 0));
+    }
+
+    Road previous = values[id];
+    values[id] = Road(from, to, meters, maxSpeed, lanes, 0, 0, twoWay);
+    dirtyRoads.add(id);
+    updateRoadIndexes(id, previous);
+}
+
+bool RoadGraph::setNodePosition(int id, const glm::vec3& position) {
+    if (!nodeExists(id)) {
+        std::cerr << "Node not found: " << id << std::endl;
+        return false;
+    }
+
+    std::vector<Node>& values = nodes.values();
+    glm::vec3 previous = values[id].position;
+    values[id] = position;
+
+    // The box can only shrink if the node held one of its sides
+    if (glm::any(glm::equal(previous, minCoords)) || glm::any(glm::equal(previous, maxCoords))) {
+        recomputeBoundingBox();
+    } else {
+        updateBoundingBox(position);
+    }
+    center = (minCoords + maxCoords) / 2.0f;
+
+    dirtyNodes.add(id);
+    updateRoadsTouching(id);
+    nodeGridBuilt.store(false, std::memory_order_release);
+    return true;
+}
+
+bool RoadGraph::setRoadAttributes(int id, float meters, float maxSpeed, int lanes) {
+    if (!roadExists(id)) {
+        std::cerr << "Road not found: " << id << std::endl;
+        return false;
+    }
+
+    Road& road = roads.values()[id];
+    road.meters = meters;
+    road.maxSpeed = maxSpeed;
+    road.lanes = lanes;
+
+    // Topology and geometry are unchanged, so only the road's own columns need refreshing
+    dirtyRoads.add(id);
+    if (roadColumnsBuilt.load(std::memory_order_acquire)) {
+        roadColumns.update(roads, id);
+    }
+    return true;
+}
+
+bool RoadGraph::removeNode(int id) {
+    if (!nodeExists(id)) {
+        std::cerr << "Node not found: " << id << std::endl;
+        return false;
+    }
+
+    // Collected before any removal, which changes the adjacency used to find them
+    std::vector<int> touching;
+    collectRoadsTouching(id, touching);
+    for (int road : touching) {
+        if (roadExists(road)) {
+            removeRoad(road);
+        }
+    }
+
+    std::vector<Node>& values = nodes.values();
+    glm::vec3 previous = values[id].position;
+    values[id] = Node(glm::vec3(std::numeric_limits<float>::quiet_NaN()));
+    if (glm::any(glm::equal(previous, minCoords)) || glm::any(glm::equal(previous, maxCoords))) {
+        recomputeBoundingBox();
+        center = (minCoords + maxCoords) / 2.0f;
+    }
+
+    dirtyNodes.add(id);
+    nodeGridBuilt.store(false, std::memory_order_release);
+    return true;
+}
+
+bool RoadGraph::removeRoad(int id) {
+    if (!roadExists(id)) {
+        std::cerr << "Road not found: " << id << std::endl;
+        return false;
+    }
 
-    Road road = Road(from, to, meters, maxSpeed, lanes);
-    roads[id] = road;
+    Road previous = roads[id];
+    roads.values()[id] = Road(-1, -1, 0.0f, 0.0f, 0);
+    dirtyRoads.add(id);
+    updateRoadIndexes(id, previous);
+    return true;
+}
+
+bool RoadGraph::hasChanges() const {
+    return !dirtyNodes.empty() || !dirtyRoads.empty();
+}
+
+void RoadGraph::takeChanges(std::vector<DirtyRanges::Range>& nodeRanges, std::vector<DirtyRanges::Range>& roadRanges) {
+    nodeRanges = dirtyNodes.take();
+    roadRanges = dirtyRoads.take();
+}
+
+void RoadGraph::reorderAlongHilbertCurve() {
+    glm::vec3 extent = maxCoords - minCoords;
+    float scale = static_cast<float>((1u << hilbertOrder) - 1) / std::max(std::max(extent.x, extent.y), 1.0f);
+
+    std::vector<std::pair<uint64_t, int>> order;
+    order.reserve(nodes.size());
+    for (size_t id = 0; id < nodes.size(); ++id) {
+        if (nodeExists(static_cast<int>(id))) {
+            glm::vec3 position = nodes[id].position;
+            uint32_t x = static_cast<uint32_t>((position.x - minCoords.x) * scale);
+            uint32_t y = static_cast<uint32_t>((position.y - minCoords.y) * scale);
+            order.emplace_back(getHilbertIndex(x, y), static_cast<int>(id));
+        }
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<int> newIds(nodes.size(), -1);
+    std::vector<Node> nodeValues;
+    std::vector<int> sourceIds;
+    nodeValues.reserve(order.size());
+    sourceIds.reserve(order.size());
+    for (const auto& entry : order) {
+        newIds[entry.second] = static_cast<int>(nodeValues.size());
+        nodeValues.push_back(nodes[entry.second]);
+        sourceIds.push_back(getExternalId(entry.second));
+    }
+
+    std::vector<int> sourceOrder(sourceIds.size());
+    std::iota(sourceOrder.begin(), sourceOrder.end(), 0);
+    std::sort(sourceOrder.begin(), sourceOrder.end(), [&sourceIds](int a, int b) { return sourceIds[a] < sourceIds[b]; });
+
+    // Roads follow their start nodes, keeping their relative order per node
+    size_t roadCount = roads.size();
+    std::vector<std::pair<int, uint32_t>> roadOrder;
+    roadOrder.reserve(roads.size());
+    for (size_t id = 0; id < roads.size(); ++id) {
+        const Road& road = roads[id];
+        if (nodeExists(road.from) && nodeExists(road.to)) {
+            roadOrder.emplace_back(newIds[road.from], static_cast<uint32_t>(id));
+        }
+    }
+    std::stable_sort(roadOrder.begin(), roadOrder.end(),
+                     [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) { return a.first < b.first; });
+
+    std::vector<Road> roadValues;
+    std::vector<glm::vec2> shapeValues;
+    roadValues.reserve(roadOrder.size());
+    shapeValues.reserve(shapePoints.size());
+    for (const auto& entry : roadOrder) {
+        Road road = roads[entry.second];
+        road.from = newIds[road.from];
+        road.to = newIds[road.to];
+        roadValues.push_back(road);
+    }
+    compactShapes(roadValues, shapePoints.data(), shapePoints.size(), shapeValues);
+
+    nodes.assign(std::move(nodeValues));
+    roads.assign(std::move(roadValues));
+    shapePoints.assign(std::move(shapeValues));
+    externalIds.assign(std::move(sourceIds));
+    externalIdOrder.assign(std::move(sourceOrder));
+    invalidateIndexes();
+
+    // Every id may have changed, including ones past the new ends
+    dirtyNodes.add(0, static_cast<int>(newIds.size()));
+    dirtyRoads.add(0, static_cast<int>(std::max(roadCount, roads.size())));
 }
 
 void RoadGraph::updateBoundingBox(const glm::vec3& position) {
     maxCoords = glm::max(maxCoords, position);
     minCoords = glm::min(minCoords, position);
-}
\ No newline at end of file
+}
+
+void RoadGraph::recomputeBoundingBox() {
+    maxCoords = glm::vec3(-std::numeric_limits<float>::max());
+    minCoords = glm::vec3(std::numeric_limits<float>::max());
+    for (const Node& node : nodes) {
+        if (!std::isnan(node.position.x)) {
+            updateBoundingBox(node.position);
+        }
+    }
+}
+
+void RoadGraph::collectRoadsTouching(int node, std::vector<int>& touching) const {
+    touching.clear();
+    // Without the adjacency, one scan over the roads is far cheaper than
+    // building it for a single edit
+    if (!adjacencyBuilt.load(std::memory_order_acquire)) {
+        for (size_t id = 0; id < roads.size(); ++id) {
+            const Road& road = roads[id];
+            if (road.from >= 0 && (road.from == node || road.to == node)) {
+                touching.push_back(static_cast<int>(id));
+            }
+        }
+        return;
+    }
+
+    // The adjacency lists two-way roads at both ends, leaving the one-way
+    // roads arriving at the node, which the reverse index has if it is kept
+    for (const Adjacency::Edge& edge : adjacency.getNeighbors(node)) {
+        touching.push_back(edge.road);
+    }
+    if (reverseAdjacencyBuilt.load(std::memory_order_acquire)) {
+        for (const Adjacency::Edge& edge : reverseAdjacency.getNeighbors(node)) {
+            if (!roads[edge.road].twoWay) {
+                touching.push_back(edge.road);
+            }
+        }
+        return;
+    }
+    for (size_t id = 0; id < roads.size(); ++id) {
+        const Road& road = roads[id];
+        if (road.from >= 0 && road.to == node && !road.twoWay) {
+            touching.push_back(static_cast<int>(id));
+        }
+    }
+}
+
+void RoadGraph::updateRoadsTouching(int node) {
+    std::vector<int> touching;
+    collectRoadsTouching(node, touching);
+    for (int road : touching) {
+        dirtyRoads.add(road);
+        if (roadTreeBuilt.load(std::memory_order_acquire) && !roadTree.update(*this, road)) {
+            roadTreeBuilt.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void RoadGraph::updateRoadIndexes(int id, const Road& previous) {
+    for (auto index : {std::make_pair(&adjacency, &adjacencyBuilt), std::make_pair(&reverseAdjacency, &reverseAdjacencyBuilt)}) {
+        if (index.second->load(std::memory_order_acquire)) {
+            index.first->remove(previous, id);
+            if (!index.first->add(roads[id], id)) {
+                index.second->store(false, std::memory_order_release);
+            }
+        }
+    }
+    if (roadTreeBuilt.load(std::memory_order_acquire) && !roadTree.update(*this, id)) {
+        roadTreeBuilt.store(false, std::memory_order_release);
+    }
+    if (roadColumnsBuilt.load(std::memory_order_acquire)) {
+        roadColumns.update(roads, id);
+    }
+}
+
+const Adjacency& RoadGraph::getAdjacency(Adjacency& index, std::atomic<bool>& built, Adjacency::Direction direction) const {
+    if (!built.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!built.load(std::memory_order_relaxed)) {
+            index.build(roads, nodes.size(), direction);
+            built.store(true, std::memory_order_release);
+        }
+    }
+    return index;
+}
+
+// Derived indexes are rebuilt on next use; modifiers are not safe to call concurrently anyway
+void RoadGraph::invalidateIndexes() {
+    adjacencyBuilt.store(false, std::memory_order_release);
+    reverseAdjacencyBuilt.store(false, std::memory_order_release);
+    roadColumnsBuilt.store(false, std::memory_order_release);
+    nodeGridBuilt.store(false, std::memory_order_release);
+    roadTreeBuilt.store(false, std::memory_order_release);
+}
@@ -1,18 +1,37 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
 #include <glm/glm.hpp>
 
+#include "Adjacency.h"
+#include "Column.h"
+#include "DirtyRanges.h"
+#include "NodeGrid.h"
+#include "RoadColumns.h"
+#include "RoadTree.h"
+
+class GraphFile;
+
 struct Road {
     int from, to;
     float meters;
     float maxSpeed;
     int lanes;
+    // Points between the two end nodes, from start to end, as a range of the graph's shape points
+    uint32_t shapeBegin;
+    uint32_t shapeCount : 31;
+    // Two-way roads are stored and drawn once; the adjacency lists them at both ends
+    uint32_t twoWay : 1;
 
     Road() {}
-    Road(int from, int to, float meters, float maxSpeed, int lanes): from(from), to(to), meters(meters), maxSpeed(maxSpeed), lanes(lanes) {}
+    Road(int from, int to, float meters, float maxSpeed, int lanes, uint32_t shapeBegin = 0, uint32_t shapeCount = 0, bool twoWay = false):
+        from(from), to(to), meters(meters), maxSpeed(maxSpeed), lanes(lanes), shapeBegin(shapeBegin), shapeCount(shapeCount), twoWay(twoWay) {}
 };
 
 struct Node {
@@ -22,34 +41,147 @@ struct Node {
     Node(const glm::vec3& position): position(position) {}
 };
 
+// Render-ready slice of a graph, handed out while the graph is still loading
+struct GraphBatch {
+    std::vector<glm::vec3> nodePositions;
+    std::vector<glm::vec3> roadSegments;
+};
+
 class RoadGraph {
 public:
-    RoadGraph(const std::string& nodesFile, const std::string& edgesFile);
+    // May be called from several loader threads at once
+    using BatchCallback = std::function<void(GraphBatch&&)>;
+
+    RoadGraph(const std::string& nodesFile, const std::string& edgesFile, const BatchCallback& onBatch = nullptr);
+    explicit RoadGraph(const std::string& graphFile);
+    explicit RoadGraph(std::unique_ptr<GraphFile> graphFile);
+    // Id-indexed arrays built elsewhere, e.g. by the importers
+    RoadGraph(std::vector<Node> nodeValues, std::vector<Road> roadValues, std::vector<glm::vec2> shapeValues = {},
+              std::vector<int> externalIdValues = {}, std::vector<int> externalIdOrderValues = {});
+    ~RoadGraph();
 
     // Getters
-    const std::unordered_map<int, Node>& getNodes() const;
-    const std::unordered_map<int, Road>& getRoads() const;
+    const Column<Node>& getNodes() const;
+    const Column<Road>& getRoads() const;
+    const Column<glm::vec2>& getShapePoints() const;
+    // Source id of every node; empty when nodes keep their source ids
+    const Column<int>& getExternalIds() const;
+    // Node ids ordered by source id; empty while the source ids are ascending
+    const Column<int>& getExternalIdOrder() const;
     glm::vec3 getNodePosition(int id) const;
+    // No bounds or existence checks, for loops over ids known to be valid
+    const glm::vec3& getNodePositionUnchecked(int id) const { return nodes[id].position; }
+    const Road& getRoadUnchecked(int id) const { return roads[id]; }
     glm::vec3 getCenter() const;
+    glm::vec3 getMinCoords() const;
+    glm::vec3 getMaxCoords() const;
     float getRadius() const;
+    void splitIntoBatches(const BatchCallback& onBatch, size_t batchSize = 1 << 16) const;
+    // Appends the road's polyline as line segment end points
+    void appendRoadSegments(const Road& road, std::vector<glm::vec3>& segments) const;
+    // Shape points lie in the plane of the start node; reversed walks them backwards
+    static void appendPolyline(std::vector<glm::vec3>& segments, const glm::vec3& from, const glm::vec3& to,
+                               const glm::vec2* shape, size_t count, bool reversed);
+    // Sources like osmnx store a two-way street once per direction. Joins each
+    // two-way road with one from its end to its start of the same length,
+    // along the same shape walked backwards, into a single road; a pair that differs in speed or
+    // lanes becomes two one-way roads instead. Remaining roads keep their
+    // order, and shape points only the dropped roads used are removed.
+    // Returns the number of roads dropped.
+    static size_t mergeReciprocalRoads(std::vector<Road>& roadValues, std::vector<glm::vec2>& shapeValues);
+    // Copies the shape ranges of the roads from firstRoad on to the end of
+    // shapeValues, in road order, and points the roads at the copies. Roads
+    // with the same range share one copy; ranges outside the source are cleared.
+    static void compactShapes(std::vector<Road>& roadValues, const glm::vec2* sourceShapes, size_t sourceCount,
+                              std::vector<glm::vec2>& shapeValues, size_t firstRoad = 0);
+
+    // Built on first use; safe to call from several threads. Edits patch it
+    // in place. A road added where no earlier removal left room has it
+    // rebuilt on next use.
+    const Adjacency& getAdjacency() const;
+    Adjacency::Range getNeighbors(int id) const;
+    // Roads arriving at each node, for backward searches. Only built when asked
+    // for, and can be released again where memory is tight.
+    const Adjacency& getReverseAdjacency() const;
+    Adjacency::Range getIncoming(int id) const;
+    void releaseReverseAdjacency();
+    // Packed per-road speed, lanes, length and travel time, built on first use
+    const RoadColumns& getRoadColumns() const;
+    // Grid over the node positions for nearest and range queries, built on first use
+    const NodeGrid& getNodeGrid() const;
+    // R-tree over the road geometry for snapping positions to roads, built on first use
+    const RoadTree& getRoadTree() const;
 
     // Query methods
     bool roadExists(int from, int to) const;
+    // Id of a road that can be travelled from one node to the other, -1 if none
+    int findRoad(int from, int to) const;
+    // Roads between consecutive nodes of a path, e.g. a route; -1 where there is none
+    std::vector<int> findRoads(const std::vector<int>& path) const;
     bool roadExists(int id) const;
     bool nodeExists(int id) const;
+    // Translate between source ids and node ids; -1 if the source id is unknown
+    int getNodeId(int externalId) const;
+    int getExternalId(int id) const;
 
-    // Modifiers
+    // Modifiers. Each records the ids it touched for takeChanges, keeps the
+    // bounding box current and patches the built indexes the edit affects,
+    // dropping only those that cannot take it. Adding an existing id replaces it.
     void addNode(int id, const glm::vec3& position);
-    void addRoad(int id, int from, int to, float meters, float maxSpeed, int lanes);
+    void addRoad(int id, int from, int to, float meters, float maxSpeed, int lanes, bool twoWay = false);
+    // Roads touching a moved node change shape and are recorded as well
+    bool setNodePosition(int id, const glm::vec3& position);
+    bool setRoadAttributes(int id, float meters, float maxSpeed, int lanes);
+    // Removed ids become holes; removing a node removes the roads touching it
+    bool removeNode(int id);
+    bool removeRoad(int id);
+    // Node and road ids modified since the last call, as sorted ranges
+    bool hasChanges() const;
+    void takeChanges(std::vector<DirtyRanges::Range>& nodeRanges, std::vector<DirtyRanges::Range>& roadRanges);
+    // Renumbers nodes in the order a Hilbert curve visits their positions and
+    // roads by start node, so nodes close in space are close in memory. Missing
+    // nodes and roads touching them are dropped. The previous ids are kept as
+    // external ids, so getNodeId still accepts them.
+    void reorderAlongHilbertCurve();
 
 private:
-    std::unordered_map<int, Node> nodes;
-    std::unordered_map<int, Road> roads;
-    std::unordered_map<int, std::vector<int>> adjacentNodes;
+    // Nodes and roads are indexed by id; both may live inside a mapped graph file
+    Column<Node> nodes;
+    Column<Road> roads;
+    Column<glm::vec2> shapePoints;
+    Column<int> externalIds;
+    Column<int> externalIdOrder;
+    std::unique_ptr<GraphFile> graphFile;
+
+    // Built on first use, so mapped graphs do no per-record work at load time
+    mutable Adjacency adjacency;
+    mutable Adjacency reverseAdjacency;
+    mutable std::mutex indexMutex;
+    mutable std::atomic<bool> adjacencyBuilt{false};
+    mutable std::atomic<bool> reverseAdjacencyBuilt{false};
+    mutable RoadColumns roadColumns;
+    mutable std::atomic<bool> roadColumnsBuilt{false};
+    mutable NodeGrid nodeGrid;
+    mutable std::atomic<bool> nodeGridBuilt{false};
+    mutable RoadTree roadTree;
+    mutable std::atomic<bool> roadTreeBuilt{false};
+
+    DirtyRanges dirtyNodes;
+    DirtyRanges dirtyRoads;
 
     glm::vec3 maxCoords;
     glm::vec3 minCoords;
     glm::vec3 center;
 
     void updateBoundingBox(const glm::vec3& position);
-};
\ No newline at end of file
+    // Scans every node; only needed when a node on the edge of the box moves inward
+    void recomputeBoundingBox();
+    // Roads starting or ending at the node, found without building an index
+    void collectRoadsTouching(int node, std::vector<int>& touching) const;
+    // Redraws and re-indexes the roads of a node that was added or moved
+    void updateRoadsTouching(int node);
+    // Patches the built indexes for a road that was previous before the edit
+    void updateRoadIndexes(int id, const Road& previous);
+    const Adjacency& getAdjacency(Adjacency& index, std::atomic<bool>& built, Adjacency::Direction direction) const;
+    void invalidateIndexes();
+};
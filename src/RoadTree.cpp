@@ -0,0 +1,205 @@
+#include "RoadTree.h"
+#include "Parallel.h"
+#include "RoadGraph.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace {
+    // Entries per box; a leaf's segments fit a few cache lines
+    const size_t boxCapacity = 8;
+    // Edited segments searched linearly before a rebuild pays off, at least
+    // this many and at least a share of the tree
+    const size_t minEditedSegments = 1024;
+    const size_t editedSegmentShare = 32;
+
+    float getBoxDistanceSquared(const glm::vec2& point, const glm::vec2& minCorner, const glm::vec2& maxCorner) {
+        glm::vec2 offset = glm::max(glm::max(minCorner - point, point - maxCorner), glm::vec2(0.0f));
+        return glm::dot(offset, offset);
+    }
+
+    // Sort-Tile-Recursive order: vertical slices by x, each sorted by y, so
+    // every run of boxCapacity items covers a compact tile
+    template<typename T, typename Center>
+    void sortTiles(std::vector<T>& items, Center getCenter) {
+        size_t groupCount = (items.size() + boxCapacity - 1) / boxCapacity;
+        size_t sliceCount = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(groupCount))));
+        size_t sliceSize = sliceCount == 0 ? items.size() : ((groupCount + sliceCount - 1) / sliceCount) * boxCapacity;
+
+        std::sort(items.begin(), items.end(), [&](const T& a, const T& b) { return getCenter(a).x < getCenter(b).x; });
+        for (size_t begin = 0; begin < items.size(); begin += sliceSize) {
+            auto first = items.begin() + begin;
+            auto last = items.begin() + std::min(items.size(), begin + sliceSize);
+            std::sort(first, last, [&](const T& a, const T& b) { return getCenter(a).y < getCenter(b).y; });
+        }
+    }
+}
+
+/* METHODS */
+void RoadTree::build(const RoadGraph& graph) {
+    segments.clear();
+    boxes.clear();
+    levelBegins.clear();
+    editedRoads.clear();
+    editedSegments.clear();
+
+    std::vector<glm::vec3> polyline;
+    for (size_t id = 0; id < graph.getRoads().size(); ++id) {
+        appendSegments(graph, static_cast<int>(id), polyline, segments);
+    }
+    if (segments.empty()) {
+        return;
+    }
+
+    sortTiles(segments, [](const Segment& segment) { return (segment.from + segment.to) * 0.5f; });
+
+    // Leaves over the segments, then levels of boxes over the level below
+    levelBegins.push_back(0);
+    for (size_t first = 0; first < segments.size(); first += boxCapacity) {
+        Box box = {glm::vec2(std::numeric_limits<float>::max()), glm::vec2(-std::numeric_limits<float>::max()),
+                   static_cast<uint32_t>(first), static_cast<uint32_t>(std::min(boxCapacity, segments.size() - first))};
+        for (size_t i = first; i < first + box.count; ++i) {
+            box.minCorner = glm::min(box.minCorner, glm::min(segments[i].from, segments[i].to));
+            box.maxCorner = glm::max(box.maxCorner, glm::max(segments[i].from, segments[i].to));
+        }
+        boxes.push_back(box);
+    }
+
+    while (boxes.size() - levelBegins.back() > 1) {
+        // Reorder the level before its parents are made, while nothing points into it
+        std::vector<Box> level(boxes.begin() + levelBegins.back(), boxes.end());
+        sortTiles(level, [](const Box& box) { return (box.minCorner + box.maxCorner) * 0.5f; });
+        std::copy(level.begin(), level.end(), boxes.begin() + levelBegins.back());
+
+        size_t childBegin = levelBegins.back();
+        levelBegins.push_back(boxes.size());
+        for (size_t first = 0; first < level.size(); first += boxCapacity) {
+            Box box = {glm::vec2(std::numeric_limits<float>::max()), glm::vec2(-std::numeric_limits<float>::max()),
+                       static_cast<uint32_t>(childBegin + first), static_cast<uint32_t>(std::min(boxCapacity, level.size() - first))};
+            for (size_t i = first; i < first + box.count; ++i) {
+                box.minCorner = glm::min(box.minCorner, level[i].minCorner);
+                box.maxCorner = glm::max(box.maxCorner, level[i].maxCorner);
+            }
+            boxes.push_back(box);
+        }
+    }
+}
+
+bool RoadTree::update(const RoadGraph& graph, int road) {
+    if (road < 0) {
+        return true;
+    }
+    if (static_cast<size_t>(road) >= editedRoads.size()) {
+        editedRoads.resize(road + 1, false);
+    }
+    editedRoads[road] = true;
+    editedSegments.erase(std::remove_if(editedSegments.begin(), editedSegments.end(),
+                                        [road](const Segment& segment) { return segment.road == road; }),
+                         editedSegments.end());
+    std::vector<glm::vec3> polyline;
+    appendSegments(graph, road, polyline, editedSegments);
+    return editedSegments.size() <= std::max(minEditedSegments, segments.size() / editedSegmentShare);
+}
+
+bool RoadTree::snap(const glm::vec2& point, Snap& result, float maxDistance) const {
+    // Distances are squared while searching
+    result = Snap();
+    result.distance = maxDistance * maxDistance;
+    if (!boxes.empty()) {
+        const Box& root = boxes.back();
+        if (getBoxDistanceSquared(point, root.minCorner, root.maxCorner) <= result.distance) {
+            search(root, getHeight(), point, result);
+        }
+    }
+    for (const Segment& segment : editedSegments) {
+        testSegment(segment, point, result);
+    }
+    result.distance = std::sqrt(result.distance);
+    return result.road >= 0;
+}
+
+void RoadTree::snap(const std::vector<glm::vec2>& points, std::vector<Snap>& results, size_t workerCount) const {
+    results.resize(points.size());
+
+    // Chunks amortize the hand-out of indices over many cheap queries
+    const size_t chunkSize = 1024;
+    size_t chunkCount = (points.size() + chunkSize - 1) / chunkSize;
+    parallelFor(chunkCount, [&](size_t chunk) {
+        size_t end = std::min(points.size(), (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; ++i) {
+            snap(points[i], results[i]);
+        }
+    }, workerCount);
+}
+
+size_t RoadTree::memoryUsage() const {
+    return (segments.capacity() + editedSegments.capacity()) * sizeof(Segment) + boxes.capacity() * sizeof(Box) +
+           levelBegins.capacity() * sizeof(size_t) + editedRoads.capacity() / 8;
+}
+
+void RoadTree::appendSegments(const RoadGraph& graph, int road, std::vector<glm::vec3>& polyline, std::vector<Segment>& result) {
+    if (!graph.roadExists(road)) {
+        return;
+    }
+    const Road& value = graph.getRoadUnchecked(road);
+    if (!graph.nodeExists(value.from) || !graph.nodeExists(value.to)) {
+        return;
+    }
+
+    polyline.clear();
+    graph.appendRoadSegments(value, polyline);
+    float offset = 0.0f;
+    for (size_t i = 0; i + 1 < polyline.size(); i += 2) {
+        Segment segment = {glm::vec2(polyline[i]), glm::vec2(polyline[i + 1]), road, offset};
+        offset += glm::distance(segment.from, segment.to);
+        result.push_back(segment);
+    }
+}
+
+void RoadTree::testSegment(const Segment& segment, const glm::vec2& point, Snap& best) {
+    glm::vec2 direction = segment.to - segment.from;
+    float lengthSquared = glm::dot(direction, direction);
+    float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(point - segment.from, direction) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+    glm::vec2 projected = segment.from + direction * t;
+    glm::vec2 offset = point - projected;
+    float distanceSquared = glm::dot(offset, offset);
+    if (distanceSquared < best.distance) {
+        best.road = segment.road;
+        best.point = projected;
+        best.distance = distanceSquared;
+        best.offset = segment.offset + std::sqrt(lengthSquared) * t;
+    }
+}
+
+void RoadTree::search(const Box& box, size_t level, const glm::vec2& point, Snap& best) const {
+    if (level == 0) {
+        // Edited roads are searched with their current segments instead
+        for (uint32_t i = box.first; i < box.first + box.count; ++i) {
+            const Segment& segment = segments[i];
+            if (static_cast<size_t>(segment.road) >= editedRoads.size() || !editedRoads[segment.road]) {
+                testSegment(segment, point, best);
+            }
+        }
+        return;
+    }
+
+    // Visit children nearest first, so far ones are mostly pruned. Inserted
+    // in order as they are measured, which beats a sort for so few.
+    std::array<std::pair<float, uint32_t>, boxCapacity> children;
+    uint32_t count = 0;
+    for (uint32_t i = box.first; i < box.first + box.count && count < boxCapacity; ++i) {
+        float distanceSquared = getBoxDistanceSquared(point, boxes[i].minCorner, boxes[i].maxCorner);
+        if (distanceSquared > best.distance) {
+            continue;
+        }
+        uint32_t slot = count++;
+        for (; slot > 0 && children[slot - 1].first > distanceSquared; --slot) {
+            children[slot] = children[slot - 1];
+        }
+        children[slot] = std::make_pair(distanceSquared, i);
+    }
+    for (uint32_t i = 0; i < count && children[i].first <= best.distance; ++i) {
+        search(boxes[children[i].second], level - 1, point, best);
+    }
+}
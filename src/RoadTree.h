@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+
+class RoadGraph;
+
+// R-tree over the straight pieces of every road, shape points included, for
+// snapping positions to the closest road. Bulk loaded with Sort-Tile-Recursive
+// packing into flat arrays, so a built tree is immutable and any number of
+// threads can query it at once without locking. Roads edited after building
+// are searched linearly beside the tree until it is rebuilt.
+class RoadTree {
+public:
+    struct Snap {
+        int road = -1;
+        // Closest point on the road and its distance from the query
+        glm::vec2 point = glm::vec2(0.0f);
+        float distance = std::numeric_limits<float>::infinity();
+        // Distance along the road's geometry from its start node to point
+        float offset = 0.0f;
+    };
+
+    void build(const RoadGraph& graph);
+    // Takes a road's current geometry, or its removal, without rebuilding.
+    // Returns false once edited roads hold so many segments that a rebuild
+    // is faster to search. Not safe to call while the tree is queried.
+    bool update(const RoadGraph& graph, int road);
+
+    // Returns false if no road lies within maxDistance
+    bool snap(const glm::vec2& point, Snap& result, float maxDistance = std::numeric_limits<float>::infinity()) const;
+    // One snap per point, spread over the workers; unsnapped points get road -1
+    void snap(const std::vector<glm::vec2>& points, std::vector<Snap>& results, size_t workerCount = 0) const;
+
+    size_t getSegmentCount() const { return segments.size(); }
+    size_t getHeight() const { return levelBegins.empty() ? 0 : levelBegins.size() - 1; }
+    size_t memoryUsage() const;
+
+private:
+    struct Segment {
+        glm::vec2 from;
+        glm::vec2 to;
+        int road;
+        float offset;
+    };
+
+    // Children are a contiguous range of the level below, or of the segments
+    // for leaves
+    struct Box {
+        glm::vec2 minCorner;
+        glm::vec2 maxCorner;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    std::vector<Segment> segments;
+    // All levels back to back, leaves first and the root last
+    std::vector<Box> boxes;
+    std::vector<size_t> levelBegins;
+    // Roads whose segments in the tree are out of date, by id, and the
+    // current segments of those roads
+    std::vector<bool> editedRoads;
+    std::vector<Segment> editedSegments;
+
+    // The polyline is scratch space, kept by the caller to reuse its capacity
+    static void appendSegments(const RoadGraph& graph, int road, std::vector<glm::vec3>& polyline, std::vector<Segment>& result);
+    static void testSegment(const Segment& segment, const glm::vec2& point, Snap& best);
+    void search(const Box& box, size_t level, const glm::vec2& point, Snap& best) const;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "RoadColumns.h"
+
+// Result of a point-to-point query. Reusing one across queries keeps the
+// vectors' capacity, so steady-state queries do not allocate.
+struct Route {
+    // Milliseconds at the speed limits, unreachable if there is no route
+    uint32_t travelTime = RoadColumns::unreachable;
+    // Nodes from start to end, and the road taken between each consecutive pair
+    std::vector<int> nodes;
+    std::vector<int> roads;
+    // Nodes taken off the queues, a measure of the work a query did
+    size_t settledNodes = 0;
+
+    bool found() const { return travelTime != RoadColumns::unreachable; }
+    void clear() {
+        travelTime = RoadColumns::unreachable;
+        nodes.clear();
+        roads.clear();
+        settledNodes = 0;
+    }
+};
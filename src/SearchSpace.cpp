@@ -0,0 +1,117 @@
+#include "SearchSpace.h"
+#include <algorithm>
+
+/* METHODS */
+void SearchSpace::reset(size_t nodeCount) {
+    if (states.size() < nodeCount) {
+        states.resize(nodeCount, NodeState{0, 0, 0, -1, -1});
+    }
+    heap.clear();
+    settledCount = 0;
+
+    // Stamp 0 marks never reached; on wrap-around the stamps are cleared once
+    if (++stamp == 0) {
+        for (NodeState& state : states) {
+            state.stamp = 0;
+        }
+        stamp = 1;
+    }
+}
+
+bool SearchSpace::relax(int node, uint32_t distance, uint32_t key, int parentNode, int parentRoad) {
+    NodeState& state = states[node];
+    if (state.stamp != stamp) {
+        state = {stamp, distance, static_cast<uint32_t>(heap.size()), parentNode, parentRoad};
+        heap.push_back({key, node});
+        siftUp(heap.size() - 1);
+        return true;
+    }
+    if (state.heapPosition == settled || distance >= state.distance) {
+        return false;
+    }
+
+    // The key falls by as much as the distance, whatever it adds on top
+    state.distance = distance;
+    state.parentNode = parentNode;
+    state.parentRoad = parentRoad;
+    heap[state.heapPosition].key = key;
+    siftUp(state.heapPosition);
+    return true;
+}
+
+int SearchSpace::settleMin() {
+    int node = heap.front().node;
+    states[node].heapPosition = settled;
+    ++settledCount;
+
+    HeapEntry last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        heap.front() = last;
+        states[last.node].heapPosition = 0;
+        siftDown(0);
+    }
+    return node;
+}
+
+void SearchSpace::getPath(int node, std::vector<int>& nodes, std::vector<int>& roads) const {
+    nodes.clear();
+    roads.clear();
+    if (!isReached(node)) {
+        return;
+    }
+
+    for (int current = node; current >= 0; current = states[current].parentNode) {
+        nodes.push_back(current);
+        if (states[current].parentRoad >= 0) {
+            roads.push_back(states[current].parentRoad);
+        }
+    }
+    std::reverse(nodes.begin(), nodes.end());
+    std::reverse(roads.begin(), roads.end());
+}
+
+size_t SearchSpace::memoryUsage() const {
+    return states.capacity() * sizeof(NodeState) + heap.capacity() * sizeof(HeapEntry);
+}
+
+void SearchSpace::siftUp(size_t position) {
+    HeapEntry entry = heap[position];
+    while (position > 0) {
+        size_t parent = (position - 1) / arity;
+        if (heap[parent].key <= entry.key) {
+            break;
+        }
+        heap[position] = heap[parent];
+        states[heap[position].node].heapPosition = static_cast<uint32_t>(position);
+        position = parent;
+    }
+    heap[position] = entry;
+    states[entry.node].heapPosition = static_cast<uint32_t>(position);
+}
+
+void SearchSpace::siftDown(size_t position) {
+    HeapEntry entry = heap[position];
+    for (;;) {
+        size_t first = position * arity + 1;
+        if (first >= heap.size()) {
+            break;
+        }
+
+        size_t last = std::min(first + arity, heap.size());
+        size_t smallest = first;
+        for (size_t child = first + 1; child < last; ++child) {
+            if (heap[child].key < heap[smallest].key) {
+                smallest = child;
+            }
+        }
+        if (heap[smallest].key >= entry.key) {
+            break;
+        }
+        heap[position] = heap[smallest];
+        states[heap[position].node].heapPosition = static_cast<uint32_t>(position);
+        position = smallest;
+    }
+    heap[position] = entry;
+    states[entry.node].heapPosition = static_cast<uint32_t>(position);
+}
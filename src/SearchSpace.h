@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "RoadColumns.h"
+
+// Per-search state of a shortest path search: tentative travel times, parents
+// and a 4-ary heap of the reached nodes. Each node's state is valid only while
+// its stamp matches the current search, so starting a search bumps the stamp
+// instead of clearing arrays, and a space reused across queries allocates
+// nothing once it has grown to the graph. One space serves one thread.
+class SearchSpace {
+public:
+    // Forgets the previous search; only allocates when the graph has grown
+    void reset(size_t nodeCount);
+
+    bool isReached(int node) const { return states[node].stamp == stamp; }
+    bool isSettled(int node) const { return isReached(node) && states[node].heapPosition == settled; }
+    uint32_t getDistance(int node) const { return isReached(node) ? states[node].distance : RoadColumns::unreachable; }
+    int getParentNode(int node) const { return isReached(node) ? states[node].parentNode : -1; }
+    int getParentRoad(int node) const { return isReached(node) ? states[node].parentRoad : -1; }
+
+    // Records distance if it improves on the node's, queuing the node under
+    // key. Settled nodes are final and left alone.
+    bool relax(int node, uint32_t distance, uint32_t key, int parentNode, int parentRoad);
+    bool empty() const { return heap.empty(); }
+    uint32_t getMinKey() const { return heap.front().key; }
+    // Removes the node with the smallest key from the heap and marks it settled
+    int settleMin();
+    size_t getSettledCount() const { return settledCount; }
+    // Nodes the space has room for; the getters above take no others
+    size_t getNodeCount() const { return states.size(); }
+
+    // Nodes and roads from the search's source to node, in search order
+    void getPath(int node, std::vector<int>& nodes, std::vector<int>& roads) const;
+    size_t memoryUsage() const;
+
+private:
+    // Everything a relaxation touches lies in one record
+    struct NodeState {
+        uint32_t stamp;
+        uint32_t distance;
+        uint32_t heapPosition;
+        int parentNode;
+        int parentRoad;
+    };
+
+    struct HeapEntry {
+        uint32_t key;
+        int node;
+    };
+
+    static constexpr uint32_t settled = UINT32_MAX;
+    static constexpr size_t arity = 4;
+
+    std::vector<NodeState> states;
+    std::vector<HeapEntry> heap;
+    uint32_t stamp = 0;
+    size_t settledCount = 0;
+
+    void siftUp(size_t position);
+    void siftDown(size_t position);
+};
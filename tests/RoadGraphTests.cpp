@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include "BidirectionalAStar.h"
+#include "Dijkstra.h"
+#include "GraphArchive.h"
+#include "RoadGraph.h"
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << std::endl;
+            ++failures;
+        }
+    }
+
+    size_t countEntries(const RoadGraph& graph, int from, int to) {
+        size_t count = 0;
+        for (const Adjacency::Edge& edge : graph.getNeighbors(from)) {
+            count += edge.target == to ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Road of the first entry from one node to the other, -1 if none
+    int firstRoad(const RoadGraph& graph, int from, int to) {
+        for (const Adjacency::Edge& edge : graph.getNeighbors(from)) {
+            if (edge.target == to) {
+                return edge.road;
+            }
+        }
+        return -1;
+    }
+
+    // The osmnx export lists every two-way street as u->v and v->u. A few
+    // node pairs have parallel streets, told apart by their length.
+    void testBundledStreetsAreStoredOnce(const std::string& dataDirectory) {
+        RoadGraph graph(dataDirectory + "/nodes.txt", dataDirectory + "/edges.txt");
+        check(!graph.getRoads().empty(), "bundled graph loads");
+
+        std::map<std::tuple<int, int, float>, size_t> twoWayStreets;
+        for (const Road& road : graph.getRoads()) {
+            if (road.twoWay) {
+                ++twoWayStreets[{std::min(road.from, road.to), std::max(road.from, road.to), road.meters}];
+            }
+        }
+        size_t duplicates = 0;
+        for (const auto& street : twoWayStreets) {
+            duplicates += street.second - 1;
+        }
+        check(duplicates == 0, "no two-way street is stored twice, found " + std::to_string(duplicates));
+
+        check(countEntries(graph, 0, 1) == 1, "0 -> 1 is listed once");
+        check(countEntries(graph, 1, 0) == 1, "1 -> 0 is listed once");
+        check(firstRoad(graph, 0, 1) == firstRoad(graph, 1, 0), "both directions of 0 - 1 are the same road");
+    }
+
+    // Shapes decide which reverse edges are the same street
+    void testShapesAreMatchedBackwards(const std::string& directory) {
+        std::string nodesFile = directory + "/nodes.txt";
+        std::string edgesFile = directory + "/edges.txt";
+        std::ofstream(nodesFile) << "0 0 0 0\n1 10 0 0\n2 20 0 0\n";
+        std::ofstream(edgesFile) << "0 1 12.0 30 2 0 5.000000 1.000000\n"
+                                    "1 0 12.0 30 2 0 5.000000 1.000000\n"
+                                    "1 0 14.0 30 2 0 5.000000 -1.000000\n"
+                                    "0 1 14.0 30 2 0 5.000000 -1.000000\n"
+                                    "1 2 10.0 50 2 0\n"
+                                    "2 1 10.0 30 2 0\n";
+        RoadGraph graph(nodesFile, edgesFile);
+
+        // The two streets between 0 and 1 stay apart; the pair between 1 and 2
+        // differs in speed, so it stays as two one-way roads
+        check(graph.getRoads().size() == 4, "two streets merged, got " + std::to_string(graph.getRoads().size()) + " roads");
+        check(graph.getShapePoints().size() == 2, "shape points of dropped roads are removed");
+        check(countEntries(graph, 0, 1) == 2 && countEntries(graph, 1, 0) == 2, "each street is listed once per direction");
+        check(countEntries(graph, 1, 2) == 1 && countEntries(graph, 2, 1) == 1, "one-way pair is listed once per direction");
+        check(graph.getRoadUnchecked(firstRoad(graph, 1, 2)).maxSpeed == 50.0f, "1 -> 2 keeps its own speed");
+        check(graph.getRoadUnchecked(firstRoad(graph, 2, 1)).maxSpeed == 30.0f, "2 -> 1 keeps its own speed");
+        for (const Road& road : graph.getRoads()) {
+            if (road.from == 1 && road.to == 0) {
+                check(graph.getShapePoints()[road.shapeBegin].y == -1.0f, "second street keeps its own shape");
+            }
+        }
+    }
+
+    // Edits patch the built adjacency and road tree instead of dropping them
+    void testEditsPatchIndexes(const std::string& dataDirectory) {
+        RoadGraph graph(dataDirectory + "/nodes.txt", dataDirectory + "/edges.txt");
+        graph.getAdjacency();
+        graph.getRoadTree();
+
+        Road road = graph.getRoadUnchecked(0);
+        glm::vec2 middle = (glm::vec2(graph.getNodePosition(road.from)) + glm::vec2(graph.getNodePosition(road.to))) * 0.5f;
+        graph.removeRoad(0);
+        check(graph.findRoad(road.from, road.to) != 0, "removed road leaves the adjacency");
+        RoadTree::Snap snap;
+        check(!graph.getRoadTree().snap(middle, snap) || snap.road != 0, "removed road is not snapped to");
+
+        graph.addRoad(0, road.from, road.to, road.meters, road.maxSpeed, road.lanes, road.twoWay);
+        check(graph.findRoad(road.from, road.to) == 0, "added road is in the adjacency");
+        check(graph.getRoadTree().snap(middle, snap) && snap.distance < 1e-3f, "added road is snapped to");
+
+        graph.removeNode(road.to);
+        Column<Road> roads;
+        roads.assign(std::vector<Road>(graph.getRoads().begin(), graph.getRoads().end()));
+        Adjacency rebuilt;
+        rebuilt.build(roads, graph.getNodes().size());
+        bool same = rebuilt.getEdgeCount() == graph.getAdjacency().getEdgeCount();
+        for (size_t node = 0; same && node < graph.getNodes().size(); ++node) {
+            Adjacency::Range expected = rebuilt.getNeighbors(static_cast<int>(node));
+            Adjacency::Range patched = graph.getAdjacency().getNeighbors(static_cast<int>(node));
+            same = expected.size() == patched.size() &&
+                   std::equal(expected.begin(), expected.end(), patched.begin(), [](const Adjacency::Edge& a, const Adjacency::Edge& b) {
+                       return a.target == b.target && a.road == b.road;
+                   });
+        }
+        check(same, "patched adjacency matches a rebuilt one after removing a node");
+    }
+
+    // Three nodes in a row, with the adjacency already built
+    std::unique_ptr<RoadGraph> makeSmallGraph() {
+        std::vector<Node> nodes = {Node(glm::vec3(0.0f)), Node(glm::vec3(10.0f, 0.0f, 0.0f)), Node(glm::vec3(20.0f, 0.0f, 0.0f))};
+        std::vector<Road> roads = {Road(0, 1, 10.0f, 30.0f, 1, 0, 0, true), Road(1, 2, 10.0f, 30.0f, 1, 0, 0, true)};
+        auto graph = std::make_unique<RoadGraph>(std::move(nodes), std::move(roads));
+        graph->getAdjacency();
+        return graph;
+    }
+
+    // The built indexes grow with the nodes instead of being dropped
+    void testAddedNodeExtendsAdjacency() {
+        std::unique_ptr<RoadGraph> small = makeSmallGraph();
+        RoadGraph& graph = *small;
+        graph.getReverseAdjacency();
+        graph.addNode(50, glm::vec3(30.0f, 0.0f, 0.0f));
+        check(graph.getAdjacency().getNodeCount() == 51, "adjacency covers an added node");
+        check(graph.getReverseAdjacency().getNodeCount() == 51, "reverse adjacency covers an added node");
+        check(graph.getNeighbors(50).empty() && graph.getNeighbors(1).size() == 2, "added node has no roads yet");
+    }
+
+    // Nodes added after the adjacency was built are searched like any other
+    void testDijkstraFromAddedNode() {
+        std::unique_ptr<RoadGraph> small = makeSmallGraph();
+        RoadGraph& graph = *small;
+        graph.addNode(50, glm::vec3(30.0f, 0.0f, 0.0f));
+        Dijkstra dijkstra(graph);
+        Route route;
+        check(!dijkstra.findRoute(50, 0, route), "Dijkstra finds no route from an unconnected added node");
+        check(!dijkstra.findRoute(0, 50, route), "Dijkstra finds no route to an unconnected added node");
+
+        graph.addRoad(2, 2, 50, 10.0f, 30.0f, 1, true);
+        check(dijkstra.findRoute(50, 0, route) && route.roads.size() == 3, "Dijkstra routes from an added node once a road reaches it");
+    }
+
+    void testBidirectionalAStarFromAddedNode() {
+        std::unique_ptr<RoadGraph> small = makeSmallGraph();
+        RoadGraph& graph = *small;
+        graph.getReverseAdjacency();
+        graph.addNode(50, glm::vec3(30.0f, 0.0f, 0.0f));
+        BidirectionalAStar search(graph);
+        Route route;
+        check(!search.findRoute(50, 0, route), "A* finds no route from an unconnected added node");
+        check(!search.findRoute(0, 50, route), "A* finds no route to an unconnected added node");
+
+        graph.addRoad(2, 2, 50, 10.0f, 30.0f, 1, true);
+        check(search.findRoute(50, 0, route) && route.roads.size() == 3, "A* routes from an added node once a road reaches it");
+    }
+
+    // Renumbered nodes keep their source ids through an archive
+    void testArchiveKeepsExternalIds(const std::string& directory) {
+        std::vector<Node> nodes = {Node(glm::vec3(0.0f)), Node(glm::vec3(10.0f, 0.0f, 0.0f)), Node(glm::vec3(20.0f, 0.0f, 0.0f))};
+        std::vector<Road> roads = {Road(0, 1, 10.0f, 30.0f, 1, 0, 0, true), Road(1, 2, 10.0f, 30.0f, 1, 0, 0, true)};
+        RoadGraph graph(std::move(nodes), std::move(roads), {}, {100, 2050, 900000});
+
+        std::string archiveFile = directory + "/ids.rgarch";
+        check(GraphArchive::write(graph, archiveFile), "archive with source ids is written");
+        std::unique_ptr<RoadGraph> loaded = GraphArchive::read(archiveFile);
+        check(loaded && loaded->getNodeId(2050) == 1 && loaded->getExternalId(2) == 900000, "archive keeps source ids");
+    }
+
+    // Archives only hold roads the reader accepts
+    void testArchiveRejectsDanglingRoads(const std::string& directory) {
+        std::vector<Node> nodes = {Node(glm::vec3(0.0f)), Node(glm::vec3(10.0f, 0.0f, 0.0f))};
+        std::vector<Road> roads = {Road(0, 1, 10.0f, 30.0f, 1), Road(1, 7, 10.0f, 30.0f, 1)};
+        RoadGraph graph(std::move(nodes), std::move(roads));
+        check(!GraphArchive::write(graph, directory + "/dangling.rgarch"), "road past the last node is not archived");
+
+        graph.removeRoad(1);
+        check(GraphArchive::write(graph, directory + "/dangling.rgarch"), "removed road is archived");
+        std::unique_ptr<RoadGraph> loaded = GraphArchive::read(directory + "/dangling.rgarch");
+        check(loaded && loaded->roadExists(0) && !loaded->roadExists(1), "removed road stays removed");
+    }
+
+    // Reordered nodes keep the permutation that finds them by source id
+    void testArchiveKeepsReorderedIds(const std::string& dataDirectory, const std::string& directory) {
+        RoadGraph graph(dataDirectory + "/nodes.txt", dataDirectory + "/edges.txt");
+        graph.reorderAlongHilbertCurve();
+
+        std::string archiveFile = directory + "/reordered.rgarch";
+        check(GraphArchive::write(graph, archiveFile), "reordered archive is written");
+        std::unique_ptr<RoadGraph> loaded = GraphArchive::read(archiveFile);
+        bool same = loaded && !loaded->getExternalIdOrder().empty();
+        for (size_t id = 0; same && id < graph.getNodes().size(); ++id) {
+            int externalId = graph.getExternalId(static_cast<int>(id));
+            same = loaded->getNodeId(externalId) == graph.getNodeId(externalId);
+        }
+        check(same, "reordered archive finds every node by its source id");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string dataDirectory = argc > 1 ? argv[1] : "data";
+    std::string scratchDirectory = (std::filesystem::temp_directory_path() / "road-graph-tests").string();
+    std::filesystem::create_directories(scratchDirectory);
+
+    testBundledStreetsAreStoredOnce(dataDirectory);
+    testShapesAreMatchedBackwards(scratchDirectory);
+    testEditsPatchIndexes(dataDirectory);
+    testAddedNodeExtendsAdjacency();
+    testDijkstraFromAddedNode();
+    testBidirectionalAStarFromAddedNode();
+    testArchiveKeepsExternalIds(scratchDirectory);
+    testArchiveKeepsReorderedIds(dataDirectory, scratchDirectory);
+    testArchiveRejectsDanglingRoads(scratchDirectory);
+
+    std::filesystem::remove_all(scratchDirectory);
+    if (failures > 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
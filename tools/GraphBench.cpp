@@ -0,0 +1,755 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "RoadGraph.h"
+#include "BidirectionalAStar.h"
+#include "ContractionHierarchy.h"
+#include "ContractionHierarchyQuery.h"
+#include "CustomizableContractionHierarchy.h"
+#include "Dijkstra.h"
+#include "GraphArchive.h"
+#include "GraphFile.h"
+#include "Landmarks.h"
+#include "Parallel.h"
+
+void printUsage() {
+    std::cout << "Usage: graph-bench <nodesFile> <edgesFile> [runs]" << std::endl;
+    std::cout << "       graph-bench <graphFile> [runs]" << std::endl;
+    std::cout << "Measures the compression ratio and decode throughput of graph archives, and the" << std::endl;
+    std::cout << "cache misses of graph traversals before and after Hilbert curve reordering, and" << std::endl;
+    std::cout << "the query times of the node grid, road tree and route searches" << std::endl;
+}
+
+namespace {
+    size_t getFileSize(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        return file.is_open() ? static_cast<size_t>(file.tellg()) : 0;
+    }
+
+    size_t getGraphBytes(const RoadGraph& graph) {
+        return graph.getNodes().size() * sizeof(Node) + graph.getRoads().size() * sizeof(Road) +
+               graph.getShapePoints().size() * sizeof(glm::vec2);
+    }
+
+    // Largest position error, or -1 if the graphs differ in anything else. Empty
+    // shape ranges carry no start, so only their counts are compared.
+    float compareGraphs(const RoadGraph& expected, const RoadGraph& actual) {
+        const Column<Node>& expectedNodes = expected.getNodes();
+        const Column<Road>& expectedRoads = expected.getRoads();
+        const Column<glm::vec2>& expectedShapes = expected.getShapePoints();
+        if (expectedNodes.size() != actual.getNodes().size() || expectedRoads.size() != actual.getRoads().size() ||
+            expectedShapes.size() != actual.getShapePoints().size()) {
+            return -1.0f;
+        }
+
+        float maxError = 0.0f;
+        for (size_t id = 0; id < expectedNodes.size(); ++id) {
+            if (expected.nodeExists(static_cast<int>(id)) != actual.nodeExists(static_cast<int>(id))) {
+                return -1.0f;
+            }
+            if (expected.nodeExists(static_cast<int>(id))) {
+                glm::vec3 error = glm::abs(expectedNodes[id].position - actual.getNodes()[id].position);
+                maxError = std::max(maxError, std::max(error.x, std::max(error.y, error.z)));
+            }
+        }
+        for (size_t id = 0; id < expectedRoads.size(); ++id) {
+            const Road& a = expectedRoads[id];
+            const Road& b = actual.getRoads()[id];
+            if (a.from != b.from || a.to != b.to || std::abs(a.meters - b.meters) > 0.001f + a.meters * 1e-6f || a.lanes != b.lanes ||
+                std::round(a.maxSpeed) != b.maxSpeed || a.shapeCount != b.shapeCount || (a.shapeCount > 0 && a.shapeBegin != b.shapeBegin) ||
+                a.twoWay != b.twoWay) {
+                return -1.0f;
+            }
+        }
+        for (size_t i = 0; i < expectedShapes.size(); ++i) {
+            glm::vec2 error = glm::abs(expectedShapes[i] - actual.getShapePoints()[i]);
+            maxError = std::max(maxError, std::max(error.x, error.y));
+        }
+        return maxError;
+    }
+
+    bool benchmarkArchive(const RoadGraph& graph, const std::string& baseName, size_t sourceBytes, int runs) {
+        std::string binaryFile = baseName + ".bench.bin";
+        std::string archiveFile = baseName + ".bench.rgraph";
+
+        auto start = std::chrono::steady_clock::now();
+        if (!GraphFile::write(graph, binaryFile) || !GraphArchive::write(graph, archiveFile)) {
+            std::remove(binaryFile.c_str());
+            std::remove(archiveFile.c_str());
+            return false;
+        }
+        auto encoded = std::chrono::steady_clock::now();
+
+        size_t binaryBytes = getFileSize(binaryFile);
+        size_t archiveBytes = getFileSize(archiveFile);
+        size_t graphBytes = getGraphBytes(graph);
+
+        // Best of several runs, so the archive is in the page cache for all but the first
+        double bestSeconds = 0.0;
+        std::unique_ptr<RoadGraph> decoded;
+        for (int run = 0; run < runs; ++run) {
+            auto runStart = std::chrono::steady_clock::now();
+            decoded = GraphArchive::read(archiveFile);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+            if (!decoded) {
+                break;
+            }
+            bestSeconds = run == 0 ? seconds : std::min(bestSeconds, seconds);
+        }
+
+        std::remove(binaryFile.c_str());
+        std::remove(archiveFile.c_str());
+        if (!decoded) {
+            return false;
+        }
+
+        float maxError = compareGraphs(graph, *decoded);
+        size_t roadCount = std::max<size_t>(graph.getRoads().size(), 1);
+        double megabyte = 1024.0 * 1024.0;
+
+        if (sourceBytes > 0) {
+            std::cout << "Text:    " << sourceBytes / megabyte << " MB" << std::endl;
+        }
+        std::cout << "Binary:  " << binaryBytes / megabyte << " MB, " << static_cast<double>(binaryBytes) / roadCount << " bytes per road" << std::endl;
+        std::cout << "Archive: " << archiveBytes / megabyte << " MB, " << static_cast<double>(archiveBytes) / roadCount << " bytes per road" << std::endl;
+        std::cout << "Compression ratio: " << static_cast<double>(binaryBytes) / archiveBytes << "x against binary";
+        if (sourceBytes > 0) {
+            std::cout << ", " << static_cast<double>(sourceBytes) / archiveBytes << "x against text";
+        }
+        std::cout << std::endl;
+        std::cout << "Encoded both files in " << std::chrono::duration<double, std::milli>(encoded - start).count() << " ms" << std::endl;
+        std::cout << "Decoded in " << bestSeconds * 1000.0 << " ms (best of " << runs << ", " << getWorkerCount() << " workers): "
+                  << graphBytes / bestSeconds / 1e9 << " GB/s of graph, " << archiveBytes / bestSeconds / 1e9 << " GB/s of archive" << std::endl;
+
+        if (maxError < 0.0f) {
+            std::cerr << "Decoded graph does not match the source" << std::endl;
+            return false;
+        }
+        std::cout << "Verified, largest position error " << maxError << " m" << std::endl;
+        return true;
+    }
+
+    // Hardware cache misses of this process, where perf events are available
+    class CacheMissCounter {
+    public:
+        CacheMissCounter() {
+#ifdef __linux__
+            perf_event_attr attributes = {};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+        }
+
+        ~CacheMissCounter() {
+#ifdef __linux__
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+#endif
+        }
+
+        bool isAvailable() const { return descriptor >= 0; }
+
+        void start() {
+#ifdef __linux__
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        uint64_t stop() {
+            uint64_t count = 0;
+#ifdef __linux__
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+                if (::read(descriptor, &count, sizeof(count)) != sizeof(count)) {
+                    count = 0;
+                }
+            }
+#endif
+            return count;
+        }
+
+    private:
+        int descriptor = -1;
+    };
+
+    // Breadth-first search from the source over the whole component, reading
+    // the position of every road end, as routing and snapping would
+    double traverse(const RoadGraph& graph, int source) {
+        std::vector<uint8_t> visited(graph.getNodes().size(), 0);
+        std::vector<int> queue;
+        queue.reserve(graph.getNodes().size());
+        queue.push_back(source);
+        visited[source] = 1;
+
+        double meters = 0.0;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int node = queue[head];
+            const glm::vec3& position = graph.getNodePositionUnchecked(node);
+            for (Adjacency::Edge edge : graph.getNeighbors(node)) {
+                meters += glm::distance(position, graph.getNodePositionUnchecked(edge.target));
+                if (!visited[edge.target]) {
+                    visited[edge.target] = 1;
+                    queue.push_back(edge.target);
+                }
+            }
+        }
+        return meters;
+    }
+
+    void benchmarkLocality(const RoadGraph& graph, int runs) {
+        std::vector<Node> nodeValues(graph.getNodes().begin(), graph.getNodes().end());
+        std::vector<Road> roadValues(graph.getRoads().begin(), graph.getRoads().end());
+        std::vector<glm::vec2> shapeValues(graph.getShapePoints().begin(), graph.getShapePoints().end());
+        RoadGraph reordered(std::move(nodeValues), std::move(roadValues), std::move(shapeValues));
+
+        auto start = std::chrono::steady_clock::now();
+        reordered.reorderAlongHilbertCurve();
+        double reorderMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Reordered along a Hilbert curve in " << reorderMilliseconds << " ms" << std::endl;
+
+        // Start from the first node with roads, under its id in each graph
+        int source = -1;
+        for (size_t id = 0; id < graph.getNodes().size() && source < 0; ++id) {
+            if (graph.nodeExists(static_cast<int>(id)) && !graph.getNeighbors(static_cast<int>(id)).empty()) {
+                source = static_cast<int>(id);
+            }
+        }
+        if (source < 0) {
+            return;
+        }
+        int reorderedSource = reordered.getNodeId(source);
+
+        CacheMissCounter counter;
+        if (!counter.isAvailable()) {
+            std::cout << "Cache miss counters are unavailable (check perf_event_paranoid), reporting times only" << std::endl;
+        }
+
+        struct Workload {
+            const char* name;
+            std::function<double(const RoadGraph&, int)> run;
+        };
+        std::vector<Workload> workloads = {
+            {"Traversal", [](const RoadGraph& target, int from) { return traverse(target, from); }},
+            {"Segments ", [](const RoadGraph& target, int) {
+                size_t segmentPoints = 0;
+                target.splitIntoBatches([&segmentPoints](GraphBatch&& batch) { segmentPoints += batch.roadSegments.size(); });
+                return static_cast<double>(segmentPoints);
+            }},
+        };
+
+        for (const Workload& workload : workloads) {
+            const RoadGraph* graphs[2] = {&graph, &reordered};
+            int sources[2] = {source, reorderedSource};
+            double bestSeconds[2] = {0.0, 0.0};
+            uint64_t fewestMisses[2] = {0, 0};
+            double results[2] = {0.0, 0.0};
+
+            for (int i = 0; i < 2; ++i) {
+                graphs[i]->getAdjacency();
+                for (int run = 0; run < runs; ++run) {
+                    counter.start();
+                    auto runStart = std::chrono::steady_clock::now();
+                    results[i] = workload.run(*graphs[i], sources[i]);
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+                    uint64_t misses = counter.stop();
+                    bestSeconds[i] = run == 0 ? seconds : std::min(bestSeconds[i], seconds);
+                    fewestMisses[i] = run == 0 ? misses : std::min(fewestMisses[i], misses);
+                }
+            }
+
+            std::cout << workload.name << ": " << bestSeconds[0] * 1000.0 << " ms -> " << bestSeconds[1] * 1000.0 << " ms";
+            if (counter.isAvailable() && fewestMisses[1] > 0) {
+                std::cout << ", cache misses " << fewestMisses[0] << " -> " << fewestMisses[1] << " ("
+                          << static_cast<double>(fewestMisses[0]) / fewestMisses[1] << "x fewer)";
+            }
+            if (std::abs(results[0] - results[1]) > 1e-6 * std::abs(results[0]) + 1.0) {
+                std::cout << " [results differ: " << results[0] << " vs " << results[1] << "]";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    bool benchmarkNodeGrid(const RoadGraph& graph) {
+        auto start = std::chrono::steady_clock::now();
+        const NodeGrid& grid = graph.getNodeGrid();
+        double buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Node grid: " << grid.getCellCount() << " cells of " << grid.getCellSize() << " m, built in "
+                  << buildMilliseconds << " ms, " << grid.memoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+
+        // Query points spread over the bounding box, with a margin outside it
+        const size_t queryCount = 100000;
+        glm::vec2 minCoords(graph.getMinCoords());
+        glm::vec2 maxCoords(graph.getMaxCoords());
+        glm::vec2 margin = (maxCoords - minCoords) * 0.05f;
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> xs(minCoords.x - margin.x, maxCoords.x + margin.x);
+        std::uniform_real_distribution<float> ys(minCoords.y - margin.y, maxCoords.y + margin.y);
+        std::vector<glm::vec2> points(queryCount);
+        for (glm::vec2& point : points) {
+            point = glm::vec2(xs(random), ys(random));
+        }
+
+        auto nanosecondsPerQuery = [queryCount](auto from, auto to) {
+            return std::chrono::duration<double, std::nano>(to - from).count() / queryCount;
+        };
+
+        size_t checksum = 0;
+        std::vector<int> found;
+        auto nearestStart = std::chrono::steady_clock::now();
+        for (const glm::vec2& point : points) {
+            checksum += static_cast<size_t>(grid.findNearest(point));
+        }
+        auto nearestEnd = std::chrono::steady_clock::now();
+        for (const glm::vec2& point : points) {
+            grid.findNearest(point, 8, found);
+            checksum += found.size();
+        }
+        auto nearestEightEnd = std::chrono::steady_clock::now();
+        for (const glm::vec2& point : points) {
+            grid.findInRadius(point, 500.0f, found);
+            checksum += found.size();
+        }
+        auto radiusEnd = std::chrono::steady_clock::now();
+        for (const glm::vec2& point : points) {
+            grid.findInBox(point - 250.0f, point + 250.0f, found);
+            checksum += found.size();
+        }
+        auto boxEnd = std::chrono::steady_clock::now();
+        std::vector<int> nearest;
+        grid.findNearest(points, nearest);
+        auto batchEnd = std::chrono::steady_clock::now();
+
+        std::cout << "Nearest " << nanosecondsPerQuery(nearestStart, nearestEnd) << " ns, 8 nearest "
+                  << nanosecondsPerQuery(nearestEnd, nearestEightEnd) << " ns, within 500 m "
+                  << nanosecondsPerQuery(nearestEightEnd, radiusEnd) << " ns, 500 m box "
+                  << nanosecondsPerQuery(radiusEnd, boxEnd) << " ns, batched nearest "
+                  << nanosecondsPerQuery(boxEnd, batchEnd) << " ns per query (checksum " << checksum << ")" << std::endl;
+
+        // Compare a sample against a linear scan
+        const Column<Node>& nodes = graph.getNodes();
+        for (size_t i = 0; i < queryCount; i += queryCount / 200) {
+            float bestDistance = std::numeric_limits<float>::max();
+            for (size_t id = 0; id < nodes.size(); ++id) {
+                if (graph.nodeExists(static_cast<int>(id))) {
+                    bestDistance = std::min(bestDistance, glm::distance(glm::vec2(nodes[id].position), points[i]));
+                }
+            }
+            if (nearest[i] < 0 || glm::distance(glm::vec2(nodes[nearest[i]].position), points[i]) != bestDistance) {
+                std::cerr << "Node grid disagrees with a linear scan" << std::endl;
+                return false;
+            }
+        }
+        std::cout << "Verified nearest queries against a linear scan" << std::endl;
+        return true;
+    }
+
+    bool benchmarkRoadTree(const RoadGraph& graph) {
+        auto start = std::chrono::steady_clock::now();
+        const RoadTree& tree = graph.getRoadTree();
+        double buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Road tree: " << tree.getSegmentCount() << " segments, height " << tree.getHeight() << ", built in "
+                  << buildMilliseconds << " ms, " << tree.memoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+        if (tree.getSegmentCount() == 0) {
+            return true;
+        }
+
+        const size_t queryCount = 200000;
+        glm::vec2 minCoords(graph.getMinCoords());
+        glm::vec2 maxCoords(graph.getMaxCoords());
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> xs(minCoords.x, maxCoords.x);
+        std::uniform_real_distribution<float> ys(minCoords.y, maxCoords.y);
+        std::vector<glm::vec2> points(queryCount);
+        for (glm::vec2& point : points) {
+            point = glm::vec2(xs(random), ys(random));
+        }
+
+        RoadTree::Snap snap;
+        double checksum = 0.0;
+        auto singleStart = std::chrono::steady_clock::now();
+        for (const glm::vec2& point : points) {
+            tree.snap(point, snap);
+            checksum += snap.offset;
+        }
+        auto singleEnd = std::chrono::steady_clock::now();
+        std::vector<RoadTree::Snap> snaps;
+        tree.snap(points, snaps);
+        auto batchEnd = std::chrono::steady_clock::now();
+
+        auto queriesPerSecond = [queryCount](auto from, auto to) {
+            return queryCount / std::chrono::duration<double>(to - from).count() / 1e6;
+        };
+        std::cout << "Snapping: " << queriesPerSecond(singleStart, singleEnd) << " M queries/s on one thread, "
+                  << queriesPerSecond(singleEnd, batchEnd) << " M queries/s on " << getWorkerCount() << " workers (checksum "
+                  << checksum << ")" << std::endl;
+
+        // Compare a sample against the distance to every road
+        std::vector<glm::vec3> polyline;
+        for (size_t i = 0; i < queryCount; i += queryCount / 20) {
+            float bestDistance = std::numeric_limits<float>::max();
+            for (size_t id = 0; id < graph.getRoads().size(); ++id) {
+                const Road& road = graph.getRoads()[id];
+                if (!graph.roadExists(static_cast<int>(id)) || !graph.nodeExists(road.from) || !graph.nodeExists(road.to)) {
+                    continue;
+                }
+                polyline.clear();
+                graph.appendRoadSegments(road, polyline);
+                for (size_t j = 0; j + 1 < polyline.size(); j += 2) {
+                    glm::vec2 from(polyline[j]);
+                    glm::vec2 direction = glm::vec2(polyline[j + 1]) - from;
+                    float lengthSquared = glm::dot(direction, direction);
+                    float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(points[i] - from, direction) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+                    bestDistance = std::min(bestDistance, glm::distance(points[i], from + direction * t));
+                }
+            }
+            if (snaps[i].road < 0 || std::abs(snaps[i].distance - bestDistance) > 1e-3f * std::max(1.0f, bestDistance)) {
+                std::cerr << "Road tree disagrees with a linear scan" << std::endl;
+                return false;
+            }
+        }
+        std::cout << "Verified snapping against a linear scan" << std::endl;
+        return true;
+    }
+}
+
+namespace {
+    // Random pairs of existing nodes, the same for every run
+    std::vector<std::pair<int, int>> getRoutePairs(const RoadGraph& graph, size_t count) {
+        std::vector<int> ids;
+        for (size_t id = 0; id < graph.getNodes().size(); ++id) {
+            if (graph.nodeExists(static_cast<int>(id))) {
+                ids.push_back(static_cast<int>(id));
+            }
+        }
+
+        std::mt19937 random(11);
+        std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+        std::vector<std::pair<int, int>> pairs(count);
+        for (auto& pair : pairs) {
+            pair = std::make_pair(ids[pick(random)], ids[pick(random)]);
+        }
+        return pairs;
+    }
+
+    // The roads must join the nodes in order and add up to the travel time,
+    // at the speed limits unless other travel times per road are given
+    bool isValidRoute(const RoadGraph& graph, const Route& route, int from, int to, const std::vector<uint32_t>* roadTravelTimes = nullptr) {
+        if (!route.found()) {
+            return route.nodes.empty() && route.roads.empty();
+        }
+        if (route.nodes.empty() || route.nodes.front() != from || route.nodes.back() != to || route.roads.size() + 1 != route.nodes.size()) {
+            return false;
+        }
+
+        const std::vector<uint32_t>& travelTimes = roadTravelTimes ? *roadTravelTimes : graph.getRoadColumns().getTravelTimes();
+        uint64_t travelTime = 0;
+        for (size_t i = 0; i < route.roads.size(); ++i) {
+            const Road& road = graph.getRoads()[route.roads[i]];
+            int a = route.nodes[i];
+            int b = route.nodes[i + 1];
+            if (!((road.from == a && road.to == b) || (road.twoWay && road.from == b && road.to == a))) {
+                return false;
+            }
+            travelTime += travelTimes[route.roads[i]];
+        }
+        return travelTime == route.travelTime;
+    }
+
+    // Times a route query over all pairs and checks its routes against the
+    // Dijkstra travel times. Pairs at least the graph's radius apart stand in
+    // for cross-city queries.
+    template<typename FindRoute>
+    bool benchmarkRoutes(const RoadGraph& graph, const std::string& name, const std::vector<std::pair<int, int>>& pairs,
+                         const std::vector<uint32_t>& travelTimes, const std::vector<size_t>& dijkstraSettled, FindRoute findRoute) {
+        Route route;
+        findRoute(pairs.front().first, pairs.front().second, route);
+
+        size_t settled = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& pair : pairs) {
+            findRoute(pair.first, pair.second, route);
+            settled += route.settledNodes;
+        }
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / pairs.size();
+
+        size_t farCount = 0;
+        size_t farSettled = 0;
+        size_t farDijkstraSettled = 0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            findRoute(pairs[i].first, pairs[i].second, route);
+            if (route.travelTime != travelTimes[i] || !isValidRoute(graph, route, pairs[i].first, pairs[i].second)) {
+                std::cerr << name << " disagrees with Dijkstra" << std::endl;
+                return false;
+            }
+            if (glm::distance(graph.getNodePosition(pairs[i].first), graph.getNodePosition(pairs[i].second)) >= graph.getRadius()) {
+                ++farCount;
+                farSettled += route.settledNodes;
+                farDijkstraSettled += dijkstraSettled[i];
+            }
+        }
+
+        std::cout << name << ": " << milliseconds << " ms per route, " << settled / pairs.size() << " nodes settled";
+        if (farCount > 0) {
+            std::cout << ", " << farSettled / farCount << " on " << farCount << " cross-city routes where Dijkstra settles "
+                      << farDijkstraSettled / farCount;
+        }
+        std::cout << std::endl << "Verified " << name << " routes against Dijkstra" << std::endl;
+        return true;
+    }
+
+    // Builds a customizable hierarchy, then customizes it for an incident that
+    // closes and slows roads while queries keep using the previous metric.
+    // Routes on the new metric must match Dijkstra with the same travel times.
+    bool benchmarkCustomization(const RoadGraph& graph, const std::vector<std::pair<int, int>>& pairs,
+                                const std::vector<uint32_t>& travelTimes, const std::vector<size_t>& settledCounts) {
+        CustomizableContractionHierarchy customizable;
+        auto buildStart = std::chrono::steady_clock::now();
+        customizable.build(graph);
+        auto buildEnd = std::chrono::steady_clock::now();
+        customizable.setMetric(customizable.customize(graph.getRoadColumns().getTravelTimes()));
+        auto customizeEnd = std::chrono::steady_clock::now();
+        std::cout << "Customizable hierarchy: " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count() << " ms to build, "
+                  << customizable.getEdgeCount() << " edges in " << customizable.getLevelCount() << " levels, "
+                  << customizable.memoryUsage() / (1024.0 * 1024.0) << " MB; customization in "
+                  << std::chrono::duration<double, std::milli>(customizeEnd - buildEnd).count() << " ms on " << getWorkerCount()
+                  << " workers" << std::endl;
+
+        ContractionHierarchyQuery query(customizable);
+        auto findRoute = [&query](int from, int to, Route& result) { return query.findRoute(from, to, result); };
+        if (!benchmarkRoutes(graph, "Customizable hierarchy", pairs, travelTimes, settledCounts, findRoute)) {
+            return false;
+        }
+
+        // Every 50th road closed, every 7th a third slower
+        std::vector<uint32_t> incident = graph.getRoadColumns().getTravelTimes();
+        for (size_t road = 0; road < incident.size(); ++road) {
+            if (road % 50 == 0) {
+                incident[road] = RoadColumns::unreachable;
+            } else if (road % 7 == 0 && incident[road] != RoadColumns::unreachable) {
+                incident[road] += incident[road] / 2;
+            }
+        }
+
+        std::shared_ptr<const ContractionHierarchy> next;
+        double customizeMilliseconds = 0.0;
+        std::thread customizer([&]() {
+            auto start = std::chrono::steady_clock::now();
+            next = customizable.customize(incident);
+            customizeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        });
+        Route route;
+        size_t oldRoutes = 0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            query.findRoute(pairs[i].first, pairs[i].second, route);
+            oldRoutes += route.travelTime == travelTimes[i] ? 1 : 0;
+        }
+        customizer.join();
+        customizable.setMetric(next);
+        if (oldRoutes != pairs.size()) {
+            std::cerr << "Queries during customization did not use the previous metric" << std::endl;
+            return false;
+        }
+
+        Dijkstra dijkstra(graph);
+        dijkstra.setTravelTimes(&incident);
+        Route expected;
+        size_t changed = 0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            dijkstra.findRoute(pairs[i].first, pairs[i].second, expected);
+            query.findRoute(pairs[i].first, pairs[i].second, route);
+            if (route.travelTime != expected.travelTime || !isValidRoute(graph, route, pairs[i].first, pairs[i].second, &incident)) {
+                std::cerr << "Customized metric disagrees with Dijkstra" << std::endl;
+                return false;
+            }
+            changed += route.travelTime != travelTimes[i] ? 1 : 0;
+        }
+        std::cout << "Incident customization: " << customizeMilliseconds << " ms beside " << oldRoutes << " queries on the previous metric, "
+                  << changed << "/" << pairs.size() << " routes changed" << std::endl
+                  << "Verified customized routes against Dijkstra" << std::endl;
+        return true;
+    }
+
+    bool benchmarkRouting(const RoadGraph& graph, const std::string& baseName) {
+        const size_t queryCount = 200;
+        std::vector<std::pair<int, int>> pairs = getRoutePairs(graph, queryCount);
+        graph.getAdjacency();
+        graph.getReverseAdjacency();
+        graph.getRoadColumns();
+
+        Dijkstra dijkstra(graph);
+        Route route;
+        // The first query sizes the search space, which later ones reuse
+        dijkstra.findRoute(pairs.front().first, pairs.front().second, route);
+
+        size_t found = 0;
+        size_t settled = 0;
+        std::vector<uint32_t> travelTimes(queryCount);
+        std::vector<size_t> settledCounts(queryCount);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queryCount; ++i) {
+            found += dijkstra.findRoute(pairs[i].first, pairs[i].second, route) ? 1 : 0;
+            settled += route.settledNodes;
+            travelTimes[i] = route.travelTime;
+            settledCounts[i] = route.settledNodes;
+        }
+        auto pointEnd = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queryCount; i += 10) {
+            dijkstra.searchFrom(pairs[i].first);
+        }
+        auto allEnd = std::chrono::steady_clock::now();
+
+        std::cout << "Dijkstra: " << std::chrono::duration<double, std::milli>(pointEnd - start).count() / queryCount
+                  << " ms per route, " << settled / queryCount << " nodes settled, " << found << "/" << queryCount
+                  << " found, one-to-all " << std::chrono::duration<double, std::milli>(allEnd - pointEnd).count() / (queryCount / 10)
+                  << " ms" << std::endl;
+
+        // Routes must be real paths, and one-to-all searches in either direction must agree with them
+        for (size_t i = 0; i < queryCount; i += 10) {
+            dijkstra.findRoute(pairs[i].first, pairs[i].second, route);
+            if (!isValidRoute(graph, route, pairs[i].first, pairs[i].second)) {
+                std::cerr << "Dijkstra returned a broken route" << std::endl;
+                return false;
+            }
+            dijkstra.searchFrom(pairs[i].first);
+            uint32_t forward = dijkstra.getTravelTime(pairs[i].second);
+            dijkstra.searchFrom(pairs[i].second, Adjacency::Incoming);
+            dijkstra.getRoute(pairs[i].first, route);
+            if (forward != travelTimes[i] || dijkstra.getTravelTime(pairs[i].first) != travelTimes[i] ||
+                !isValidRoute(graph, route, pairs[i].first, pairs[i].second)) {
+                std::cerr << "Dijkstra searches disagree" << std::endl;
+                return false;
+            }
+        }
+        std::cout << "Verified routes and one-to-all searches in both directions" << std::endl;
+
+        BidirectionalAStar aStar(graph);
+        std::cout << "A* bound: " << aStar.getMillisecondsPerMeter() << " ms per meter (" << 3600.0 / aStar.getMillisecondsPerMeter()
+                  << " km/h)" << std::endl;
+        auto findAStarRoute = [&aStar](int from, int to, Route& result) { return aStar.findRoute(from, to, result); };
+        if (!benchmarkRoutes(graph, "Bidirectional A*", pairs, travelTimes, settledCounts, findAStarRoute)) {
+            return false;
+        }
+
+        const size_t landmarkCount = 16;
+        const Landmarks::Selection selections[] = {Landmarks::Farthest, Landmarks::Avoid};
+        const char* selectionNames[] = {"farthest", "avoid"};
+        Landmarks landmarks;
+        for (size_t i = 0; i < 2; ++i) {
+            auto buildStart = std::chrono::steady_clock::now();
+            landmarks.build(graph, landmarkCount, selections[i]);
+            double buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+            std::cout << "Landmarks: " << landmarks.getLandmarkCount() << " by " << selectionNames[i] << " selection in "
+                      << buildMilliseconds << " ms on " << getWorkerCount() << " workers, "
+                      << landmarks.memoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+
+            aStar.setLandmarks(&landmarks);
+            if (!benchmarkRoutes(graph, std::string("ALT (") + selectionNames[i] + ")", pairs, travelTimes, settledCounts, findAStarRoute)) {
+                return false;
+            }
+        }
+
+        // Tables stored in a graph file must come back unchanged and bound the same way
+        std::string landmarkFile = baseName + ".bench.landmarks.rgraph";
+        Landmarks stored;
+        bool roundTrip = GraphFile::write(graph, landmarkFile, landmarks.getSections()) && stored.read(landmarkFile, graph) &&
+                         stored.getLandmarkCount() == landmarks.getLandmarkCount() &&
+                         std::equal(landmarks.getNodes().begin(), landmarks.getNodes().end(), stored.getNodes().begin());
+        for (size_t i = 0; i < pairs.size() && roundTrip; ++i) {
+            roundTrip = stored.getLowerBound(pairs[i].first, pairs[i].second) == landmarks.getLowerBound(pairs[i].first, pairs[i].second);
+        }
+        std::cout << "Landmark file: " << getFileSize(landmarkFile) / (1024.0 * 1024.0) << " MB" << std::endl;
+        std::remove(landmarkFile.c_str());
+        aStar.setLandmarks(nullptr);
+        if (!roundTrip) {
+            std::cerr << "Landmarks did not survive a graph file round trip" << std::endl;
+            return false;
+        }
+        std::cout << "Verified landmarks read back from a graph file" << std::endl;
+
+        ContractionHierarchy hierarchy;
+        auto contractStart = std::chrono::steady_clock::now();
+        hierarchy.build(graph);
+        double contractMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - contractStart).count();
+        std::cout << "Contraction hierarchy: " << contractMilliseconds << " ms, " << hierarchy.getShortcutCount() << " shortcuts, "
+                  << hierarchy.getEdgeCount() << " edges, " << hierarchy.memoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+        ContractionHierarchyQuery hierarchyQuery(hierarchy);
+        auto findHierarchyRoute = [&hierarchyQuery](int from, int to, Route& result) { return hierarchyQuery.findRoute(from, to, result); };
+        if (!benchmarkRoutes(graph, "Contraction hierarchy", pairs, travelTimes, settledCounts, findHierarchyRoute)) {
+            return false;
+        }
+        return benchmarkCustomization(graph, pairs, travelTimes, settledCounts);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 4) {
+        printUsage();
+        return 1;
+    }
+
+    // A trailing number is the run count, anything before it names the graph
+    int runs = 5;
+    int fileCount = argc - 1;
+    char* end = nullptr;
+    long parsedRuns = std::strtol(argv[argc - 1], &end, 10);
+    if (argc > 2 && *end == '\0') {
+        runs = static_cast<int>(parsedRuns);
+        --fileCount;
+    }
+    if (fileCount < 1 || fileCount > 2 || runs < 1) {
+        printUsage();
+        return 1;
+    }
+
+    std::unique_ptr<RoadGraph> graph;
+    size_t sourceBytes = 0;
+    if (fileCount == 2) {
+        graph = std::make_unique<RoadGraph>(argv[1], argv[2]);
+        sourceBytes = getFileSize(argv[1]) + getFileSize(argv[2]);
+    } else {
+        graph = std::make_unique<RoadGraph>(std::string(argv[1]));
+    }
+    if (graph->getNodes().empty()) {
+        std::cerr << "No nodes loaded, nothing to measure" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Nodes: " << graph->getNodes().size() << ", roads: " << graph->getRoads().size()
+              << ", shape points: " << graph->getShapePoints().size() << std::endl;
+    if (!benchmarkArchive(*graph, argv[1], sourceBytes, runs)) {
+        return 1;
+    }
+    benchmarkLocality(*graph, runs);
+    if (!benchmarkNodeGrid(*graph) || !benchmarkRoadTree(*graph) || !benchmarkRouting(*graph, argv[1])) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "RoadGraph.h"
+#include "GraphArchive.h"
+#include "GraphFile.h"
+#include "GraphTiles.h"
+#include "Landmarks.h"
+
+void printUsage() {
+    std::cout << "Usage: graph-convert <nodesFile> <edgesFile> <graphFile> [--hilbert] [--tile-size <meters> | --compressed | --landmarks <count>]" << std::endl;
+    std::cout << "Converts the text graph produced by the importer into a binary graph file" << std::endl;
+    std::cout << "With --hilbert, nodes and roads are renumbered along a Hilbert curve for locality" << std::endl;
+    std::cout << "With --tile-size, nodes are renumbered into square tiles that are paged in on demand" << std::endl;
+    std::cout << "With --compressed, a delta and varint coded archive is written instead" << std::endl;
+    std::cout << "With --landmarks, travel time tables for that many landmarks are stored for ALT routing" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    float tileSize = 0.0f;
+    bool compressed = false;
+    bool hilbert = false;
+    long landmarkCount = 0;
+    bool validArguments = argc >= 4;
+    for (int i = 4; i < argc && validArguments; ++i) {
+        std::string option = argv[i];
+        if (option == "--tile-size" && i + 1 < argc) {
+            tileSize = std::strtof(argv[++i], nullptr);
+            validArguments = tileSize > 0.0f;
+        } else if (option == "--compressed") {
+            compressed = true;
+        } else if (option == "--hilbert") {
+            hilbert = true;
+        } else if (option == "--landmarks" && i + 1 < argc) {
+            landmarkCount = std::strtol(argv[++i], nullptr, 10);
+            validArguments = landmarkCount > 0;
+        } else {
+            validArguments = false;
+        }
+    }
+    if (!validArguments || (compressed && tileSize > 0.0f) || (landmarkCount > 0 && (compressed || tileSize > 0.0f))) {
+        printUsage();
+        return 1;
+    }
+
+    std::string nodesFile = argv[1];
+    std::string edgesFile = argv[2];
+    std::string graphFile = argv[3];
+
+    auto start = std::chrono::steady_clock::now();
+    RoadGraph graph(nodesFile, edgesFile);
+    auto parsed = std::chrono::steady_clock::now();
+
+    if (graph.getNodes().empty()) {
+        std::cerr << "No nodes loaded, nothing to convert" << std::endl;
+        return 1;
+    }
+
+    if (hilbert) {
+        graph.reorderAlongHilbertCurve();
+    }
+    auto reordered = std::chrono::steady_clock::now();
+
+    // Computed on the final ids, as they index the tables
+    Landmarks landmarks;
+    if (landmarkCount > 0) {
+        landmarks.build(graph, static_cast<size_t>(landmarkCount));
+    }
+    auto landmarked = std::chrono::steady_clock::now();
+
+    bool tiled = tileSize > 0.0f;
+    bool written = false;
+    if (compressed) {
+        written = GraphArchive::write(graph, graphFile);
+    } else if (tiled) {
+        written = GraphTiles::write(graph, graphFile, tileSize);
+    } else {
+        written = GraphFile::write(graph, graphFile, landmarks.getSections());
+    }
+    if (!written) {
+        return 1;
+    }
+    auto writtenAt = std::chrono::steady_clock::now();
+
+    std::unique_ptr<RoadGraph> loaded = compressed ? GraphArchive::read(graphFile) : std::make_unique<RoadGraph>(graphFile);
+    if (!loaded) {
+        return 1;
+    }
+    const RoadGraph& mapped = *loaded;
+    auto mappedAt = std::chrono::steady_clock::now();
+
+    // Same work the renderer does to turn roads into line segments
+    size_t segmentPoints = 0;
+    mapped.splitIntoBatches([&segmentPoints](GraphBatch&& batch) {
+        segmentPoints += batch.roadSegments.size();
+    });
+    auto segmented = std::chrono::steady_clock::now();
+
+    auto milliseconds = [](auto from, auto to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    size_t shapePointCount = graph.getShapePoints().size();
+    std::cout << "Nodes: " << graph.getNodes().size() << ", roads: " << graph.getRoads().size() << std::endl;
+    std::cout << "Shape points: " << shapePointCount << " (" << sizeof(glm::vec2) << " bytes each, "
+              << shapePointCount * sizeof(glm::vec2) / (1024.0 * 1024.0) << " MB)" << std::endl;
+    std::cout << "Parsed text in " << milliseconds(start, parsed) << " ms" << std::endl;
+    if (hilbert) {
+        std::cout << "Reordered along a Hilbert curve in " << milliseconds(parsed, reordered) << " ms" << std::endl;
+    }
+    if (landmarkCount > 0) {
+        std::cout << "Computed " << landmarks.getLandmarkCount() << " landmarks in " << milliseconds(reordered, landmarked) << " ms ("
+                  << landmarks.memoryUsage() / (1024.0 * 1024.0) << " MB)" << std::endl;
+    }
+    std::cout << "Wrote " << graphFile << " in " << milliseconds(landmarked, writtenAt) << " ms" << std::endl;
+    std::cout << (compressed ? "Decoded archive in " : "Mapped binary in ") << milliseconds(writtenAt, mappedAt) << " ms" << std::endl;
+    std::cout << "Built " << segmentPoints / 2 << " line segments in " << milliseconds(mappedAt, segmented) << " ms" << std::endl;
+
+    if (tiled) {
+        // Tiling drops missing ids and may copy shared shapes into both tiles
+        GraphTiles tiles(graphFile, SIZE_MAX);
+        if (!tiles.isValid() || mapped.getNodes().size() > graph.getNodes().size() || mapped.getRoads().size() > graph.getRoads().size()) {
+            std::cerr << "Verification of " << graphFile << " failed" << std::endl;
+            return 1;
+        }
+        size_t tileBytes = (mapped.getNodes().size() * sizeof(Node) + mapped.getRoads().size() * sizeof(Road) +
+                            mapped.getShapePoints().size() * sizeof(glm::vec2)) / tiles.getTileCount();
+        std::cout << "Tiles: " << tiles.getTileCount() << " of " << tileSize << " m, " << tileBytes / 1024.0 << " KB on average" << std::endl;
+    } else if (mapped.getNodes().size() != graph.getNodes().size() || mapped.getRoads().size() != graph.getRoads().size() ||
+               mapped.getShapePoints().size() != shapePointCount ||
+               (!landmarks.empty() && !Landmarks().read(graphFile, mapped))) {
+        std::cerr << "Verification of " << graphFile << " failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "GeoJsonGraphReader.h"
+#include "GraphFile.h"
+#include "GraphTextWriter.h"
+#include "OsmGraphBuilder.h"
+#include "OsmPbfReader.h"
+#include "OsmXmlReader.h"
+#include "Parallel.h"
+#include "RoadGraph.h"
+
+namespace {
+    struct ImportOptions {
+        std::vector<std::string> inputFiles;
+        std::string outputDirectory = "data";
+        std::string graphFile;
+        OsmGraphBuilder::Options builder;
+    };
+
+    void printUsage() {
+        std::cout << "Usage: graph-import <extract.osm|extract.osm.pbf> [--output <directory>] [--graph <graphFile>] [--retain-all]" << std::endl;
+        std::cout << "       graph-import <nodes.json> <edges.json> [--output <directory>] [--graph <graphFile>]" << std::endl;
+        std::cout << "Builds nodes.txt and edges.txt, or a binary graph file, from a local OpenStreetMap extract" << std::endl;
+        std::cout << "or from the GeoJSON exports in data/json" << std::endl;
+    }
+
+    bool endsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool isGeoJson(const ImportOptions& options) {
+        return !options.inputFiles.empty() && (endsWith(options.inputFiles[0], ".json") || endsWith(options.inputFiles[0], ".geojson"));
+    }
+
+    bool parseArguments(int argc, char** argv, ImportOptions& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--output" && i + 1 < argc) {
+                options.outputDirectory = argv[++i];
+            } else if (argument == "--graph" && i + 1 < argc) {
+                options.graphFile = argv[++i];
+            } else if (argument == "--retain-all") {
+                options.builder.retainAll = true;
+            } else if (!argument.empty() && argument[0] != '-' && options.inputFiles.size() < 2) {
+                options.inputFiles.push_back(argument);
+            } else {
+                return false;
+            }
+        }
+        // GeoJSON exports come as a node and an edge file, extracts as one file
+        return options.inputFiles.size() == (isGeoJson(options) ? 2 : 1);
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void printPass(const char* name, size_t bytes, double seconds) {
+        std::cout << name << " in " << seconds << " s (" << bytes / (1024.0 * 1024.0) / seconds << " MB/s)" << std::endl;
+    }
+
+    bool readXml(const std::string& filename, OsmGraphBuilder& builder) {
+        OsmXmlReader reader(filename);
+        if (!reader.isOpen()) {
+            std::cerr << "Failed to open " << filename << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        reader.readWays([&builder](int64_t, const std::vector<int64_t>& refs, const std::vector<OsmTag>& tags) {
+            builder.addWay(refs, tags);
+        });
+        builder.finishWays();
+        printPass("Read ways", reader.getSize(), secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        reader.readNodes([&builder](int64_t id, double latitude, double longitude) {
+            if (builder.needsNode(id)) {
+                builder.setNodeLocation(id, latitude, longitude);
+            }
+        });
+        printPass("Read nodes", reader.getSize(), secondsSince(start));
+        return true;
+    }
+
+    bool readPbf(const std::string& filename, OsmGraphBuilder& builder) {
+        OsmPbfReader reader(filename);
+        if (!reader.isOpen()) {
+            std::cerr << "Failed to open " << filename << std::endl;
+            return false;
+        }
+        std::cout << "Decoding " << reader.getBlobCount() << " blobs on " << getWorkerCount() << " threads" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        bool waysRead = reader.readWays([&builder](int64_t, const std::vector<int64_t>& refs, const std::vector<OsmTag>& tags) {
+            builder.addWay(refs, tags);
+        }, &OsmGraphBuilder::isDrivable);
+        if (!waysRead) {
+            return false;
+        }
+        builder.finishWays();
+        printPass("Read ways", reader.getSize(), secondsSince(start));
+
+        // Each node id owns its own slot in the builder, so workers can store locations directly
+        start = std::chrono::steady_clock::now();
+        bool nodesRead = reader.readNodes([&builder](int64_t id, double latitude, double longitude) {
+            builder.setNodeLocation(id, latitude, longitude);
+        });
+        if (!nodesRead) {
+            return false;
+        }
+        printPass("Read nodes", reader.getSize(), secondsSince(start));
+        return true;
+    }
+
+    bool importExtract(const ImportOptions& options) {
+        auto start = std::chrono::steady_clock::now();
+        OsmGraphBuilder builder;
+        bool read = endsWith(options.inputFiles[0], ".pbf") ? readPbf(options.inputFiles[0], builder) : readXml(options.inputFiles[0], builder);
+        if (!read) {
+            return false;
+        }
+        std::cout << "Drivable ways: " << builder.getWayCount() << ", referenced nodes: " << builder.getReferencedNodeCount() << std::endl;
+
+        auto buildStart = std::chrono::steady_clock::now();
+        if (!builder.build(options.builder)) {
+            return false;
+        }
+        std::cout << "Simplified to " << builder.getNodeCount() << " nodes and " << builder.getEdgeCount() << " edges with "
+                  << builder.getShapePointCount() << " shape points in " << secondsSince(buildStart) << " s" << std::endl;
+
+        if (!options.graphFile.empty()) {
+            if (!builder.writeGraph(options.graphFile)) {
+                return false;
+            }
+            std::cout << "Wrote " << options.graphFile << " in " << secondsSince(start) << " s total" << std::endl;
+            return true;
+        }
+
+        std::string nodesFile = options.outputDirectory + "/nodes.txt";
+        std::string edgesFile = options.outputDirectory + "/edges.txt";
+        if (!builder.writeText(nodesFile, edgesFile)) {
+            return false;
+        }
+
+        std::cout << "Wrote " << nodesFile << " and " << edgesFile << " in " << secondsSince(start) << " s total" << std::endl;
+        return true;
+    }
+
+    bool importGeoJson(const ImportOptions& options) {
+        const std::string& nodesJson = options.inputFiles[0];
+        const std::string& edgesJson = options.inputFiles[1];
+        std::string nodesFile = options.outputDirectory + "/nodes.txt";
+        std::string edgesFile = options.outputDirectory + "/edges.txt";
+
+        // Text output is streamed feature by feature, a graph file needs the arrays
+        std::unique_ptr<GraphTextWriter> writer;
+        std::vector<Node> nodeValues;
+        std::vector<Road> roadValues;
+        std::vector<glm::vec2> shapeValues;
+        if (options.graphFile.empty()) {
+            writer = std::make_unique<GraphTextWriter>(nodesFile, edgesFile);
+            if (!writer->isOpen()) {
+                std::cerr << "Failed to create " << nodesFile << " or " << edgesFile << std::endl;
+                return false;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        GeoJsonGraphReader reader;
+        bool nodesRead = reader.readNodes(nodesJson, [&](size_t id, double x, double y) {
+            if (writer) {
+                writer->writeNode(id, x, y);
+            } else {
+                nodeValues.emplace_back(glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f));
+            }
+        });
+        if (!nodesRead) {
+            return false;
+        }
+        std::cout << "Read " << reader.getNodeCount() << " nodes in " << secondsSince(start) << " s" << std::endl;
+
+        auto edgesStart = std::chrono::steady_clock::now();
+        size_t edgeCount = 0;
+        size_t shapePointCount = 0;
+        bool edgesRead = reader.readEdges(edgesJson, [&](size_t from, size_t to, double meters, int maxSpeed, int lanes, bool oneWay,
+                                                         const std::vector<glm::dvec2>& shape) {
+            ++edgeCount;
+            shapePointCount += shape.size();
+            if (writer) {
+                writer->writeEdge(from, to, meters, maxSpeed, lanes, oneWay, shape);
+                return;
+            }
+
+            uint32_t shapeBegin = static_cast<uint32_t>(shapeValues.size());
+            uint32_t shapeCount = static_cast<uint32_t>(shape.size());
+            for (const glm::dvec2& point : shape) {
+                shapeValues.emplace_back(static_cast<float>(point.x), static_cast<float>(point.y));
+            }
+            roadValues.emplace_back(from, to, static_cast<float>(meters), static_cast<float>(maxSpeed), lanes, shapeBegin, shapeCount, !oneWay);
+        });
+        if (!edgesRead) {
+            return false;
+        }
+        std::cout << "Read " << edgeCount << " edges with " << shapePointCount << " shape points in " << secondsSince(edgesStart) << " s" << std::endl;
+
+        if (writer) {
+            if (!writer->close()) {
+                std::cerr << "Failed to write " << nodesFile << " or " << edgesFile << std::endl;
+                return false;
+            }
+            std::cout << "Wrote " << nodesFile << " and " << edgesFile << " in " << secondsSince(start) << " s total" << std::endl;
+            return true;
+        }
+
+        // The exports list a two-way street once per direction
+        size_t merged = RoadGraph::mergeReciprocalRoads(roadValues, shapeValues);
+        std::cout << "Merged " << merged << " reverse edges into two-way roads" << std::endl;
+        RoadGraph graph(std::move(nodeValues), std::move(roadValues), std::move(shapeValues));
+        if (!GraphFile::write(graph, options.graphFile)) {
+            return false;
+        }
+        std::cout << "Wrote " << options.graphFile << " in " << secondsSince(start) << " s total" << std::endl;
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    ImportOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    bool imported = isGeoJson(options) ? importGeoJson(options) : importExtract(options);
+    return imported ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+#include "GeoJsonGraphReader.h"
+#include "GeoJsonReader.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+    bool equalsIgnoreCase(std::string_view text, std::string_view lowercase) {
+        return text.size() == lowercase.size() &&
+               std::equal(text.begin(), text.end(), lowercase.begin(), [](char a, char b) {
+                   return std::tolower(static_cast<unsigned char>(a)) == b;
+               });
+    }
+
+    bool parseId(std::string_view text, int64_t& id) {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), id);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    // Python's int() of a JSON scalar
+    bool toInteger(const GeoJsonValue& value, int& integer) {
+        if (value.type == GeoJsonValue::Number) {
+            double number;
+            std::from_chars(value.text.data(), value.text.data() + value.text.size(), number);
+            if (!(std::abs(number) < INT_MAX)) {
+                return false;
+            }
+            integer = static_cast<int>(std::trunc(number));
+            return true;
+        } else if (value.type == GeoJsonValue::Boolean) {
+            integer = value.text == "true" ? 1 : 0;
+            return true;
+        } else if (value.type == GeoJsonValue::String) {
+            return parseInteger(value.text, integer);
+        }
+        return false;
+    }
+
+    // parse_speed: negative when there is no usable speed
+    double parseSpeed(const GeoJsonValue* value) {
+        if (!value) {
+            return -1;
+        }
+
+        if (value->type == GeoJsonValue::Array) {
+            double sum = 0;
+            size_t count = 0;
+            for (const GeoJsonValue& item : value->items) {
+                double speed = parseSpeed(&item);
+                if (speed > 0) {
+                    sum += speed;
+                    ++count;
+                }
+            }
+            return count > 0 ? sum / count : -1;
+        }
+
+        int speed;
+        if (toInteger(*value, speed)) {
+            return speed;
+        }
+        if (value->type == GeoJsonValue::String && equalsIgnoreCase(value->text, "walk")) {
+            return 5;
+        }
+        return -1;
+    }
+
+    int parseLanes(const GeoJsonValue* value) {
+        const int defaultLanes = 2;
+        if (!value || value->items.empty()) {
+            int lanes;
+            return value && toInteger(*value, lanes) ? lanes : defaultLanes;
+        }
+
+        int lanes = INT_MIN;
+        for (const GeoJsonValue& item : value->items) {
+            int itemLanes;
+            lanes = std::max(lanes, toInteger(item, itemLanes) ? itemLanes : defaultLanes);
+        }
+        return lanes;
+    }
+
+    // Key the highway type like Python would: first item of a list, None for null
+    std::string highwayType(const GeoJsonValue* value) {
+        if (!value) {
+            return "unclassified";
+        }
+        if (value->type == GeoJsonValue::Array) {
+            return value->items.empty() ? "None" : highwayType(&value->items.front());
+        }
+        return value->type == GeoJsonValue::Null ? "None" : std::string(value->text);
+    }
+
+    bool isOneWay(const GeoJsonValue* value) {
+        return value && (value->type == GeoJsonValue::Boolean || value->type == GeoJsonValue::String) &&
+               equalsIgnoreCase(value->text, "true");
+    }
+}
+
+/* METHODS */
+bool GeoJsonGraphReader::readNodes(const std::string& nodesFile, const NodeCallback& onNode) {
+    GeoJsonReader reader(nodesFile);
+    if (!reader.isOpen()) {
+        std::cerr << "Failed to open " << nodesFile << std::endl;
+        return false;
+    }
+
+    double minLongitude = std::numeric_limits<double>::max(), maxLongitude = -std::numeric_limits<double>::max();
+    double minLatitude = std::numeric_limits<double>::max(), maxLatitude = -std::numeric_limits<double>::max();
+    size_t invalidNodes = 0;
+    nodeIndices.clear();
+
+    bool read = reader.readFeatures([&](const GeoJsonFeature& feature) {
+        int64_t id;
+        double longitude, latitude;
+        if (!parseId(feature.id, id) || !readPosition(feature, longitude, latitude)) {
+            ++invalidNodes;
+            return;
+        }
+        nodeIndices.emplace_back(id, static_cast<uint32_t>(nodeIndices.size()));
+        minLongitude = std::min(minLongitude, longitude);
+        maxLongitude = std::max(maxLongitude, longitude);
+        minLatitude = std::min(minLatitude, latitude);
+        maxLatitude = std::max(maxLatitude, latitude);
+    });
+    if (!read) {
+        return false;
+    }
+    if (invalidNodes > 0) {
+        std::cerr << invalidNodes << " node(s) in " << nodesFile << " have no integer id or point geometry" << std::endl;
+        return false;
+    }
+    std::sort(nodeIndices.begin(), nodeIndices.end());
+
+    centerLongitude = (minLongitude + maxLongitude) / 2;
+    centerLatitude = (minLatitude + maxLatitude) / 2;
+    size_t index = 0;
+    return reader.readFeatures([&](const GeoJsonFeature& feature) {
+        double longitude = 0, latitude = 0;
+        readPosition(feature, longitude, latitude);
+        glm::dvec2 position = toMetricCoordinates(longitude, latitude, centerLongitude, centerLatitude);
+        onNode(index++, position.x, position.y);
+    });
+}
+
+bool GeoJsonGraphReader::readEdges(const std::string& edgesFile, const EdgeCallback& onEdge) {
+    GeoJsonReader reader(edgesFile);
+    if (!reader.isOpen()) {
+        std::cerr << "Failed to open " << edgesFile << std::endl;
+        return false;
+    }
+
+    size_t skippedEdges = 0;
+    std::vector<glm::dvec2> shape;
+    bool read = reader.readFeatures([&](const GeoJsonFeature& feature) {
+        // Edge ids are the osmnx (u, v, key) tuple
+        std::string_view id = feature.id;
+        size_t begin = id.find_first_not_of("()");
+        size_t end = id.find_last_not_of("()");
+        id = begin == std::string_view::npos ? std::string_view() : id.substr(begin, end - begin + 1);
+
+        size_t separator = id.find(", ");
+        std::string_view to = separator == std::string_view::npos ? std::string_view() : id.substr(separator + 2);
+        uint32_t fromIndex, toIndex;
+        if (!findNode(id.substr(0, separator), fromIndex) || !findNode(to.substr(0, to.find(", ")), toIndex)) {
+            ++skippedEdges;
+            return;
+        }
+
+        double meters = 0;
+        const GeoJsonValue* length = feature.findProperty("length");
+        if (length && length->type == GeoJsonValue::Number) {
+            std::from_chars(length->text.data(), length->text.data() + length->text.size(), meters);
+        }
+
+        int maxSpeed = speedDefaults.resolve(highwayType(feature.findProperty("highway")), parseSpeed(feature.findProperty("maxspeed")));
+        int lanes = parseLanes(feature.findProperty("lanes"));
+        bool oneWay = isOneWay(feature.findProperty("oneway"));
+
+        // The geometry runs from u to v; its end points are the nodes themselves
+        shape.clear();
+        size_t pointCount = feature.geometryType == "LineString" ? feature.coordinates.size() : 0;
+        for (size_t i = 1; i + 1 < pointCount; ++i) {
+            shape.push_back(toMetricCoordinates(feature.coordinates[i].x, feature.coordinates[i].y, centerLongitude, centerLatitude));
+        }
+        onEdge(fromIndex, toIndex, std::round(meters * 1000.0) / 1000.0, maxSpeed, lanes, oneWay, shape);
+    });
+
+    if (skippedEdges > 0) {
+        std::cerr << "Skipped " << skippedEdges << " edge(s) in " << edgesFile << " whose nodes are not in the node file" << std::endl;
+    }
+    return read;
+}
+
+bool GeoJsonGraphReader::findNode(std::string_view id, uint32_t& index) const {
+    int64_t value;
+    if (!parseId(id, value)) {
+        return false;
+    }
+
+    // Later duplicates win, as with the dict in extract_and_save_graph_data
+    auto it = std::upper_bound(nodeIndices.begin(), nodeIndices.end(), std::make_pair(value, UINT32_MAX));
+    if (it == nodeIndices.begin() || (it - 1)->first != value) {
+        return false;
+    }
+    index = (it - 1)->second;
+    return true;
+}
+
+bool GeoJsonGraphReader::readPosition(const GeoJsonFeature& feature, double& longitude, double& latitude) {
+    if (feature.coordinates.empty()) {
+        return false;
+    }
+    longitude = feature.coordinates.front().x;
+    latitude = feature.coordinates.front().y;
+    return true;
+}
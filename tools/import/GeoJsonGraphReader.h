@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "RoadDefaults.h"
+
+struct GeoJsonFeature;
+
+// Reads the nodes.json/edges.json exports of import/graph_utils.py and hands
+// out nodes and roads with the same ids, coordinates and attributes as
+// extract_and_save_graph_data, one feature at a time. Only the node id table
+// is kept in memory.
+class GeoJsonGraphReader {
+public:
+    using NodeCallback = std::function<void(size_t id, double x, double y)>;
+    // shape holds the metric points between the end nodes
+    using EdgeCallback = std::function<void(size_t from, size_t to, double meters, int maxSpeed, int lanes, bool oneWay,
+                                            const std::vector<glm::dvec2>& shape)>;
+
+    // Two passes: the bounding box center is needed before the first node can be placed
+    bool readNodes(const std::string& nodesFile, const NodeCallback& onNode);
+    // Needs readNodes() first, to resolve the OSM ids of the edge endpoints
+    bool readEdges(const std::string& edgesFile, const EdgeCallback& onEdge);
+
+    size_t getNodeCount() const { return nodeIndices.size(); }
+
+private:
+    // OSM id and position in nodes.json, sorted by id
+    std::vector<std::pair<int64_t, uint32_t>> nodeIndices;
+    SpeedDefaults speedDefaults;
+    double centerLongitude = 0;
+    double centerLatitude = 0;
+
+    bool findNode(std::string_view id, uint32_t& index) const;
+    static bool readPosition(const GeoJsonFeature& feature, double& longitude, double& latitude);
+};
@@ -0,0 +1,439 @@
+#include "GeoJsonReader.h"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Consumed pages are handed back in steps of this size
+    const size_t releaseStep = 16 * 1024 * 1024;
+
+    // Deeper nesting is no GeoJSON we can use and would only risk the stack
+    const int maxDepth = 64;
+
+    bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool isNumberCharacter(char c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    void appendUtf8(std::string& output, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            output.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            output.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            output.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            output.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    bool readHex(const char*& position, const char* end, uint32_t& value) {
+        if (end - position < 4) {
+            return false;
+        }
+        auto result = std::from_chars(position, position + 4, value, 16);
+        if (result.ec != std::errc() || result.ptr != position + 4) {
+            return false;
+        }
+        position += 4;
+        return true;
+    }
+}
+
+const GeoJsonValue* GeoJsonFeature::findProperty(std::string_view key) const {
+    for (const auto& property : properties) {
+        if (property.first == key) {
+            return &property.second;
+        }
+    }
+    return nullptr;
+}
+
+/* CONSTRUCTORS */
+GeoJsonReader::GeoJsonReader(const std::string& filename): file(filename), filename(filename) {
+    file.adviseSequential();
+}
+
+
+/* METHODS */
+bool GeoJsonReader::readFeatures(const FeatureCallback& onFeature) {
+    position = file.getData();
+    end = position + file.getSize();
+    decodedStrings.clear();
+
+    bool hasFeatures = false;
+    size_t released = 0;
+    bool valid = readObject([&](std::string_view key) {
+        if (key != "features") {
+            return skipValue();
+        }
+        hasFeatures = true;
+        return readArray([&]() {
+            if (!readFeature()) {
+                return false;
+            }
+            onFeature(feature);
+
+            // Keeps the resident part of the mapping bounded on large files
+            size_t consumed = position - file.getData();
+            if (consumed - released >= releaseStep) {
+                file.release(consumed);
+                released = consumed;
+            }
+            return true;
+        });
+    });
+    if (!valid) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (position != end) {
+        return fail();
+    }
+    if (!hasFeatures) {
+        std::cerr << "No features in GeoJSON file " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool GeoJsonReader::readFeature() {
+    feature.id = std::string_view();
+    feature.geometryType = std::string_view();
+    feature.coordinates.clear();
+    feature.properties.clear();
+    decodedStrings.clear();
+
+    return readObject([this](std::string_view key) {
+        if (key == "id") {
+            GeoJsonValue id;
+            if (!readValue(id, false)) {
+                return false;
+            }
+            feature.id = id.text;
+            return true;
+        } else if (key == "properties") {
+            return readProperties();
+        } else if (key == "geometry") {
+            return readGeometry();
+        }
+        return skipValue();
+    });
+}
+
+bool GeoJsonReader::readProperties() {
+    skipWhitespace();
+    if (peek('n')) {
+        return readLiteral("null");
+    }
+
+    return readObject([this](std::string_view key) {
+        auto& property = feature.properties.emplace_back();
+        property.first = key;
+        return readValue(property.second, true);
+    });
+}
+
+bool GeoJsonReader::readGeometry() {
+    skipWhitespace();
+    if (peek('n')) {
+        return readLiteral("null");
+    }
+
+    return readObject([this](std::string_view key) {
+        if (key == "type") {
+            skipWhitespace();
+            return readString(feature.geometryType);
+        } else if (key == "coordinates") {
+            return readPositions(0);
+        }
+        return skipValue();
+    });
+}
+
+// Flattens the nested coordinate arrays of any geometry type into positions
+bool GeoJsonReader::readPositions(int depth) {
+    if (depth > maxDepth) {
+        return fail();
+    }
+
+    double values[2] = {0.0, 0.0};
+    size_t count = 0;
+    return readArray([&]() {
+        if (peek('[')) {
+            return readPositions(depth + 1);
+        }
+
+        std::string_view number;
+        if (!readNumber(number)) {
+            return false;
+        }
+        if (count < 2) {
+            std::from_chars(number.data(), number.data() + number.size(), values[count]);
+            if (++count == 2) {
+                feature.coordinates.emplace_back(values[0], values[1]);
+            }
+        }
+        return true;
+    });
+}
+
+bool GeoJsonReader::readValue(GeoJsonValue& value, bool keepItems) {
+    skipWhitespace();
+    value.text = std::string_view();
+    value.items.clear();
+    if (position >= end) {
+        return fail();
+    }
+
+    switch (*position) {
+        case '"':
+            value.type = GeoJsonValue::String;
+            return readString(value.text);
+        case '{':
+            value.type = GeoJsonValue::Object;
+            return skipValue();
+        case '[':
+            value.type = GeoJsonValue::Array;
+            if (!keepItems) {
+                return skipValue();
+            }
+            return readArray([&]() {
+                return readValue(value.items.emplace_back(), false);
+            });
+        case 't':
+            value.type = GeoJsonValue::Boolean;
+            value.text = "true";
+            return readLiteral("true");
+        case 'f':
+            value.type = GeoJsonValue::Boolean;
+            value.text = "false";
+            return readLiteral("false");
+        case 'n':
+            value.type = GeoJsonValue::Null;
+            return readLiteral("null");
+        default:
+            value.type = GeoJsonValue::Number;
+            return readNumber(value.text);
+    }
+}
+
+// Only checks that brackets balance, the skipped content is never looked at
+bool GeoJsonReader::skipValue() {
+    int depth = 0;
+    do {
+        skipWhitespace();
+        if (position >= end) {
+            return fail();
+        }
+
+        char c = *position;
+        if (c == '{' || c == '[') {
+            if (++depth > maxDepth) {
+                return fail();
+            }
+            ++position;
+        } else if (c == '}' || c == ']') {
+            if (--depth < 0) {
+                return fail();
+            }
+            ++position;
+        } else if (c == '"') {
+            ++position;
+            while (position < end && *position != '"') {
+                position += *position == '\\' ? 2 : 1;
+            }
+            if (position >= end) {
+                return fail();
+            }
+            ++position;
+        } else if (c == ',' || c == ':') {
+            ++position;
+        } else {
+            const char* begin = position;
+            while (position < end && !isWhitespace(*position) && !std::strchr(",:]}", *position)) {
+                ++position;
+            }
+            if (position == begin) {
+                return fail();
+            }
+        }
+    } while (depth > 0);
+    return true;
+}
+
+bool GeoJsonReader::readString(std::string_view& value) {
+    if (!expect('"')) {
+        return false;
+    }
+
+    const char* begin = position;
+    while (position < end && *position != '"' && *position != '\\') {
+        ++position;
+    }
+    if (position < end && *position == '"') {
+        value = std::string_view(begin, position - begin);
+        ++position;
+        return true;
+    }
+
+    // deque keeps earlier strings in place, so views handed out stay valid
+    std::string& decoded = decodedStrings.emplace_back(begin, position - begin);
+    while (position < end) {
+        char c = *position++;
+        if (c == '"') {
+            value = decoded;
+            return true;
+        }
+        if (c != '\\') {
+            decoded.push_back(c);
+            continue;
+        }
+        if (position >= end) {
+            break;
+        }
+
+        char escape = *position++;
+        uint32_t codePoint;
+        switch (escape) {
+            case '"': case '\\': case '/': decoded.push_back(escape); break;
+            case 'b': decoded.push_back('\b'); break;
+            case 'f': decoded.push_back('\f'); break;
+            case 'n': decoded.push_back('\n'); break;
+            case 'r': decoded.push_back('\r'); break;
+            case 't': decoded.push_back('\t'); break;
+            case 'u':
+                if (!readHex(position, end, codePoint)) {
+                    return fail();
+                }
+                // Characters outside the basic plane come as a surrogate pair
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - position >= 6 && position[0] == '\\' && position[1] == 'u') {
+                    const char* low = position + 2;
+                    uint32_t lowSurrogate;
+                    if (readHex(low, end, lowSurrogate) && lowSurrogate >= 0xDC00 && lowSurrogate < 0xE000) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                        position = low;
+                    }
+                }
+                appendUtf8(decoded, codePoint);
+                break;
+            default:
+                return fail();
+        }
+    }
+    return fail();
+}
+
+bool GeoJsonReader::readNumber(std::string_view& value) {
+    skipWhitespace();
+    const char* begin = position;
+    while (position < end && isNumberCharacter(*position)) {
+        ++position;
+    }
+
+    double number;
+    auto result = std::from_chars(begin, position, number);
+    if (position == begin || result.ec != std::errc() || result.ptr != position) {
+        position = begin;
+        return fail();
+    }
+    value = std::string_view(begin, position - begin);
+    return true;
+}
+
+bool GeoJsonReader::readLiteral(std::string_view literal) {
+    if (static_cast<size_t>(end - position) < literal.size() || std::string_view(position, literal.size()) != literal) {
+        return fail();
+    }
+    position += literal.size();
+    return true;
+}
+
+template<typename Handler>
+bool GeoJsonReader::readObject(Handler&& onMember) {
+    skipWhitespace();
+    if (!expect('{')) {
+        return false;
+    }
+    skipWhitespace();
+    if (peek('}')) {
+        ++position;
+        return true;
+    }
+
+    while (true) {
+        std::string_view key;
+        skipWhitespace();
+        if (!readString(key)) {
+            return false;
+        }
+        skipWhitespace();
+        if (!expect(':') || !onMember(key)) {
+            return false;
+        }
+        skipWhitespace();
+        if (!peek(',')) {
+            return expect('}');
+        }
+        ++position;
+    }
+}
+
+template<typename Handler>
+bool GeoJsonReader::readArray(Handler&& onItem) {
+    skipWhitespace();
+    if (!expect('[')) {
+        return false;
+    }
+    skipWhitespace();
+    if (peek(']')) {
+        ++position;
+        return true;
+    }
+
+    while (true) {
+        skipWhitespace();
+        if (!onItem()) {
+            return false;
+        }
+        skipWhitespace();
+        if (!peek(',')) {
+            return expect(']');
+        }
+        ++position;
+    }
+}
+
+void GeoJsonReader::skipWhitespace() {
+    while (position < end && isWhitespace(*position)) {
+        ++position;
+    }
+}
+
+bool GeoJsonReader::peek(char c) {
+    return position < end && *position == c;
+}
+
+bool GeoJsonReader::expect(char c) {
+    if (!peek(c)) {
+        return fail();
+    }
+    ++position;
+    return true;
+}
+
+bool GeoJsonReader::fail() {
+    std::cerr << "Invalid GeoJSON at byte " << (position - file.getData()) << " in " << filename << std::endl;
+    return false;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+
+// A property value. Arrays keep their scalar items, nested objects and
+// arrays are skipped and only their type is kept.
+struct GeoJsonValue {
+    enum Type { Null, Boolean, Number, String, Array, Object };
+
+    Type type = Null;
+    // Numbers as written, strings decoded, booleans as "true" or "false"
+    std::string_view text;
+    std::vector<GeoJsonValue> items;
+};
+
+// The feature currently being read. Views point into the reader and stay
+// valid until the callback returns.
+struct GeoJsonFeature {
+    std::string_view id;
+    std::string_view geometryType;
+    // Every position of the geometry in order, as longitude/latitude
+    std::vector<glm::dvec2> coordinates;
+    std::vector<std::pair<std::string_view, GeoJsonValue>> properties;
+
+    const GeoJsonValue* findProperty(std::string_view key) const;
+};
+
+// Streaming reader for GeoJSON FeatureCollections such as the exports in
+// data/json. The file is memory-mapped and walked token by token; only the
+// current feature is held in memory, so memory use does not grow with the file.
+class GeoJsonReader {
+public:
+    using FeatureCallback = std::function<void(const GeoJsonFeature& feature)>;
+
+    explicit GeoJsonReader(const std::string& filename);
+
+    bool isOpen() const { return file.isOpen(); }
+    size_t getSize() const { return file.getSize(); }
+
+    // One pass over the file; false if it is not a valid FeatureCollection
+    bool readFeatures(const FeatureCallback& onFeature);
+
+private:
+    MappedFile file;
+    std::string filename;
+    const char* position = nullptr;
+    const char* end = nullptr;
+    GeoJsonFeature feature;
+    std::deque<std::string> decodedStrings;
+
+    bool fail();
+    bool expect(char c);
+    bool peek(char c);
+    void skipWhitespace();
+
+    bool readString(std::string_view& value);
+    bool readNumber(std::string_view& value);
+    bool readLiteral(std::string_view literal);
+    bool readValue(GeoJsonValue& value, bool keepItems);
+    bool skipValue();
+
+    bool readFeature();
+    bool readProperties();
+    bool readGeometry();
+    bool readPositions(int depth);
+
+    template<typename Handler>
+    bool readObject(Handler&& onMember);
+    template<typename Handler>
+    bool readArray(Handler&& onItem);
+};
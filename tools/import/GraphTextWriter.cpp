@@ -0,0 +1,102 @@
+#include "GraphTextWriter.h"
+#include <charconv>
+#include <string_view>
+
+namespace {
+    const size_t flushSize = 1 << 20;
+
+    void appendPythonFloat(std::string& output, double value) {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        std::string_view text(buffer, result.ptr - buffer);
+        output.append(text);
+        if (text.find_first_of(".en") == std::string_view::npos) {
+            output.append(".0");
+        }
+    }
+
+    void appendFixed(std::string& output, double value, int precision) {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+        output.append(buffer, result.ptr);
+    }
+
+    void appendInteger(std::string& output, long long value) {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        output.append(buffer, result.ptr);
+    }
+}
+
+/* CONSTRUCTORS */
+GraphTextWriter::GraphTextWriter(const std::string& nodesFile, const std::string& edgesFile):
+    nodesOutput(std::fopen(nodesFile.c_str(), "wb")),
+    edgesOutput(std::fopen(edgesFile.c_str(), "wb")) {
+    failed = !isOpen();
+}
+
+GraphTextWriter::~GraphTextWriter() {
+    close();
+}
+
+
+/* METHODS */
+void GraphTextWriter::writeNode(size_t id, double x, double y) {
+    appendInteger(nodesBuffer, static_cast<long long>(id));
+    nodesBuffer.push_back(' ');
+    appendFixed(nodesBuffer, x, 6);
+    nodesBuffer.push_back(' ');
+    appendFixed(nodesBuffer, y, 6);
+    nodesBuffer.append(" 0\n");
+    if (nodesBuffer.size() >= flushSize) {
+        flush(nodesOutput, nodesBuffer);
+    }
+}
+
+void GraphTextWriter::writeEdge(long long from, long long to, double meters, int maxSpeed, int lanes, bool oneWay,
+                                const std::vector<glm::dvec2>& shape) {
+    appendInteger(edgesBuffer, from);
+    edgesBuffer.push_back(' ');
+    appendInteger(edgesBuffer, to);
+    edgesBuffer.push_back(' ');
+    appendPythonFloat(edgesBuffer, meters);
+    edgesBuffer.push_back(' ');
+    appendInteger(edgesBuffer, maxSpeed);
+    edgesBuffer.push_back(' ');
+    appendInteger(edgesBuffer, lanes);
+    edgesBuffer.append(oneWay ? " 1" : " 0");
+    for (const glm::dvec2& point : shape) {
+        edgesBuffer.push_back(' ');
+        appendFixed(edgesBuffer, point.x, 6);
+        edgesBuffer.push_back(' ');
+        appendFixed(edgesBuffer, point.y, 6);
+    }
+    edgesBuffer.push_back('\n');
+    if (edgesBuffer.size() >= flushSize) {
+        flush(edgesOutput, edgesBuffer);
+    }
+}
+
+bool GraphTextWriter::close() {
+    closeFile(nodesOutput, nodesBuffer);
+    closeFile(edgesOutput, edgesBuffer);
+    return !failed;
+}
+
+void GraphTextWriter::closeFile(std::FILE*& file, std::string& buffer) {
+    if (!file) {
+        return;
+    }
+    flush(file, buffer);
+    if (std::fclose(file) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+}
+
+void GraphTextWriter::flush(std::FILE* file, std::string& buffer) {
+    if (!buffer.empty() && (!file || std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())) {
+        failed = true;
+    }
+    buffer.clear();
+}
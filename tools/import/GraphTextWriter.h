@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Writes nodes.txt and edges.txt in the exact format of import/main.py, so
+// the native importers and the Python pipeline produce identical files
+class GraphTextWriter {
+public:
+    GraphTextWriter(const std::string& nodesFile, const std::string& edgesFile);
+    ~GraphTextWriter();
+
+    bool isOpen() const { return nodesOutput && edgesOutput; }
+
+    void writeNode(size_t id, double x, double y);
+    // meters is written like Python's repr() of a float, shape points follow as x y pairs
+    void writeEdge(long long from, long long to, double meters, int maxSpeed, int lanes, bool oneWay,
+                   const std::vector<glm::dvec2>& shape = {});
+
+    // False if anything failed to write
+    bool close();
+
+private:
+    std::FILE* nodesOutput;
+    std::FILE* edgesOutput;
+    std::string nodesBuffer;
+    std::string edgesBuffer;
+    bool failed = false;
+
+    GraphTextWriter(const GraphTextWriter&) = delete;
+    GraphTextWriter& operator=(const GraphTextWriter&) = delete;
+
+    void flush(std::FILE* file, std::string& buffer);
+    void closeFile(std::FILE*& file, std::string& buffer);
+};
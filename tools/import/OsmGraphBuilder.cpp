@@ -0,0 +1,457 @@
+#include "OsmGraphBuilder.h"
+#include "GraphFile.h"
+#include "GraphTextWriter.h"
+#include "RoadDefaults.h"
+#include "RoadGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+namespace {
+    const std::string_view excludedHighways[] = {
+        "abandoned", "bridleway", "bus_guideway", "construction", "corridor", "cycleway",
+        "elevator", "escalator", "footway", "no", "path", "pedestrian", "planned",
+        "platform", "proposed", "raceway", "razed", "service", "steps", "track",
+    };
+
+    const std::string_view excludedServices[] = {
+        "alley", "driveway", "emergency_access", "parking", "parking_aisle", "private",
+    };
+
+    const std::string_view oneWayValues[] = {"yes", "true", "1", "-1", "reverse"};
+    const std::string_view reversedValues[] = {"-1", "reverse"};
+
+    template<size_t Size>
+    bool contains(const std::string_view (&values)[Size], std::string_view value) {
+        return std::find(std::begin(values), std::end(values), value) != std::end(values);
+    }
+
+    std::string_view findTag(const std::vector<OsmTag>& tags, std::string_view key) {
+        for (const OsmTag& tag : tags) {
+            if (tag.key == key) {
+                return tag.value;
+            }
+        }
+        return std::string_view();
+    }
+
+    bool hasTag(const std::vector<OsmTag>& tags, std::string_view key) {
+        for (const OsmTag& tag : tags) {
+            if (tag.key == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct DisjointSet {
+        std::vector<uint32_t> parents;
+
+        explicit DisjointSet(size_t size): parents(size) {
+            std::iota(parents.begin(), parents.end(), 0);
+        }
+
+        uint32_t find(uint32_t element) {
+            while (parents[element] != element) {
+                parents[element] = parents[parents[element]];
+                element = parents[element];
+            }
+            return element;
+        }
+
+        void unite(uint32_t a, uint32_t b) {
+            a = find(a);
+            b = find(b);
+            if (a != b) {
+                parents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    };
+}
+
+/* METHODS */
+bool OsmGraphBuilder::isDrivable(const std::vector<OsmTag>& tags) {
+    if (!hasTag(tags, "highway")) {
+        return false;
+    }
+
+    return !contains(excludedHighways, findTag(tags, "highway")) &&
+           findTag(tags, "area") != "yes" &&
+           findTag(tags, "access") != "private" &&
+           findTag(tags, "motor_vehicle") != "no" &&
+           findTag(tags, "motorcar") != "no" &&
+           !contains(excludedServices, findTag(tags, "service"));
+}
+
+void OsmGraphBuilder::addWay(const std::vector<int64_t>& refs, const std::vector<OsmTag>& tags) {
+    if (refs.size() < 2 || !isDrivable(tags)) {
+        return;
+    }
+
+    Way way;
+    way.refBegin = wayRefs.size();
+    way.refCount = static_cast<uint32_t>(refs.size());
+    way.highway = internHighway(findTag(tags, "highway"));
+
+    int value;
+    way.maxSpeed = tagMissing;
+    if (hasTag(tags, "maxspeed")) {
+        std::string_view maxSpeed = findTag(tags, "maxspeed");
+        if (parseInteger(maxSpeed, value) && value >= 0 && value <= INT16_MAX) {
+            way.maxSpeed = static_cast<int16_t>(value);
+        } else if (maxSpeed == "walk" || maxSpeed == "Walk" || maxSpeed == "WALK") {
+            way.maxSpeed = 5;
+        } else {
+            way.maxSpeed = tagInvalid;
+        }
+    }
+
+    way.lanes = tagMissing;
+    if (hasTag(tags, "lanes")) {
+        way.lanes = parseInteger(findTag(tags, "lanes"), value) && value >= 0 && value <= INT16_MAX ? static_cast<int16_t>(value) : tagInvalid;
+    }
+
+    std::string_view oneWay = findTag(tags, "oneway");
+    way.oneWay = contains(oneWayValues, oneWay) || findTag(tags, "junction") == "roundabout";
+    way.reversed = contains(reversedValues, oneWay);
+
+    wayRefs.insert(wayRefs.end(), refs.begin(), refs.end());
+    ways.push_back(way);
+}
+
+void OsmGraphBuilder::finishWays() {
+    nodeIds = wayRefs;
+    std::sort(nodeIds.begin(), nodeIds.end());
+    nodeIds.erase(std::unique(nodeIds.begin(), nodeIds.end()), nodeIds.end());
+    nodeIds.shrink_to_fit();
+
+    latitudes.assign(nodeIds.size(), std::numeric_limits<double>::quiet_NaN());
+    longitudes.assign(nodeIds.size(), std::numeric_limits<double>::quiet_NaN());
+}
+
+bool OsmGraphBuilder::needsNode(int64_t id) const {
+    return std::binary_search(nodeIds.begin(), nodeIds.end(), id);
+}
+
+void OsmGraphBuilder::setNodeLocation(int64_t id, double latitude, double longitude) {
+    uint32_t index = findNode(id);
+    if (index != UINT32_MAX) {
+        latitudes[index] = latitude;
+        longitudes[index] = longitude;
+    }
+}
+
+uint32_t OsmGraphBuilder::findNode(int64_t id) const {
+    auto it = std::lower_bound(nodeIds.begin(), nodeIds.end(), id);
+    if (it == nodeIds.end() || *it != id) {
+        return UINT32_MAX;
+    }
+    return static_cast<uint32_t>(it - nodeIds.begin());
+}
+
+uint16_t OsmGraphBuilder::internHighway(std::string_view highway) {
+    for (size_t i = 0; i < highwayTypes.size(); ++i) {
+        if (highwayTypes[i] == highway) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+    highwayTypes.emplace_back(highway);
+    return static_cast<uint16_t>(highwayTypes.size() - 1);
+}
+
+bool OsmGraphBuilder::build(const Options& options) {
+    size_t nodeCount = nodeIds.size();
+    auto located = [this](uint32_t node) { return !std::isnan(latitudes[node]); };
+
+    // Directed segments between consecutive way nodes, both ways for two-way roads.
+    // Nodes missing from a clipped extract split their way.
+    std::vector<Segment> segments;
+    for (uint32_t wayIndex = 0; wayIndex < ways.size(); ++wayIndex) {
+        const Way& way = ways[wayIndex];
+        uint32_t previous = findNode(wayRefs[way.refBegin]);
+        for (uint32_t i = 1; i < way.refCount; ++i) {
+            uint32_t current = findNode(wayRefs[way.refBegin + i]);
+            if (previous != current && located(previous) && located(current)) {
+                if (way.reversed) {
+                    segments.push_back({current, previous, wayIndex});
+                } else {
+                    segments.push_back({previous, current, wayIndex});
+                }
+                if (!way.oneWay) {
+                    segments.push_back({segments.back().to, segments.back().from, wayIndex});
+                }
+            }
+            previous = current;
+        }
+    }
+
+    if (segments.empty()) {
+        std::cerr << "No drivable roads found" << std::endl;
+        return false;
+    }
+
+    // Outgoing and incoming segments per node, in way order
+    std::vector<uint32_t> outOffsets(nodeCount + 1, 0), inOffsets(nodeCount + 1, 0);
+    for (const Segment& segment : segments) {
+        ++outOffsets[segment.from + 1];
+        ++inOffsets[segment.to + 1];
+    }
+    std::partial_sum(outOffsets.begin(), outOffsets.end(), outOffsets.begin());
+    std::partial_sum(inOffsets.begin(), inOffsets.end(), inOffsets.begin());
+
+    std::vector<uint32_t> outSegments(segments.size()), inSegments(segments.size());
+    {
+        std::vector<uint32_t> outFill(outOffsets.begin(), outOffsets.end() - 1);
+        std::vector<uint32_t> inFill(inOffsets.begin(), inOffsets.end() - 1);
+        for (uint32_t i = 0; i < segments.size(); ++i) {
+            outSegments[outFill[segments[i].from]++] = i;
+            inSegments[inFill[segments[i].to]++] = i;
+        }
+    }
+
+    // osmnx keeps a node when it is a self loop, a source or sink, or does not
+    // just continue one street (two distinct neighbours, one or two ways through)
+    std::vector<bool> endpoints(nodeCount, false);
+    std::vector<uint32_t> neighbours;
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        uint32_t outDegree = outOffsets[node + 1] - outOffsets[node];
+        uint32_t inDegree = inOffsets[node + 1] - inOffsets[node];
+        if (outDegree + inDegree == 0) {
+            continue;
+        }
+
+        neighbours.clear();
+        for (uint32_t i = outOffsets[node]; i < outOffsets[node + 1]; ++i) {
+            neighbours.push_back(segments[outSegments[i]].to);
+        }
+        for (uint32_t i = inOffsets[node]; i < inOffsets[node + 1]; ++i) {
+            neighbours.push_back(segments[inSegments[i]].from);
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+        uint32_t degree = outDegree + inDegree;
+        bool selfLoop = std::binary_search(neighbours.begin(), neighbours.end(), node);
+        endpoints[node] = selfLoop || outDegree == 0 || inDegree == 0 ||
+                          !(neighbours.size() == 2 && (degree == 2 || degree == 4));
+    }
+
+    // Keep only the largest weakly connected component, like graph_from_place
+    std::vector<bool> kept(nodeCount, false);
+    {
+        DisjointSet components(nodeCount);
+        for (const Segment& segment : segments) {
+            components.unite(segment.from, segment.to);
+        }
+
+        std::vector<uint32_t> sizes(nodeCount, 0);
+        uint32_t largest = 0;
+        for (uint32_t node = 0; node < nodeCount; ++node) {
+            if (outOffsets[node + 1] != outOffsets[node] || inOffsets[node + 1] != inOffsets[node]) {
+                uint32_t root = components.find(node);
+                if (++sizes[root] > sizes[largest]) {
+                    largest = root;
+                }
+            }
+        }
+
+        for (uint32_t node = 0; node < nodeCount; ++node) {
+            bool inGraph = outOffsets[node + 1] != outOffsets[node] || inOffsets[node + 1] != inOffsets[node];
+            kept[node] = inGraph && endpoints[node] && (options.retainAll || components.find(node) == largest);
+        }
+    }
+
+    // Output nodes are the kept endpoints in OSM id order
+    std::vector<uint32_t> outputIndex(nodeCount, UINT32_MAX);
+    std::vector<uint32_t> outputNodes;
+    double minLatitude = std::numeric_limits<double>::max(), maxLatitude = -std::numeric_limits<double>::max();
+    double minLongitude = std::numeric_limits<double>::max(), maxLongitude = -std::numeric_limits<double>::max();
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        if (kept[node]) {
+            outputIndex[node] = static_cast<uint32_t>(outputNodes.size());
+            outputNodes.push_back(node);
+            minLatitude = std::min(minLatitude, latitudes[node]);
+            maxLatitude = std::max(maxLatitude, latitudes[node]);
+            minLongitude = std::min(minLongitude, longitudes[node]);
+            maxLongitude = std::max(maxLongitude, longitudes[node]);
+        }
+    }
+
+    if (outputNodes.empty()) {
+        std::cerr << "No road graph nodes left after simplification" << std::endl;
+        return false;
+    }
+
+    // Metric coordinates relative to the bounding box center, as in center_and_convert_coordinates
+    double centerLatitude = (minLatitude + maxLatitude) / 2;
+    double centerLongitude = (minLongitude + maxLongitude) / 2;
+    auto project = [&](uint32_t node) {
+        double latitude = latitudes[node];
+        double longitude = longitudes[node];
+        return glm::dvec2(
+            std::copysign(haversine(centerLatitude, centerLongitude, centerLatitude, longitude, earthRadiusMeters), longitude - centerLongitude),
+            std::copysign(haversine(centerLatitude, centerLongitude, latitude, centerLongitude, earthRadiusMeters), latitude - centerLatitude));
+    };
+
+    outputX.resize(outputNodes.size());
+    outputY.resize(outputNodes.size());
+    for (size_t i = 0; i < outputNodes.size(); ++i) {
+        glm::dvec2 position = project(outputNodes[i]);
+        outputX[i] = position.x;
+        outputY[i] = position.y;
+    }
+
+    // Walk from every endpoint through the simplified-away nodes to the next
+    // endpoint, keeping the nodes passed on the way as the road's shape
+    edges.clear();
+    shapePoints.clear();
+    std::vector<std::vector<uint32_t>> edgeWays;
+    for (uint32_t start : outputNodes) {
+        for (uint32_t i = outOffsets[start]; i < outOffsets[start + 1]; ++i) {
+            const Segment* segment = &segments[outSegments[i]];
+            uint32_t previous = start;
+            uint32_t current = segment->to;
+            double meters = haversine(latitudes[previous], longitudes[previous], latitudes[current], longitudes[current], edgeEarthRadiusMeters);
+            std::vector<uint32_t> pathWays = {segment->way};
+            size_t shapeBegin = shapePoints.size();
+
+            size_t steps = 0;
+            while (!endpoints[current] && steps++ < segments.size()) {
+                const Segment* next = nullptr;
+                for (uint32_t j = outOffsets[current]; j < outOffsets[current + 1]; ++j) {
+                    if (segments[outSegments[j]].to != previous) {
+                        next = &segments[outSegments[j]];
+                        break;
+                    }
+                }
+                if (!next) {
+                    break;
+                }
+
+                meters += haversine(latitudes[current], longitudes[current], latitudes[next->to], longitudes[next->to], edgeEarthRadiusMeters);
+                if (pathWays.back() != next->way) {
+                    pathWays.push_back(next->way);
+                }
+                shapePoints.push_back(project(current));
+                previous = current;
+                current = next->to;
+            }
+
+            if (!kept[current]) {
+                shapePoints.resize(shapeBegin);
+                continue;
+            }
+
+            uint32_t shapeCount = static_cast<uint32_t>(shapePoints.size() - shapeBegin);
+            edges.push_back({outputIndex[start], outputIndex[current], meters, 0, 0, ways[segment->way].oneWay,
+                             static_cast<uint32_t>(shapeBegin), shapeCount});
+            edgeWays.push_back(std::move(pathWays));
+        }
+    }
+
+    resolveAttributes(edgeWays);
+    return true;
+}
+
+void OsmGraphBuilder::resolveAttributes(const std::vector<std::vector<uint32_t>>& edgeWays) {
+    SpeedDefaults speedDefaults;
+    std::vector<int16_t> values;
+
+    for (size_t i = 0; i < edges.size(); ++i) {
+        Edge& edge = edges[i];
+        const std::vector<uint32_t>& pathWays = edgeWays[i];
+        uint16_t highway = ways[pathWays.front()].highway;
+
+        // Merged ways carry the distinct values of each tag, like osmnx's attribute lists
+        auto distinctValues = [&](int16_t Way::*field) {
+            values.clear();
+            for (uint32_t way : pathWays) {
+                int16_t value = ways[way].*field;
+                if (value != tagMissing && std::find(values.begin(), values.end(), value) == values.end()) {
+                    values.push_back(value);
+                }
+            }
+        };
+
+        distinctValues(&Way::maxSpeed);
+        double maxSpeed = -1;
+        if (values.size() == 1) {
+            maxSpeed = values[0] == tagInvalid ? -1 : values[0];
+        } else if (values.size() > 1) {
+            double sum = 0;
+            size_t count = 0;
+            for (int16_t value : values) {
+                if (value > 0) {
+                    sum += value;
+                    ++count;
+                }
+            }
+            maxSpeed = count > 0 ? sum / count : -1;
+        }
+
+        edge.maxSpeed = speedDefaults.resolve(highwayTypes[highway], maxSpeed);
+
+        distinctValues(&Way::lanes);
+        edge.lanes = 2;
+        if (!values.empty()) {
+            int lanes = 0;
+            for (int16_t value : values) {
+                lanes = std::max(lanes, value == tagInvalid ? 2 : static_cast<int>(value));
+            }
+            edge.lanes = lanes;
+        }
+    }
+}
+
+bool OsmGraphBuilder::writeText(const std::string& nodesFile, const std::string& edgesFile) const {
+    GraphTextWriter writer(nodesFile, edgesFile);
+    if (!writer.isOpen()) {
+        std::cerr << "Failed to create " << nodesFile << " or " << edgesFile << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < outputX.size(); ++i) {
+        writer.writeNode(i, outputX[i], outputY[i]);
+    }
+    std::vector<glm::dvec2> shape;
+    for (const Edge& edge : edges) {
+        shape.assign(shapePoints.begin() + edge.shapeBegin, shapePoints.begin() + edge.shapeBegin + edge.shapeCount);
+        writer.writeEdge(edge.from, edge.to, std::round(edge.meters * 1000.0) / 1000.0, edge.maxSpeed, edge.lanes, edge.oneWay, shape);
+    }
+
+    if (!writer.close()) {
+        std::cerr << "Failed to write " << nodesFile << " or " << edgesFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Same nodes and roads RoadGraph would load from the text files
+bool OsmGraphBuilder::writeGraph(const std::string& graphFile) const {
+    std::vector<Node> nodeValues;
+    nodeValues.reserve(outputX.size());
+    for (size_t i = 0; i < outputX.size(); ++i) {
+        nodeValues.emplace_back(glm::vec3(static_cast<float>(outputX[i]), static_cast<float>(outputY[i]), 0.0f));
+    }
+
+    std::vector<glm::vec2> shapeValues;
+    shapeValues.reserve(shapePoints.size());
+    for (const glm::dvec2& point : shapePoints) {
+        shapeValues.emplace_back(static_cast<float>(point.x), static_cast<float>(point.y));
+    }
+
+    std::vector<Road> roadValues;
+    roadValues.reserve(edges.size());
+    for (const Edge& edge : edges) {
+        float meters = static_cast<float>(std::round(edge.meters * 1000.0) / 1000.0);
+        roadValues.emplace_back(edge.from, edge.to, meters, static_cast<float>(edge.maxSpeed), edge.lanes, edge.shapeBegin, edge.shapeCount,
+                                !edge.oneWay);
+    }
+
+    // Edges of a two-way street come once per direction, as in osmnx
+    RoadGraph::mergeReciprocalRoads(roadValues, shapeValues);
+    RoadGraph graph(std::move(nodeValues), std::move(roadValues), std::move(shapeValues));
+    return GraphFile::write(graph, graphFile);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct OsmTag {
+    std::string_view key;
+    std::string_view value;
+};
+
+// Turns OSM ways and nodes into the road graph written by import/main.py.
+// Ways are filtered like osmnx's "drive" network, the node graph is simplified
+// down to intersections and dead ends the way osmnx does, only the largest
+// weakly connected component is kept, and maxspeed/lanes/oneway get the same
+// defaults as extract_and_save_graph_data.
+//
+// Feed it in two passes: all ways first, then finishWays(), then the
+// locations of the nodes it asks for. Memory grows with the drivable network,
+// not with the size of the extract.
+class OsmGraphBuilder {
+public:
+    struct Options {
+        bool retainAll = false;
+    };
+
+    struct Edge {
+        uint32_t from, to;
+        double meters;
+        int maxSpeed;
+        int lanes;
+        bool oneWay;
+        // Range in the shape points, the nodes simplified away between from and to
+        uint32_t shapeBegin;
+        uint32_t shapeCount;
+    };
+
+    void addWay(const std::vector<int64_t>& refs, const std::vector<OsmTag>& tags);
+    void finishWays();
+
+    bool needsNode(int64_t id) const;
+    void setNodeLocation(int64_t id, double latitude, double longitude);
+
+    bool build(const Options& options);
+    bool writeText(const std::string& nodesFile, const std::string& edgesFile) const;
+    bool writeGraph(const std::string& graphFile) const;
+
+    size_t getWayCount() const { return ways.size(); }
+    size_t getReferencedNodeCount() const { return nodeIds.size(); }
+    size_t getNodeCount() const { return outputX.size(); }
+    size_t getEdgeCount() const { return edges.size(); }
+    size_t getShapePointCount() const { return shapePoints.size(); }
+
+    static bool isDrivable(const std::vector<OsmTag>& tags);
+
+private:
+    static constexpr int16_t tagMissing = INT16_MIN;
+    static constexpr int16_t tagInvalid = -1;
+
+    struct Way {
+        uint64_t refBegin;
+        uint32_t refCount;
+        uint16_t highway;
+        int16_t maxSpeed;
+        int16_t lanes;
+        bool oneWay;
+        bool reversed;
+    };
+
+    struct Segment {
+        uint32_t from, to;
+        uint32_t way;
+    };
+
+    std::vector<Way> ways;
+    std::vector<int64_t> wayRefs;
+    std::vector<std::string> highwayTypes;
+
+    // Dense table of every node a kept way references, sorted by OSM id
+    std::vector<int64_t> nodeIds;
+    std::vector<double> latitudes;
+    std::vector<double> longitudes;
+
+    std::vector<double> outputX;
+    std::vector<double> outputY;
+    std::vector<Edge> edges;
+    std::vector<glm::dvec2> shapePoints;
+
+    uint16_t internHighway(std::string_view highway);
+    uint32_t findNode(int64_t id) const;
+    void resolveAttributes(const std::vector<std::vector<uint32_t>>& edgeWays);
+};
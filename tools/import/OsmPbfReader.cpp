@@ -0,0 +1,590 @@
+#include "OsmPbfReader.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string_view>
+#include <zlib.h>
+
+namespace {
+    // Limits from the PBF specification
+    const uint32_t maxBlobHeaderSize = 64 * 1024;
+    const uint32_t maxBlobSize = 32 * 1024 * 1024;
+
+    const uint8_t containsNodes = 1;
+    const uint8_t containsWays = 2;
+    const uint8_t containsRelations = 4;
+    const uint8_t contentsUnknown = 0xFF;
+
+    const std::string_view supportedFeatures[] = {"OsmSchema-V0.6", "DenseNodes"};
+
+    // Minimal protobuf wire format decoder over a byte range. Any malformed or
+    // out of range field marks the reader as failed and ends iteration.
+    class ProtobufReader {
+    public:
+        explicit ProtobufReader(std::string_view data): position(data.data()), end(data.data() + data.size()) {}
+
+        bool next() {
+            if (failed || position >= end) {
+                return false;
+            }
+            uint64_t key = decodeVarint();
+            field = static_cast<uint32_t>(key >> 3);
+            wireType = static_cast<uint32_t>(key & 7);
+            return !failed;
+        }
+
+        uint32_t getField() const { return field; }
+        bool hasFailed() const { return failed; }
+
+        uint64_t readVarint() {
+            if (wireType != 0) {
+                failed = true;
+                return 0;
+            }
+            return decodeVarint();
+        }
+
+        int64_t readSignedVarint() {
+            return decodeZigZag(readVarint());
+        }
+
+        std::string_view readBytes() {
+            if (wireType != 2) {
+                failed = true;
+                return std::string_view();
+            }
+            uint64_t length = decodeVarint();
+            if (failed || length > static_cast<uint64_t>(end - position)) {
+                failed = true;
+                return std::string_view();
+            }
+            std::string_view bytes(position, length);
+            position += length;
+            return bytes;
+        }
+
+        // Repeated varints, packed or one at a time
+        void readRepeated(std::vector<uint64_t>& values) {
+            if (wireType == 0) {
+                values.push_back(decodeVarint());
+                return;
+            }
+            ProtobufReader packed(readBytes());
+            while (!failed && !packed.failed && packed.position < packed.end) {
+                values.push_back(packed.decodeVarint());
+            }
+            failed = failed || packed.failed;
+        }
+
+        void skip() {
+            switch (wireType) {
+                case 0: decodeVarint(); break;
+                case 1: advance(8); break;
+                case 2: readBytes(); break;
+                case 5: advance(4); break;
+                default: failed = true; break;
+            }
+        }
+
+        static int64_t decodeZigZag(uint64_t value) {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+    private:
+        const char* position;
+        const char* end;
+        uint32_t field = 0;
+        uint32_t wireType = 0;
+        bool failed = false;
+
+        uint64_t decodeVarint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64 && position < end; shift += 7) {
+                uint8_t byte = static_cast<uint8_t>(*position++);
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+            failed = true;
+            return 0;
+        }
+
+        void advance(size_t count) {
+            if (count > static_cast<size_t>(end - position)) {
+                failed = true;
+                return;
+            }
+            position += count;
+        }
+    };
+
+    // Unpacks a Blob message. Raw blobs are used in place, zlib blobs are
+    // inflated into buffer; other compressions are not supported.
+    bool inflateBlob(std::string_view blob, std::string& buffer, std::string_view& payload) {
+        ProtobufReader reader(blob);
+        std::string_view raw, compressed;
+        bool hasRaw = false;
+        uint64_t rawSize = 0;
+        while (reader.next()) {
+            switch (reader.getField()) {
+                case 1: raw = reader.readBytes(); hasRaw = true; break;
+                case 2: rawSize = reader.readVarint(); break;
+                case 3: compressed = reader.readBytes(); break;
+                default: reader.skip(); break;
+            }
+        }
+        if (reader.hasFailed()) {
+            return false;
+        }
+
+        if (hasRaw) {
+            payload = raw;
+            return true;
+        }
+        if (compressed.empty() || rawSize > maxBlobSize) {
+            return false;
+        }
+
+        buffer.resize(rawSize);
+        uLongf length = static_cast<uLongf>(rawSize);
+        int result = uncompress(reinterpret_cast<Bytef*>(buffer.data()), &length,
+                                reinterpret_cast<const Bytef*>(compressed.data()), static_cast<uLong>(compressed.size()));
+        if (result != Z_OK || length != rawSize) {
+            return false;
+        }
+        payload = buffer;
+        return true;
+    }
+
+    // One decoded PrimitiveBlock. Strings and groups point into the payload,
+    // so the decoder must outlive any tag handed out from it.
+    class BlockDecoder {
+    public:
+        uint8_t getContents() const { return contents; }
+
+        bool load(std::string_view blob) {
+            strings.clear();
+            groups.clear();
+            granularity = 100;
+            latitudeOffset = 0;
+            longitudeOffset = 0;
+            contents = 0;
+
+            std::string_view payload;
+            if (!inflateBlob(blob, buffer, payload)) {
+                return false;
+            }
+
+            ProtobufReader reader(payload);
+            while (reader.next()) {
+                switch (reader.getField()) {
+                    case 1: {
+                        ProtobufReader table(reader.readBytes());
+                        while (table.next()) {
+                            if (table.getField() == 1) {
+                                strings.push_back(table.readBytes());
+                            } else {
+                                table.skip();
+                            }
+                        }
+                        if (table.hasFailed()) {
+                            return false;
+                        }
+                        break;
+                    }
+                    case 2: groups.push_back(reader.readBytes()); break;
+                    case 17: granularity = static_cast<int64_t>(reader.readVarint()); break;
+                    case 19: latitudeOffset = static_cast<int64_t>(reader.readVarint()); break;
+                    case 20: longitudeOffset = static_cast<int64_t>(reader.readVarint()); break;
+                    default: reader.skip(); break;
+                }
+            }
+            if (reader.hasFailed()) {
+                return false;
+            }
+
+            for (std::string_view group : groups) {
+                ProtobufReader groupReader(group);
+                while (groupReader.next()) {
+                    uint32_t field = groupReader.getField();
+                    if (field == 1 || field == 2) {
+                        contents |= containsNodes;
+                    } else if (field == 3) {
+                        contents |= containsWays;
+                    } else if (field == 4) {
+                        contents |= containsRelations;
+                    }
+                    groupReader.skip();
+                }
+                if (groupReader.hasFailed()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename Visit>
+        bool forEachNode(Visit&& visit) {
+            for (std::string_view group : groups) {
+                ProtobufReader groupReader(group);
+                while (groupReader.next()) {
+                    if (groupReader.getField() == 1) {
+                        if (!readNode(groupReader.readBytes(), visit)) {
+                            return false;
+                        }
+                    } else if (groupReader.getField() == 2) {
+                        if (!readDenseNodes(groupReader.readBytes(), visit)) {
+                            return false;
+                        }
+                    } else {
+                        groupReader.skip();
+                    }
+                }
+                if (groupReader.hasFailed()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename Visit>
+        bool forEachWay(Visit&& visit) {
+            for (std::string_view group : groups) {
+                ProtobufReader groupReader(group);
+                while (groupReader.next()) {
+                    if (groupReader.getField() != 3) {
+                        groupReader.skip();
+                    } else if (!readWay(groupReader.readBytes(), visit)) {
+                        return false;
+                    }
+                }
+                if (groupReader.hasFailed()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        std::string buffer;
+        std::vector<std::string_view> strings;
+        std::vector<std::string_view> groups;
+        int64_t granularity = 100;
+        int64_t latitudeOffset = 0;
+        int64_t longitudeOffset = 0;
+        uint8_t contents = 0;
+
+        std::vector<uint64_t> ids, latitudes, longitudes, keys, values, refs;
+        std::vector<int64_t> wayRefs;
+        std::vector<OsmTag> tags;
+
+        double toDegrees(int64_t value, int64_t offset) const {
+            return 1e-9 * static_cast<double>(offset + granularity * value);
+        }
+
+        template<typename Visit>
+        bool readNode(std::string_view message, Visit& visit) {
+            ProtobufReader reader(message);
+            int64_t id = 0, latitude = 0, longitude = 0;
+            while (reader.next()) {
+                switch (reader.getField()) {
+                    case 1: id = reader.readSignedVarint(); break;
+                    case 8: latitude = reader.readSignedVarint(); break;
+                    case 9: longitude = reader.readSignedVarint(); break;
+                    default: reader.skip(); break;
+                }
+            }
+            if (reader.hasFailed()) {
+                return false;
+            }
+            visit(id, toDegrees(latitude, latitudeOffset), toDegrees(longitude, longitudeOffset));
+            return true;
+        }
+
+        // Ids and coordinates are delta coded against the previous node
+        template<typename Visit>
+        bool readDenseNodes(std::string_view message, Visit& visit) {
+            ids.clear();
+            latitudes.clear();
+            longitudes.clear();
+
+            ProtobufReader reader(message);
+            while (reader.next()) {
+                switch (reader.getField()) {
+                    case 1: reader.readRepeated(ids); break;
+                    case 8: reader.readRepeated(latitudes); break;
+                    case 9: reader.readRepeated(longitudes); break;
+                    default: reader.skip(); break;
+                }
+            }
+            if (reader.hasFailed() || latitudes.size() != ids.size() || longitudes.size() != ids.size()) {
+                return false;
+            }
+
+            int64_t id = 0, latitude = 0, longitude = 0;
+            for (size_t i = 0; i < ids.size(); ++i) {
+                id += ProtobufReader::decodeZigZag(ids[i]);
+                latitude += ProtobufReader::decodeZigZag(latitudes[i]);
+                longitude += ProtobufReader::decodeZigZag(longitudes[i]);
+                visit(id, toDegrees(latitude, latitudeOffset), toDegrees(longitude, longitudeOffset));
+            }
+            return true;
+        }
+
+        template<typename Visit>
+        bool readWay(std::string_view message, Visit& visit) {
+            keys.clear();
+            values.clear();
+            refs.clear();
+
+            ProtobufReader reader(message);
+            int64_t id = 0;
+            while (reader.next()) {
+                switch (reader.getField()) {
+                    case 1: id = static_cast<int64_t>(reader.readVarint()); break;
+                    case 2: reader.readRepeated(keys); break;
+                    case 3: reader.readRepeated(values); break;
+                    case 8: reader.readRepeated(refs); break;
+                    default: reader.skip(); break;
+                }
+            }
+            if (reader.hasFailed() || keys.size() != values.size()) {
+                return false;
+            }
+
+            tags.clear();
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (keys[i] >= strings.size() || values[i] >= strings.size()) {
+                    return false;
+                }
+                tags.push_back({strings[keys[i]], strings[values[i]]});
+            }
+
+            wayRefs.clear();
+            int64_t ref = 0;
+            for (uint64_t delta : refs) {
+                ref += ProtobufReader::decodeZigZag(delta);
+                wayRefs.push_back(ref);
+            }
+
+            visit(id, wayRefs, tags);
+            return true;
+        }
+    };
+
+    // Ways that passed the filter, copied out of their block so the block
+    // buffer can be reused while they wait to be handed over in file order
+    struct WayBatch {
+        std::vector<int64_t> ids;
+        std::vector<size_t> refOffsets;
+        std::vector<int64_t> refs;
+        std::vector<size_t> tagOffsets;
+        std::vector<std::string> tagStrings;
+        uint8_t contents = 0;
+        bool failed = false;
+
+        void clear() {
+            ids.clear();
+            refOffsets.assign(1, 0);
+            refs.clear();
+            tagOffsets.assign(1, 0);
+            tagStrings.clear();
+            contents = 0;
+            failed = false;
+        }
+    };
+
+    uint32_t readBigEndian(const char* data) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+    }
+}
+
+/* CONSTRUCTORS */
+OsmPbfReader::OsmPbfReader(const std::string& filename): file(filename) {
+    if (!file.isOpen()) {
+        return;
+    }
+
+    // Locate every blob up front: a 4 byte header length, a BlobHeader and the blob
+    const char* data = file.getData();
+    uint64_t size = file.getSize();
+    uint64_t offset = 0;
+    while (offset < size) {
+        uint32_t headerSize = size - offset >= 4 ? readBigEndian(data + offset) : UINT32_MAX;
+        offset += 4;
+        if (headerSize > maxBlobHeaderSize || headerSize > size - std::min(offset, size)) {
+            std::cerr << "Corrupt PBF blob header at byte " << offset - 4 << " in " << filename << std::endl;
+            return;
+        }
+
+        ProtobufReader header(std::string_view(data + offset, headerSize));
+        std::string_view type;
+        uint64_t blobSize = 0;
+        while (header.next()) {
+            switch (header.getField()) {
+                case 1: type = header.readBytes(); break;
+                case 3: blobSize = header.readVarint(); break;
+                default: header.skip(); break;
+            }
+        }
+        offset += headerSize;
+        if (header.hasFailed() || blobSize > maxBlobSize || blobSize > size - offset) {
+            std::cerr << "Corrupt PBF blob header at byte " << offset - headerSize - 4 << " in " << filename << std::endl;
+            return;
+        }
+
+        if (type == "OSMHeader") {
+            if (!readHeader(data + offset, blobSize)) {
+                std::cerr << "Unsupported PBF header in " << filename << std::endl;
+                return;
+            }
+        } else if (type == "OSMData") {
+            blobs.push_back({offset, static_cast<uint32_t>(blobSize), contentsUnknown});
+        }
+        offset += blobSize;
+    }
+
+    file.adviseSequential();
+    valid = true;
+}
+
+
+/* METHODS */
+bool OsmPbfReader::readHeader(const char* data, size_t size) {
+    std::string buffer;
+    std::string_view payload;
+    if (!inflateBlob(std::string_view(data, size), buffer, payload)) {
+        return false;
+    }
+
+    ProtobufReader reader(payload);
+    while (reader.next()) {
+        if (reader.getField() == 4) {
+            std::string_view feature = reader.readBytes();
+            if (std::find(std::begin(supportedFeatures), std::end(supportedFeatures), feature) == std::end(supportedFeatures)) {
+                std::cerr << "PBF extract requires unsupported feature " << feature << std::endl;
+                return false;
+            }
+        } else if (reader.getField() == 5) {
+            if (reader.readBytes() == "Sort.Type_then_ID") {
+                sortedByTypeThenId = true;
+            }
+        } else {
+            reader.skip();
+        }
+    }
+    return !reader.hasFailed();
+}
+
+bool OsmPbfReader::readNodes(const NodeCallback& onNode) {
+    // In sorted extracts nothing after the first blob without nodes holds any
+    std::atomic<size_t> lastNodeBlob(blobs.size());
+    std::atomic<size_t> failures(0);
+
+    parallelFor(blobs.size(), [&](size_t index) {
+        Blob& blob = blobs[index];
+        if (index > lastNodeBlob || !(blob.contents & containsNodes)) {
+            return;
+        }
+
+        BlockDecoder decoder;
+        bool decoded = decoder.load(std::string_view(file.getData() + blob.offset, blob.size)) &&
+                       decoder.forEachNode([&onNode](int64_t id, double latitude, double longitude) {
+                           onNode(id, latitude, longitude);
+                       });
+        if (!decoded) {
+            ++failures;
+            return;
+        }
+
+        blob.contents = decoder.getContents();
+        if (sortedByTypeThenId && !(blob.contents & containsNodes)) {
+            size_t current = lastNodeBlob;
+            while (index < current && !lastNodeBlob.compare_exchange_weak(current, index)) {}
+        }
+    });
+
+    if (failures > 0) {
+        std::cerr << "Failed to decode " << failures << " PBF blob(s)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool OsmPbfReader::readWays(const WayCallback& onWay, const WayFilter& filter) {
+    // Blobs are decoded a round at a time so ways can be handed over in file order
+    size_t roundSize = getWorkerCount() * 2;
+    std::vector<WayBatch> batches(roundSize);
+    std::vector<size_t> round;
+    std::vector<int64_t> refs;
+    std::vector<OsmTag> tags;
+    size_t failures = 0;
+    bool finished = false;
+
+    for (size_t next = 0; next < blobs.size() && !finished;) {
+        round.clear();
+        for (; next < blobs.size() && round.size() < roundSize; ++next) {
+            if (blobs[next].contents & containsWays) {
+                round.push_back(next);
+            }
+        }
+
+        parallelFor(round.size(), [&](size_t i) {
+            const Blob& blob = blobs[round[i]];
+            WayBatch& batch = batches[i];
+            batch.clear();
+
+            BlockDecoder decoder;
+            if (!decoder.load(std::string_view(file.getData() + blob.offset, blob.size))) {
+                batch.failed = true;
+                return;
+            }
+            batch.contents = decoder.getContents();
+            batch.failed = !decoder.forEachWay([&](int64_t id, const std::vector<int64_t>& wayRefs, const std::vector<OsmTag>& wayTags) {
+                if (filter && !filter(wayTags)) {
+                    return;
+                }
+                batch.ids.push_back(id);
+                batch.refs.insert(batch.refs.end(), wayRefs.begin(), wayRefs.end());
+                batch.refOffsets.push_back(batch.refs.size());
+                for (const OsmTag& tag : wayTags) {
+                    batch.tagStrings.emplace_back(tag.key);
+                    batch.tagStrings.emplace_back(tag.value);
+                }
+                batch.tagOffsets.push_back(batch.tagStrings.size());
+            });
+        });
+
+        for (size_t i = 0; i < round.size(); ++i) {
+            WayBatch& batch = batches[i];
+            if (batch.failed) {
+                ++failures;
+                continue;
+            }
+            blobs[round[i]].contents = batch.contents;
+
+            for (size_t way = 0; way < batch.ids.size(); ++way) {
+                refs.assign(batch.refs.begin() + batch.refOffsets[way], batch.refs.begin() + batch.refOffsets[way + 1]);
+                tags.clear();
+                for (size_t tag = batch.tagOffsets[way]; tag < batch.tagOffsets[way + 1]; tag += 2) {
+                    tags.push_back({batch.tagStrings[tag], batch.tagStrings[tag + 1]});
+                }
+                onWay(batch.ids[way], refs, tags);
+            }
+
+            // Relations come last in sorted extracts
+            if (sortedByTypeThenId && (batch.contents & containsRelations)) {
+                finished = true;
+            }
+        }
+    }
+
+    if (failures > 0) {
+        std::cerr << "Failed to decode " << failures << " PBF blob(s)" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "OsmGraphBuilder.h"
+
+// Reader for .osm.pbf extracts. The file is memory-mapped, its blobs are
+// located up front and then inflated and decoded in parallel, each worker
+// holding only the blob it is working on.
+class OsmPbfReader {
+public:
+    // Called from several worker threads at once
+    using NodeCallback = std::function<void(int64_t id, double latitude, double longitude)>;
+    // Runs on the worker threads, so rejected ways are never copied
+    using WayFilter = std::function<bool(const std::vector<OsmTag>& tags)>;
+    // Called on the calling thread, in file order
+    using WayCallback = std::function<void(int64_t id, const std::vector<int64_t>& refs, const std::vector<OsmTag>& tags)>;
+
+    explicit OsmPbfReader(const std::string& filename);
+
+    bool isOpen() const { return valid; }
+    size_t getSize() const { return file.getSize(); }
+    size_t getBlobCount() const { return blobs.size(); }
+
+    // Each call is one pass over the file; false if a blob could not be decoded
+    bool readNodes(const NodeCallback& onNode);
+    bool readWays(const WayCallback& onWay, const WayFilter& filter = nullptr);
+
+private:
+    struct Blob {
+        uint64_t offset;
+        uint32_t size;
+        // Entity kinds seen in the blob, all bits set until it is first decoded
+        uint8_t contents;
+    };
+
+    MappedFile file;
+    std::vector<Blob> blobs;
+    bool sortedByTypeThenId = false;
+    bool valid = false;
+
+    bool readHeader(const char* data, size_t size);
+};
@@ -0,0 +1,249 @@
+#include "OsmXmlReader.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+    bool isNameCharacter(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+               c == '_' || c == ':' || c == '-' || c == '.';
+    }
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    const char* skipPast(const char* position, const char* end, std::string_view terminator) {
+        std::string_view rest(position, end - position);
+        size_t found = rest.find(terminator);
+        return found == std::string_view::npos ? end : position + found + terminator.size();
+    }
+
+    template<typename T>
+    bool parseNumber(std::string_view text, T& value) {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc();
+    }
+
+    void appendUtf8(std::string& output, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            output.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            output.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            output.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            output.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+}
+
+/* CONSTRUCTORS */
+OsmXmlReader::OsmXmlReader(const std::string& filename): file(filename) {
+    file.adviseSequential();
+}
+
+
+/* METHODS */
+// Extracts are expected in the standard order (nodes, then ways, then
+// relations), so each pass stops as soon as it has seen everything it needs.
+void OsmXmlReader::readNodes(const NodeCallback& onNode) {
+    scan([&](std::string_view name, bool isEnd, bool) {
+        if (isEnd) {
+            return true;
+        }
+        if (name == "node") {
+            int64_t id;
+            double latitude, longitude;
+            if (parseNumber(findAttribute("id"), id) &&
+                parseNumber(findAttribute("lat"), latitude) &&
+                parseNumber(findAttribute("lon"), longitude)) {
+                onNode(id, latitude, longitude);
+            }
+            return true;
+        }
+        return name != "way" && name != "relation";
+    });
+}
+
+void OsmXmlReader::readWays(const WayCallback& onWay) {
+    bool inWay = false;
+    int64_t wayId = 0;
+    std::vector<int64_t> refs;
+    std::vector<OsmTag> tags;
+
+    scan([&](std::string_view name, bool isEnd, bool isSelfClosing) {
+        if (name == "way") {
+            if (!isEnd) {
+                inWay = true;
+                refs.clear();
+                tags.clear();
+                decodedValues.clear();
+                parseNumber(findAttribute("id"), wayId);
+            }
+            if ((isEnd || isSelfClosing) && inWay) {
+                onWay(wayId, refs, tags);
+                inWay = false;
+            }
+            return true;
+        }
+
+        if (isEnd || !inWay) {
+            return name != "relation";
+        }
+
+        if (name == "nd") {
+            int64_t ref;
+            if (parseNumber(findAttribute("ref"), ref)) {
+                refs.push_back(ref);
+            }
+        } else if (name == "tag") {
+            tags.push_back({decode(findAttribute("k")), decode(findAttribute("v"))});
+        }
+        return true;
+    });
+}
+
+template<typename Handler>
+void OsmXmlReader::scan(Handler&& handler) {
+    const char* position = file.getData();
+    const char* end = position + file.getSize();
+
+    while (position < end) {
+        const char* open = static_cast<const char*>(std::memchr(position, '<', end - position));
+        if (!open || open + 1 >= end) {
+            return;
+        }
+        position = open + 1;
+
+        // Declarations, comments and CDATA carry nothing we need
+        if (*position == '?') {
+            position = skipPast(position, end, "?>");
+            continue;
+        }
+        if (*position == '!') {
+            std::string_view rest(position, end - position);
+            if (rest.compare(0, 3, "!--") == 0) {
+                position = skipPast(position, end, "-->");
+            } else if (rest.compare(0, 8, "![CDATA[") == 0) {
+                position = skipPast(position, end, "]]>");
+            } else {
+                position = skipPast(position, end, ">");
+            }
+            continue;
+        }
+
+        bool isEnd = *position == '/';
+        if (isEnd) {
+            ++position;
+        }
+
+        const char* nameBegin = position;
+        while (position < end && isNameCharacter(*position)) {
+            ++position;
+        }
+        std::string_view name(nameBegin, position - nameBegin);
+
+        attributes.clear();
+        bool isSelfClosing = false;
+        while (position < end) {
+            while (position < end && isSpace(*position)) {
+                ++position;
+            }
+            if (position >= end) {
+                return;
+            }
+            if (*position == '>') {
+                ++position;
+                break;
+            }
+            if (*position == '/') {
+                isSelfClosing = true;
+                ++position;
+                continue;
+            }
+
+            const char* attributeBegin = position;
+            while (position < end && isNameCharacter(*position)) {
+                ++position;
+            }
+            std::string_view attributeName(attributeBegin, position - attributeBegin);
+
+            while (position < end && (isSpace(*position) || *position == '=')) {
+                ++position;
+            }
+            if (position >= end || (*position != '"' && *position != '\'')) {
+                // Malformed attribute, resynchronise at the end of the tag
+                position = skipPast(position, end, ">");
+                break;
+            }
+
+            char quote = *position++;
+            const char* valueEnd = static_cast<const char*>(std::memchr(position, quote, end - position));
+            if (!valueEnd) {
+                return;
+            }
+            attributes.push_back({attributeName, std::string_view(position, valueEnd - position)});
+            position = valueEnd + 1;
+        }
+
+        if (!handler(name, isEnd, isSelfClosing)) {
+            return;
+        }
+    }
+}
+
+std::string_view OsmXmlReader::decode(std::string_view value) {
+    if (value.find('&') == std::string_view::npos) {
+        return value;
+    }
+
+    // deque keeps earlier strings in place, so views handed out stay valid
+    std::string& decoded = decodedValues.emplace_back();
+    decoded.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        size_t semicolon = value[i] == '&' ? value.find(';', i) : std::string_view::npos;
+        if (semicolon == std::string_view::npos) {
+            decoded.push_back(value[i]);
+            continue;
+        }
+
+        std::string_view entity = value.substr(i + 1, semicolon - i - 1);
+        uint32_t codePoint = 0;
+        if (entity == "amp") {
+            decoded.push_back('&');
+        } else if (entity == "lt") {
+            decoded.push_back('<');
+        } else if (entity == "gt") {
+            decoded.push_back('>');
+        } else if (entity == "quot") {
+            decoded.push_back('"');
+        } else if (entity == "apos") {
+            decoded.push_back('\'');
+        } else if (entity.size() > 2 && entity[0] == '#' && (entity[1] == 'x' || entity[1] == 'X') &&
+                   std::from_chars(entity.data() + 2, entity.data() + entity.size(), codePoint, 16).ec == std::errc()) {
+            appendUtf8(decoded, codePoint);
+        } else if (entity.size() > 1 && entity[0] == '#' &&
+                   std::from_chars(entity.data() + 1, entity.data() + entity.size(), codePoint).ec == std::errc()) {
+            appendUtf8(decoded, codePoint);
+        } else {
+            decoded.append(value.substr(i, semicolon - i + 1));
+        }
+        i = semicolon;
+    }
+    return decoded;
+}
+
+std::string_view OsmXmlReader::findAttribute(std::string_view name) const {
+    for (const Attribute& attribute : attributes) {
+        if (attribute.name == name) {
+            return attribute.value;
+        }
+    }
+    return std::string_view();
+}
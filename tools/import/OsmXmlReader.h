@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "OsmGraphBuilder.h"
+
+// Streaming reader for .osm XML extracts. The file is memory-mapped and
+// scanned element by element without building a document tree; only the
+// current way's node references and tags are held in memory.
+class OsmXmlReader {
+public:
+    using NodeCallback = std::function<void(int64_t id, double latitude, double longitude)>;
+    using WayCallback = std::function<void(int64_t id, const std::vector<int64_t>& refs, const std::vector<OsmTag>& tags)>;
+
+    explicit OsmXmlReader(const std::string& filename);
+
+    bool isOpen() const { return file.isOpen(); }
+    size_t getSize() const { return file.getSize(); }
+
+    // Each call is one pass over the file
+    void readNodes(const NodeCallback& onNode);
+    void readWays(const WayCallback& onWay);
+
+private:
+    struct Attribute {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    MappedFile file;
+    std::vector<Attribute> attributes;
+    std::deque<std::string> decodedValues;
+
+    template<typename Handler>
+    void scan(Handler&& handler);
+
+    std::string_view decode(std::string_view value);
+    std::string_view findAttribute(std::string_view name) const;
+};
@@ -0,0 +1,74 @@
+#include "RoadDefaults.h"
+#include <charconv>
+#include <cmath>
+
+namespace {
+    const double pi = 3.14159265358979323846;
+}
+
+double haversine(double latitude1, double longitude1, double latitude2, double longitude2, double radius) {
+    const double degreesToRadians = pi / 180.0;
+    latitude1 *= degreesToRadians;
+    longitude1 *= degreesToRadians;
+    latitude2 *= degreesToRadians;
+    longitude2 *= degreesToRadians;
+
+    double dlatitude = latitude2 - latitude1;
+    double dlongitude = longitude2 - longitude1;
+    double a = std::sin(dlatitude / 2) * std::sin(dlatitude / 2) +
+               std::cos(latitude1) * std::cos(latitude2) * std::sin(dlongitude / 2) * std::sin(dlongitude / 2);
+    return radius * 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+}
+
+glm::dvec2 toMetricCoordinates(double longitude, double latitude, double centerLongitude, double centerLatitude) {
+    longitude -= centerLongitude;
+    latitude -= centerLatitude;
+    return glm::dvec2(
+        std::copysign(haversine(centerLatitude, centerLongitude, centerLatitude, longitude + centerLongitude, earthRadiusMeters), longitude),
+        std::copysign(haversine(centerLatitude, centerLongitude, latitude + centerLatitude, centerLongitude, earthRadiusMeters), latitude));
+}
+
+int roundSpeed(double speed) {
+    return static_cast<int>(std::nearbyint(speed / 10.0)) * 10;
+}
+
+int estimateSpeed(std::string_view highway) {
+    if (highway == "motorway") {
+        return 120;
+    } else if (highway == "trunk" || highway == "primary") {
+        return 90;
+    } else if (highway == "secondary" || highway == "tertiary") {
+        return 50;
+    } else if (highway == "residential") {
+        return 30;
+    }
+    return 40;
+}
+
+bool parseInteger(std::string_view text, int& value) {
+    size_t begin = text.find_first_not_of(" \t");
+    size_t end = text.find_last_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return false;
+    }
+    if (text[begin] == '+') {
+        ++begin;
+    }
+    const char* first = text.data() + begin;
+    const char* last = text.data() + end + 1;
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+/* METHODS */
+int SpeedDefaults::resolve(const std::string& highway, double maxSpeed) {
+    auto& average = averages[highway];
+    if (maxSpeed < 0) {
+        maxSpeed = average.second > 0 ? roundSpeed(average.first / average.second) : estimateSpeed(highway);
+    }
+
+    int speed = roundSpeed(maxSpeed);
+    average.first += speed;
+    average.second += 1;
+    return speed;
+}
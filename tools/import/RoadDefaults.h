@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <glm/glm.hpp>
+
+// Conventions shared by the importers so they reproduce the output of
+// extract_and_save_graph_data in import/graph_utils.py
+
+// import/graph_utils.py uses this radius for the metric node coordinates,
+// osmnx uses the second one for edge lengths
+constexpr double earthRadiusMeters = 6371000.0;
+constexpr double edgeEarthRadiusMeters = 6371009.0;
+
+double haversine(double latitude1, double longitude1, double latitude2, double longitude2, double radius);
+
+// Metric position relative to the bounding box center, as in center_and_convert_coordinates
+glm::dvec2 toMetricCoordinates(double longitude, double latitude, double centerLongitude, double centerLatitude);
+
+// Python's round() rounds halves to even, as does nearbyint in the default mode
+int roundSpeed(double speed);
+int estimateSpeed(std::string_view highway);
+
+// Same as Python's int(): surrounding whitespace allowed, nothing else
+bool parseInteger(std::string_view text, int& value);
+
+// Running mean of the speeds already assigned per highway type. Roads without
+// a usable maxspeed get the mean so far, or the estimate for their type.
+class SpeedDefaults {
+public:
+    // maxSpeed is negative when the road has none
+    int resolve(const std::string& highway, double maxSpeed);
+
+private:
+    std::unordered_map<std::string, std::pair<double, size_t>> averages;
+};